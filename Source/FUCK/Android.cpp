@@ -7,6 +7,8 @@
 #include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "PlayerCharacter.h"
+#include "Data/CombatantArchetype.h"
+#include "Profiling/CombatStats.h"
 
 AAndroid::AAndroid()
 {
@@ -27,6 +29,40 @@ void AAndroid::Tick(float DeltaTime)
 }
 
 
+void AAndroid::ApplyArchetypeAssets()
+{
+	Super::ApplyArchetypeAssets();
+
+	if (Archetype)
+	{
+		UCombatantArchetype::Resolve(Archetype->LongAttackAnimations, LongAttackAnimations);
+	}
+}
+
+void AAndroid::ReleaseArchetypeAssets()
+{
+	if (Archetype && Archetype->LongAttackAnimations.Num() > 0)
+	{
+		LongAttackAnimations.Empty();
+	}
+
+	Super::ReleaseArchetypeAssets();
+}
+
+void AAndroid::GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	Super::GatherCombatMontages(OutMontages);
+	OutMontages.Append(LongAttackAnimations);
+}
+
+#if WITH_EDITORONLY_DATA
+void AAndroid::VisitLegacyMontages(FLegacyMontageVisitor Visit)
+{
+	Super::VisitLegacyMontages(Visit);
+	Visit(LongAttackAnimations_DEPRECATED, LongAttackAnimations, GET_MEMBER_NAME_CHECKED(UCombatantArchetype, LongAttackAnimations));
+}
+#endif
+
 void AAndroid::StateChaseClose()
 {
 	float Distance = FVector::Distance(GetActorLocation(), Target->GetActorLocation());
@@ -44,12 +80,16 @@ void AAndroid::StateChaseClose()
 			Attack(false);
 			return;
 		}
-		else if (UGameplayStatics::GetTimeSeconds(GetWorld()) >= LongAttack_Timestamp + LongAttack_Cooldown && AIController->LineOfSightTo(Target))
+		else if (UGameplayStatics::GetTimeSeconds(GetWorld()) >= LongAttack_Timestamp + LongAttack_Cooldown && CanSeeTarget())
 		{
 			LongAttack_Timestamp = UGameplayStatics::GetTimeSeconds(GetWorld());
 			LongAttack(true);
 			return;
 		}
+		else if (TryCastSkill())
+		{
+			return;
+		}
 	}
 	if (!AIController->IsFollowingAPath())
 	{
@@ -59,6 +99,11 @@ void AAndroid::StateChaseClose()
 
 void AAndroid::LongAttack(bool Rotate)
 {
+	if (!AreCombatAssetsReady() || LongAttackAnimations.Num() == 0)
+	{
+		return;
+	}
+
 	Super::Attack();
 
 	SetMovingBackwards(false);
@@ -90,9 +135,12 @@ void AAndroid::MoveForward()
 
 void AAndroid::StateAttack()
 {
+	COM_SCOPE(STAT_COM_AttackOverlaps);
+
 	if (AttackDamaging)
 	{
 		TSet<AActor*> OverlappingActors;
+		INC_DWORD_STAT(STAT_COM_OverlapQueries);
 		Weapons->GetOverlappingActors(OverlappingActors);
 
 		for (AActor* OtherActor : OverlappingActors)
@@ -101,7 +149,7 @@ void AAndroid::StateAttack()
 			{
 				continue;
 			}
-			if (!AttackHitActors.Contains(OtherActor))
+			if (!HasAttackHit(OtherActor))
 			{
 				float AppliedDamage = UGameplayStatics::ApplyDamage(OtherActor, ClassDamage, GetController(), this, UDamageType::StaticClass());
 
@@ -112,7 +160,7 @@ void AAndroid::StateAttack()
 				}
 				if (AppliedDamage > 0.0f)
 				{
-					AttackHitActors.Add(OtherActor);
+					RegisterAttackHit(OtherActor);
 				}
 			}
 		}
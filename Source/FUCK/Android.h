@@ -20,12 +20,20 @@ public:
 
 	virtual void Tick(float DeltaTime) override;
 
-	UPROPERTY(EditAnywhere, Category = "Animations")
+	UPROPERTY(Transient)
 	TArray<UAnimMontage*> LongAttackAnimations;
 	FORCEINLINE class UStaticMeshComponent* GetWeapon() const { return Weapons; }
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Combat")
 	UStaticMeshComponent* Weapons;
+
+	virtual void ApplyArchetypeAssets() override;
+	virtual void ReleaseArchetypeAssets() override;
+	virtual void GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const override;
+
+#if WITH_EDITORONLY_DATA
+	virtual void VisitLegacyMontages(FLegacyMontageVisitor Visit) override;
+#endif
 protected:
 
 	void StateChaseClose();
@@ -40,4 +48,9 @@ private:
 	float LongAttack_ForwardSpeed;
 
 	void StateAttack();
+
+#if WITH_EDITORONLY_DATA
+	UPROPERTY()
+	TArray<UAnimMontage*> LongAttackAnimations_DEPRECATED;
+#endif
 };
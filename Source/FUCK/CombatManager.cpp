@@ -1,6 +1,8 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "CombatManager.h"
+#include "Profiling/CombatStats.h"
+#include "Profiling/CombatTrace.h"
 
 // Sets default values for this component's properties
 UCombatManager::UCombatManager()
@@ -16,7 +18,10 @@ UCombatManager::UCombatManager()
 // Called when the game starts
 void UCombatManager::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(CityOfMyths_Combat);
+
 	Super::BeginPlay();
+	Random.Init(this);
 	GetWorld()->GetTimerManager().SetTimer(attackCDHandle, this, &UCombatManager::NextAttacker, attackCooldown, true);
 }
 
@@ -40,8 +45,9 @@ void UCombatManager::NextAttacker()
 {
 	if (owner->NearbyEnemies.Num() > 0)
 	{
-		AEnemyBase* _enemyRef = Cast<AEnemyBase>(owner->NearbyEnemies[FMath::RandRange(0, owner->NearbyEnemies.Num() - 1)]);
+		AEnemyBase* _enemyRef = Cast<AEnemyBase>(owner->NearbyEnemies[Random.RandRange(0, owner->NearbyEnemies.Num() - 1)]);
 		_enemyRef->isAttackTurn = true;
+		FCombatTrace::LogAttackTurn(_enemyRef);
 		//GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, tempRef->GetName());
 	}
 }
@@ -38,6 +38,9 @@ public:
 
 	void NextAttacker();
 
+	// picks the next attacker
+	FCombatRandomStream Random;
+
 
 protected:
 	// Called when the game starts
@@ -1,5 +1,12 @@
 #include "Combatant.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "Combat/StatusEffectSubsystem.h"
+#include "Animation/AnimInstance.h"
+#include "SkillsComponent.h"
+#include "Data/CombatantArchetype.h"
+#include "Profiling/CombatStats.h"
+#include "Profiling/CombatTrace.h"
+#include "FUCK.h"
 
 // Sets default values
 ACombatant::ACombatant(const FObjectInitializer& ObjectInitializer)
@@ -18,13 +25,58 @@ ACombatant::ACombatant(const FObjectInitializer& ObjectInitializer)
 	Stumbling = false;
 	RotationSmoothing = 5.0f;
 	LastRotationSpeed = 0.0f;
+	Archetype = nullptr;
+
+	Attributes = CreateDefaultSubobject<UAttributeComponent>(TEXT("Attributes"));
 }
 
 // Called when the game starts or when spawned
 void ACombatant::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(CityOfMyths_Combat);
+
 	Super::BeginPlay();
 
+	FCombatTrace::NameActor(this);
+	Random.Init(this);
+
+#if WITH_EDITORONLY_DATA
+	// Blueprints not migrated yet keep playing in the editor; cooked builds never carry these
+	VisitLegacyMontages([](TArray<UAnimMontage*>& Legacy, TArray<UAnimMontage*>& Runtime, FName)
+	{
+		if (Runtime.IsEmpty())
+		{
+			Runtime = Legacy;
+		}
+	});
+#endif
+
+	Attributes->InitBase(ECombatAttribute::MaxHealth, MaxHealth);
+	Attributes->InitBase(ECombatAttribute::Damage, ClassDamage);
+	Attributes->OnAttributeChanged.AddUObject(this, &ACombatant::OnAttributeChanged);
+}
+
+void ACombatant::OnAttributeChanged(ECombatAttribute Attribute, float Value)
+{
+	switch (Attribute)
+	{
+	case ECombatAttribute::MaxHealth:
+		MaxHealth = Value;
+		MaxHealthChanged.Broadcast(MaxHealth);
+
+		if (CurrentHealth > MaxHealth)
+		{
+			SetHealth(MaxHealth);
+		}
+		break;
+
+	case ECombatAttribute::Damage:
+		ClassDamage = Value;
+		break;
+
+	default:
+		break;
+	}
 }
 
 // Called every frame
@@ -60,12 +112,141 @@ void ACombatant::SetHealth(float health)
 	HealthChanged.Broadcast(CurrentHealth);
 }
 
+void ACombatant::ApplyHealthDelta(float Delta, AActor* Instigator)
+{
+	SetHealth(CurrentHealth + Delta);
+}
+
+void ACombatant::SerializeSaveState(FArchive& Ar, int32 Version)
+{
+	// Max health and damage are rebuilt by the attribute bases and modifiers (level, effects),
+	// so a temporary modifier never ends up baked into a save
+	if (Version < 2)
+	{
+		float SavedMaxHealth = 0.0f;
+		float SavedClassDamage = 0.0f;
+		Ar << SavedMaxHealth;
+		Ar << CurrentHealth;
+		Ar << SavedClassDamage;
+	}
+	else
+	{
+		Ar << CurrentHealth;
+	}
+
+	if (Ar.IsLoading())
+	{
+		CurrentHealth = FMath::Min(CurrentHealth, MaxHealth);
+		HealthChanged.Broadcast(CurrentHealth);
+	}
+}
+
+bool ACombatant::HasSaveState() const
+{
+	return CurrentHealth < MaxHealth;
+}
+
+void ACombatant::ResetCombatState()
+{
+	// the shared flag reset only, subclasses play their death on top of it
+	ACombatant::Death();
+	// Death stops facing the target, a reset combatant fights again
+	RotateTowardsTarget = true;
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.0f);
+	}
+
+	if (USkillsComponent* Skills = FindComponentByClass<USkillsComponent>())
+	{
+		Skills->ResetSkills();
+	}
+
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->SetMovementMode(MOVE_Walking);
+}
+
+void ACombatant::ApplyArchetypeAssets()
+{
+	if (!Archetype)
+	{
+		return;
+	}
+
+	// Lists the archetype leaves empty or that failed to stream in stay as they are
+	UCombatantArchetype::Resolve(Archetype->AttackAnimations, AttackAnimations);
+	UCombatantArchetype::Resolve(Archetype->TakeHitAnimations, TakeHit_StumbleBackwards);
+	UCombatantArchetype::Resolve(Archetype->DeathAnimations, DeathAnimations);
+}
+
+#if WITH_EDITORONLY_DATA
+void ACombatant::VisitLegacyMontages(FLegacyMontageVisitor Visit)
+{
+	Visit(AttackAnimations_DEPRECATED, AttackAnimations, GET_MEMBER_NAME_CHECKED(UCombatantArchetype, AttackAnimations));
+	Visit(TakeHit_StumbleBackwards_DEPRECATED, TakeHit_StumbleBackwards, GET_MEMBER_NAME_CHECKED(UCombatantArchetype, TakeHitAnimations));
+	Visit(DeathAnimations_DEPRECATED, DeathAnimations, GET_MEMBER_NAME_CHECKED(UCombatantArchetype, DeathAnimations));
+}
+
+bool ACombatant::HasLegacyMontages()
+{
+	bool bFound = false;
+
+	VisitLegacyMontages([&bFound](TArray<UAnimMontage*>& Legacy, TArray<UAnimMontage*>&, FName)
+	{
+		bFound |= !Legacy.IsEmpty();
+	});
+
+	return bFound;
+}
+
+void ACombatant::PostLoad()
+{
+	Super::PostLoad();
+
+	if (HasAnyFlags(RF_ClassDefaultObject) && HasLegacyMontages())
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("%s has montages outside a combatant archetype, cooked builds won't play them; run -run=CombatArchetypeMigration"),
+			*GetClass()->GetPathName());
+	}
+}
+#endif
+
+void ACombatant::GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	OutMontages.Append(AttackAnimations);
+	OutMontages.Append(TakeHit_StumbleBackwards);
+	OutMontages.Append(DeathAnimations);
+}
+
+void ACombatant::GatherCombatEffects(TArray<UNiagaraSystem*>& OutEffects) const
+{
+}
+
 void ACombatant::Attack()
 {
 	Attacking = true;
 	NextAttackReady = false;
 	AttackDamaging = false;
-	AttackHitActors.Empty();
+	ResetAttackHits();
+}
+
+int32 ACombatant::PickMontageIndex(const TArray<UAnimMontage*>& Montages, int32 LastIndex)
+{
+	if (Montages.Num() <= 1 || !Montages.IsValidIndex(LastIndex))
+	{
+		return Montages.Num() > 0 ? Random.RandRange(0, Montages.Num() - 1) : INDEX_NONE;
+	}
+
+	// one roll over the others rather than retrying until it differs
+	const int32 Index = Random.RandRange(0, Montages.Num() - 2);
+	return Index >= LastIndex ? Index + 1 : Index;
+}
+
+void ACombatant::RegisterAttackHit(AActor* HitActor)
+{
+	AttackHitActors.Add(HitActor);
+	OnAttackHit.Broadcast(HitActor);
 }
 
 void ACombatant::AttackLunge()
@@ -124,12 +305,16 @@ void ACombatant::AttackNextReady()
 
 void ACombatant::LookAtSmooth()
 {
+	COM_SCOPE(STAT_COM_LookAtSmooth);
+
 	if (Target != NULL && TargetLocked && !Attacking && !GetCharacterMovement()->IsFalling()) {
 		FVector Direction = Target->GetActorLocation() - GetActorLocation();
 		Direction = FVector(Direction.X, Direction.Y, 0);
 		FRotator Rotation = FRotationMatrix::MakeFromX(Direction).Rotator();
 
-		FRotator SmoothedRotation = FMath::Lerp(GetActorRotation(), Rotation, RotationSmoothing * GetWorld()->DeltaTimeSeconds);
+		// exponential so it turns alike at any tick rate, a plain k * dt overshoots at low ones
+		const float Alpha = 1.0f - FMath::Exp(-RotationSmoothing * GetWorld()->DeltaTimeSeconds);
+		FRotator SmoothedRotation = FMath::Lerp(GetActorRotation(), Rotation, Alpha);
 
 		LastRotationSpeed = SmoothedRotation.Yaw - GetActorRotation().Yaw;
 
@@ -156,5 +341,10 @@ void ACombatant::Death()
 	RotateTowardsTarget = false;
 	Stumbling = false;
 	AttackHitActors.Empty();
+
+	if (UStatusEffectSubsystem* StatusEffects = GetWorld()->GetSubsystem<UStatusEffectSubsystem>())
+	{
+		StatusEffects->RemoveAllEffects(this);
+	}
 }
 
@@ -4,14 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "Combat/AttributeComponent.h"
+#include "Combat/CombatRandom.h"
 #include "Combatant.generated.h"
 
+class UCombatantArchetype;
+class UNiagaraSystem;
 
 UCLASS()
 class FUCK_API ACombatant : public ACharacter
 {
 	GENERATED_BODY()
 	DECLARE_MULTICAST_DELEGATE_OneParam(FHealthChangedSignature, float);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FAttackHitSignature, AActor*);
 
 public:
 	// Sets default values for this character's properties
@@ -26,12 +31,58 @@ public:
 	float GetHealth();
 	float GetMaxHealth();
 	void SetHealth(float health);
+
+	// Health change that isn't a hit (heals, DoTs): no stagger, but may still kill. Instigator gets the kill credit.
+	virtual void ApplyHealthDelta(float Delta, AActor* Instigator = nullptr);
 	FHealthChangedSignature HealthChanged;
 	FHealthChangedSignature MaxHealthChanged;
 
+	// an attack of this combatant damaged the actor
+	FAttackHitSignature OnAttackHit;
+
+	// whether the current attack already damaged the actor
+	bool HasAttackHit(const AActor* HitActor) const { return AttackHitActors.Contains(HitActor); }
+
+	// records a damaging hit of the current attack
+	void RegisterAttackHit(AActor* HitActor);
+
+	// forgets the hits of the current attack, as starting a new one does
+	void ResetAttackHits() { AttackHitActors.Empty(); }
+
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Target")
 	AActor* Target;
 
+	// MaxHealth and ClassDamage start out as the base values, after that they hold the final ones
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Attributes")
+	UAttributeComponent* Attributes;
+
+	// every montage this combatant can play in a fight, used to warm them up before an encounter
+	virtual void GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const;
+
+	// the resident effects this combatant spawns itself rather than through its archetype
+	virtual void GatherCombatEffects(TArray<UNiagaraSystem*>& OutEffects) const;
+
+	// save game: reads or writes the state that can change in play
+	virtual void SerializeSaveState(FArchive& Ar, int32 Version);
+
+	// false while the combatant is still as it was placed, so it can be left out of a save
+	virtual bool HasSaveState() const;
+
+	// drops everything mid fight (montages, effects, skills, death) before a checkpoint is restored
+	virtual void ResetCombatState();
+
+#if WITH_EDITORONLY_DATA
+	typedef TFunctionRef<void(TArray<UAnimMontage*>& Legacy, TArray<UAnimMontage*>& Runtime, FName ArchetypeProperty)> FLegacyMontageVisitor;
+
+	// every montage list authored on the actor before archetypes, with the runtime list it stood for
+	// and the UCombatantArchetype property it moves to
+	virtual void VisitLegacyMontages(FLegacyMontageVisitor Visit);
+
+	bool HasLegacyMontages();
+
+	virtual void PostLoad() override;
+#endif
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -51,16 +102,30 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Animation")
 	float RotationSmoothing;
 
-	UPROPERTY(EditAnywhere, Category = "Animations")
+	// animation picks, seeded from the combat random seed
+	FCombatRandomStream Random;
+
+	// a random index into Montages, other than LastIndex when there are several; INDEX_NONE when empty
+	int32 PickMontageIndex(const TArray<UAnimMontage*>& Montages, int32 LastIndex);
+
+	// Soft-referenced montages/FX. Enemies stream them in through UEncounterSubsystem, the player on BeginPlay.
+	UPROPERTY(EditAnywhere, Category = "Archetype")
+	UCombatantArchetype* Archetype;
+
+	// resolves the resident archetype montages into the runtime lists below
+	virtual void ApplyArchetypeAssets();
+
+	// Runtime montage lists, filled from the archetype while its bundles are resident
+	UPROPERTY(Transient)
 	TArray<UAnimMontage*> AttackAnimations;
 
-	UPROPERTY(EditAnywhere, Category = "Animations")
+	UPROPERTY(Transient)
 	TArray<UAnimMontage*> TakeHit_StumbleBackwards;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Health")
 	float MaxHealth;
 
-	UPROPERTY(EditAnywhere, Category = "Animations")
+	UPROPERTY(Transient)
 	TArray<UAnimMontage*> DeathAnimations;
 
 	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Health")
@@ -111,6 +176,22 @@ protected:
 
 	virtual void Death();
 
+	// writes a changed final attribute value into the field the combat code reads
+	virtual void OnAttributeChanged(ECombatAttribute Attribute, float Value);
+
 	float LastRotationSpeed;
 
+#if WITH_EDITORONLY_DATA
+	// Hard references of Blueprints not yet moved to an archetype: loaded, never saved.
+	// The CombatArchetypeMigration commandlet moves them into archetype assets.
+	UPROPERTY()
+	TArray<UAnimMontage*> AttackAnimations_DEPRECATED;
+
+	UPROPERTY()
+	TArray<UAnimMontage*> TakeHit_StumbleBackwards_DEPRECATED;
+
+	UPROPERTY()
+	TArray<UAnimMontage*> DeathAnimations_DEPRECATED;
+#endif
+
 };
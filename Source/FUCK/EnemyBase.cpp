@@ -7,6 +7,12 @@
 #include "Components/StaticMeshComponent.h"
 #include "Components/SceneComponent.h"
 #include "Kismet/BlueprintTypeConversions.h"
+#include "Combat/EncounterSubsystem.h"
+#include "Data/CombatantArchetype.h"
+#include "SkillsComponent.h"
+#include "Profiling/CombatHitchSubsystem.h"
+#include "Profiling/CombatStats.h"
+#include "Profiling/CombatTrace.h"
 
 AEnemyBase::AEnemyBase(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -23,6 +29,9 @@ AEnemyBase::AEnemyBase(const FObjectInitializer& ObjectInitializer)
 
 void AEnemyBase::PostInitializeComponents()
 {
+	// spawns and possesses the AI controller
+	LLM_SCOPE_BYTAG(CityOfMyths_AI);
+
 	Super::PostInitializeComponents();
 	HPBar->SetWidgetClass(CombatantWidgetClass);
 }
@@ -37,16 +46,80 @@ void AEnemyBase::BeginPlay()
 
 	if (CombatantWidgetClass)
 	{
+		LLM_SCOPE_BYTAG(CityOfMyths_UI);
+
 		if (const auto CombatantWidget = Cast<UCombatantWidget>(CreateWidget(GetGameInstance(), CombatantWidgetClass)))
 		{
+			UCombatHitchSubsystem::NoteWidgetCreated(CombatantWidget);
 			CombatantWidget->Init(this);
 			HPBar->SetWidget(CombatantWidget);
 		}
 	}
+
+	if (auto Encounters = GetWorld()->GetSubsystem<UEncounterSubsystem>())
+	{
+		Encounters->RegisterEnemy(this);
+	}
+}
+
+void AEnemyBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (auto Encounters = GetWorld()->GetSubsystem<UEncounterSubsystem>())
+	{
+		Encounters->UnregisterEnemy(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AEnemyBase::ApplyArchetypeAssets()
+{
+	if (!Archetype)
+	{
+		return;
+	}
+
+	Super::ApplyArchetypeAssets();
+
+	ArchetypeAssetsReady = true;
+}
+
+void AEnemyBase::ReleaseArchetypeAssets()
+{
+	if (!Archetype)
+	{
+		return;
+	}
+
+	ArchetypeAssetsReady = false;
+
+	// Only drop what the archetype provided; dead enemies keep their death montages
+	if (Archetype->AttackAnimations.Num() > 0)
+	{
+		AttackAnimations.Empty();
+	}
+
+	if (Archetype->TakeHitAnimations.Num() > 0)
+	{
+		TakeHit_StumbleBackwards.Empty();
+	}
+
+	if (Archetype->DeathAnimations.Num() > 0 && ActiveState != State::DEAD)
+	{
+		DeathAnimations.Empty();
+	}
+}
+
+bool AEnemyBase::AreCombatAssetsReady() const
+{
+	return !Archetype || ArchetypeAssetsReady;
 }
 
 void AEnemyBase::Tick(float DeltaTime)
 {
+	COM_SCOPE(STAT_COM_EnemyTick);
+	LLM_SCOPE_BYTAG(CityOfMyths_AI);
+
 	Super::Tick(DeltaTime);
 
 	if (CheckPlayerTime >= CheckPlayerTimeDelta)
@@ -62,6 +135,8 @@ void AEnemyBase::Tick(float DeltaTime)
 
 void AEnemyBase::TickStateMachine()
 {
+	COM_SCOPE(STAT_COM_StateMachine);
+
 	if (!TargetDead)
 	{
 		switch (ActiveState)
@@ -104,13 +179,19 @@ void AEnemyBase::SetState(State NewState)
 {
 	if (ActiveState != State::DEAD)
 	{
+		if (ActiveState != NewState)
+		{
+			FCombatTrace::LogStateChange(this, (uint8)ActiveState, (uint8)NewState);
+			UCombatHitchSubsystem::NoteStateChange(this, (uint8)ActiveState, (uint8)NewState);
+		}
+
 		ActiveState = NewState;
 	}
 }
 
 void AEnemyBase::StateIdle()
 {
-	if (Target && FVector::Distance(Target->GetActorLocation(), GetActorLocation()) <= 1200.0f && !TargetDead)
+	if (Target && FVector::Distance(Target->GetActorLocation(), GetActorLocation()) <= 1200.0f && !TargetDead && AreCombatAssetsReady())
 	{
 		TargetLocked = true;
 
@@ -135,13 +216,45 @@ void AEnemyBase::StateAttack()
 {
 }
 
+bool AEnemyBase::CanSeeTarget() const
+{
+	INC_DWORD_STAT(STAT_COM_LineOfSightChecks);
+
+	const AAIController* AIController = Cast<AAIController>(GetController());
+	return AIController && AIController->LineOfSightTo(Target);
+}
+
+bool AEnemyBase::TryCastSkill()
+{
+	USkillsComponent* Skills = FindComponentByClass<USkillsComponent>();
+
+	if (!Skills)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < Skills->GetSkillCount(); i++)
+	{
+		if (Skills->Skill(i))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void AEnemyBase::Death()
 {
 	Super::Death();
+	FCombatTrace::LogDeath(this);
 	HealthChanged.Broadcast(0.0f);
-	int AnimationIndex;
-	AnimationIndex = FMath::RandRange(0, DeathAnimations.Num() - 1);
-	PlayAnimMontage(DeathAnimations[AnimationIndex]);
+	if (DeathAnimations.Num() > 0)
+	{
+		int AnimationIndex;
+		AnimationIndex = Random.RandRange(0, DeathAnimations.Num() - 1);
+		PlayAnimMontage(DeathAnimations[AnimationIndex]);
+	}
 }
 
 void AEnemyBase::StateStumble()
@@ -150,7 +263,8 @@ void AEnemyBase::StateStumble()
 
 		if (MovingBackwards)
 		{
-			AddMovementInput(-GetActorForwardVector(), 40.0f * GetWorld()->GetDeltaSeconds());
+			// what 40 * delta time gave at 60 fps, constant so it doesn't depend on the tick rate
+			AddMovementInput(-GetActorForwardVector(), 0.66f);
 		}
 	}
 
@@ -179,6 +293,8 @@ void AEnemyBase::FocusTarget()
 
 void AEnemyBase::CheckHPBarVisibility()
 {
+	COM_SCOPE(STAT_COM_HPBarVisibility);
+
 	auto playerCharacter = UGameplayStatics::GetPlayerCharacter(GetWorld(), 0);
 	
 	if (!playerCharacter)
@@ -191,8 +307,71 @@ void AEnemyBase::CheckHPBarVisibility()
 	HPBar->SetVisibility(distance <= HPBarShowDistance);
 }
 
+void AEnemyBase::ApplyHealthDelta(float Delta, AActor* Instigator)
+{
+	if (ActiveState == State::DEAD)
+	{
+		return;
+	}
+
+	Super::ApplyHealthDelta(Delta, Instigator);
+
+	if (CurrentHealth <= 0.0f)
+	{
+		SetState(State::DEAD);
+		GrantKillXP(Instigator);
+	}
+}
+
+void AEnemyBase::GrantKillXP(AActor* Killer)
+{
+	if (const auto Player = Cast<APlayerCharacter>(Killer))
+	{
+		Player->XPController->QueueXP(XpOnDeath);
+	}
+}
+
+void AEnemyBase::SerializeSaveState(FArchive& Ar, int32 Version)
+{
+	Super::SerializeSaveState(Ar, Version);
+
+	uint8 SavedState = (uint8)ActiveState;
+	Ar << SavedState;
+
+	// only death carries over, the AI picks its fight state again on its own
+	if (Ar.IsLoading() && (State)SavedState == State::DEAD)
+	{
+		SetState(State::DEAD);
+	}
+}
+
+void AEnemyBase::ResetCombatState()
+{
+	Super::ResetCombatState();
+
+	// straight past SetState, which never leaves DEAD
+	ActiveState = State::IDLE;
+	pStateDeadExecuted = false;
+	isAttackTurn = false;
+	TargetDead = false;
+	Target = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
+
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		AIController->StopMovement();
+		AIController->ClearFocus(EAIFocusPriority::Gameplay);
+	}
+}
+
+bool AEnemyBase::HasSaveState() const
+{
+	return ActiveState == State::DEAD || Super::HasSaveState();
+}
+
 float AEnemyBase::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
+	COM_SCOPE(STAT_COM_TakeDamage);
+
 	if (DamageCauser == this)
 	{
 		return 0.0f;
@@ -207,19 +386,20 @@ float AEnemyBase::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent
 	{
 		isAttackTurn = true;
 
+		// only hits that land count, rejected ones cost next to nothing
+		INC_DWORD_STAT(STAT_COM_DamageEvents);
+		UCombatHitchSubsystem::NoteDamage();
+
 		CurrentHealth -= DamageAmount;
+		FCombatTrace::LogDamage(DamageCauser, this, DamageAmount);
 
 		HealthChanged.Broadcast(CurrentHealth);
 
 		if (CurrentHealth <= 0.0f)
 		{
 			SetState(State::DEAD);
-			
-			if (const auto Player = Cast<APlayerCharacter>(DamageCauser))
-			{
-				Player->XPController->AddXP(XpOnDeath);
-			}
-			
+			GrantKillXP(DamageCauser);
+
 			return DamageAmount;
 		}
 
@@ -228,17 +408,20 @@ float AEnemyBase::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent
 			return DamageAmount;
 		}
 
+		// no hit reaction until the archetype montages are resident, or once they are released
+		const int32 AnimationIndex = AreCombatAssetsReady() ? PickMontageIndex(TakeHit_StumbleBackwards, LastStumbleIndex) : INDEX_NONE;
+
+		if (AnimationIndex == INDEX_NONE)
+		{
+			return DamageAmount;
+		}
+
 		EndAttack();
 		SetMovingBackwards(false);
 		SetMovingForward(false);
 		Stumbling = true;
 		SetState(State::STUMBLE);
 		Cast<AAIController>(Controller)->StopMovement();
-		int AnimationIndex;
-		do
-		{
-			AnimationIndex = FMath::RandRange(0, TakeHit_StumbleBackwards.Num() - 1);
-		} while (AnimationIndex == LastStumbleIndex);
 
 		LastStumbleIndex = AnimationIndex;
 
@@ -262,6 +445,12 @@ void AEnemyBase::MoveForward()
 
 void AEnemyBase::Attack(bool Rotate)
 {
+		// nothing to play before the archetype montages are resident, the state machine tries again
+		if (!AreCombatAssetsReady() || AttackAnimations.Num() == 0)
+		{
+			return;
+		}
+
 		Super::Attack();
 
 		SetMovingBackwards(false);
@@ -278,7 +467,7 @@ void AEnemyBase::Attack(bool Rotate)
 			SetActorRotation(Rotation);
 		}
 
-		int RandomIndex = FMath::RandRange(0, AttackAnimations.Num() - 1);
+		int RandomIndex = Random.RandRange(0, AttackAnimations.Num() - 1);
 		PlayAnimMontage(AttackAnimations[RandomIndex]);
 }
 
@@ -28,6 +28,12 @@ public:
 	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent,
 		class AController* EventInstigator, AActor* DamageCauser);
 
+	virtual void ApplyHealthDelta(float Delta, AActor* Instigator = nullptr) override;
+
+	virtual void SerializeSaveState(FArchive& Ar, int32 Version) override;
+	virtual bool HasSaveState() const override;
+	virtual void ResetCombatState() override;
+
 
 	UPROPERTY(EditAnywhere, Category = "Health")
 	TSubclassOf<class UCombatantWidget> CombatantWidgetClass;
@@ -42,13 +48,27 @@ public:
 	UPROPERTY(EditAnywhere, Category = "XP")
 	float XpOnDeath = 2.0f;
 
+	// hands XpOnDeath to the player when it made the killing hit or tick
+	void GrantKillXP(AActor* Killer);
+
 	bool isAttackTurn = false;
+
+	// called by UEncounterSubsystem once the archetype bundles are resident
+	virtual void ApplyArchetypeAssets() override;
+
+	// called by UEncounterSubsystem before the archetype bundles are unloaded
+	virtual void ReleaseArchetypeAssets();
+
+	virtual bool AreCombatAssetsReady() const;
+
+	// one decision of the state ActiveState is in
+	virtual void TickStateMachine();
 	
 
 protected:
 	virtual void BeginPlay() override;
 
-	virtual void TickStateMachine();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	void SetState(State NewState);
 
@@ -58,6 +78,12 @@ protected:
 
 	virtual void StateAttack();
 
+	// Casts the first ready skill of an attached USkillsComponent, if any
+	bool TryCastSkill();
+
+	// line of sight from the AI controller to Target, counted in stat CityOfMyths
+	bool CanSeeTarget() const;
+
 	void Death();
 	virtual void StateStumble();
 
@@ -81,6 +107,8 @@ protected:
 
 	bool pStateDeadExecuted = false;
 
+	bool ArchetypeAssetsReady = false;
+
 public:
 
 	virtual void Tick(float DeltaTime) override;
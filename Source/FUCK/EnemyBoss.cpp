@@ -4,7 +4,11 @@
 #include "Engine/World.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "Engine/AssetManager.h"
+#include "Sound/SoundBase.h"
 #include "PlayerCharacter.h"
+#include "Data/CombatantArchetype.h"
+#include "Profiling/CombatStats.h"
 
 AEnemyBoss::AEnemyBoss()
 {
@@ -24,6 +28,35 @@ AEnemyBoss::AEnemyBoss()
 	LongAttack_Timestamp = -LongAttack_Cooldown;
 	GetCharacterMovement()->MaxWalkSpeed = 350.0f;
 	Interruptable = false;
+
+	// what BP_Boss's Explosion event used to spawn unpooled
+	ExplosionEffect = TSoftObjectPtr<UNiagaraSystem>(FSoftObjectPath(TEXT("/Game/Blueprint/FX_LongAttackBoss.FX_LongAttackBoss")));
+	ExplosionSound = TSoftObjectPtr<USoundBase>(FSoftObjectPath(TEXT("/Game/Blueprint/Sounds/Long_Attack_Boss.Long_Attack_Boss")));
+}
+
+void AEnemyBoss::BeginPlay()
+{
+	Super::BeginPlay();
+
+	TArray<FSoftObjectPath> Effects;
+	for (const FSoftObjectPath& Path : { ExplosionEffect.ToSoftObjectPath(), LongAttackEffect.ToSoftObjectPath(), ExplosionSound.ToSoftObjectPath() })
+	{
+		if (!Path.IsNull())
+		{
+			Effects.Add(Path);
+		}
+	}
+
+	if (Effects.Num() > 0)
+	{
+		EffectsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Effects);
+	}
+}
+
+bool AEnemyBoss::AreCombatAssetsReady() const
+{
+	// the boss doesn't engage before its effects are resident either
+	return Super::AreCombatAssetsReady() && (!EffectsHandle.IsValid() || EffectsHandle->HasLoadCompleted());
 }
 
 
@@ -34,8 +67,66 @@ void AEnemyBoss::Tick(float DeltaTime)
 	TickStateMachine();
 }
 
+void AEnemyBoss::ApplyArchetypeAssets()
+{
+	Super::ApplyArchetypeAssets();
+
+	if (Archetype)
+	{
+		UCombatantArchetype::Resolve(Archetype->MagicSpellAnimations, MagicSpell);
+	}
+}
+
+void AEnemyBoss::ReleaseArchetypeAssets()
+{
+	if (Archetype && Archetype->MagicSpellAnimations.Num() > 0)
+	{
+		MagicSpell.Empty();
+	}
+
+	Super::ReleaseArchetypeAssets();
+}
+
+void AEnemyBoss::ResetCombatState()
+{
+	Super::ResetCombatState();
+
+	MagicIndex = 0;
+	LongAttack_Timestamp = -LongAttack_Cooldown;
+	MagicSpell_Timestamp = -MagicSpell_Cooldown;
+}
+
+void AEnemyBoss::GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	Super::GatherCombatMontages(OutMontages);
+	OutMontages.Append(MagicSpell);
+}
+
+#if WITH_EDITORONLY_DATA
+void AEnemyBoss::VisitLegacyMontages(FLegacyMontageVisitor Visit)
+{
+	Super::VisitLegacyMontages(Visit);
+	Visit(MagicSpell_DEPRECATED, MagicSpell, GET_MEMBER_NAME_CHECKED(UCombatantArchetype, MagicSpellAnimations));
+}
+#endif
+
+void AEnemyBoss::GatherCombatEffects(TArray<UNiagaraSystem*>& OutEffects) const
+{
+	Super::GatherCombatEffects(OutEffects);
+
+	for (UNiagaraSystem* Effect : { ExplosionEffect.Get(), LongAttackEffect.Get() })
+	{
+		if (Effect)
+		{
+			OutEffects.Add(Effect);
+		}
+	}
+}
+
 void AEnemyBoss::TickStateMachine()
 {
+	COM_SCOPE(STAT_COM_StateMachine);
+
 	if (!TargetDead)
 	{
 		switch (ActiveState)
@@ -89,7 +180,7 @@ void AEnemyBoss::StateChaseClose()
 
 	float DotProduct = FVector::DotProduct(GetActorForwardVector(), TargetDirection.GetSafeNormal());
 
-	if (Distance > 300.0f && UGameplayStatics::GetTimeSeconds(GetWorld()) >= LongAttack_Timestamp + LongAttack_Cooldown && AIController->LineOfSightTo(Target) && isAttackTurn == true)
+	if (Distance > 300.0f && UGameplayStatics::GetTimeSeconds(GetWorld()) >= LongAttack_Timestamp + LongAttack_Cooldown && CanSeeTarget() && isAttackTurn == true)
 	{
 		isAttackTurn = false;
 		LongAttack_Timestamp = UGameplayStatics::GetTimeSeconds(GetWorld());
@@ -107,13 +198,16 @@ void AEnemyBoss::StateChaseClose()
 			return;
 		}
 
-		else if (Distance >= 600 && UGameplayStatics::GetTimeSeconds(GetWorld()) >= MagicSpell_Timestamp + MagicSpell_Cooldown && AIController->LineOfSightTo(Target))
+		else if (Distance >= 600 && UGameplayStatics::GetTimeSeconds(GetWorld()) >= MagicSpell_Timestamp + MagicSpell_Cooldown && CanSeeTarget())
 		{
 			MagicSpell_Timestamp = UGameplayStatics::GetTimeSeconds(GetWorld());
 			MagicAttack(true);
 			return;
 		}
-		
+		else if (TryCastSkill())
+		{
+			return;
+		}
 	}
 
 	if (!AIController->IsFollowingAPath())
@@ -124,10 +218,20 @@ void AEnemyBoss::StateChaseClose()
 
 void AEnemyBoss::StateLongBossAttack()
 {
+	COM_SCOPE(STAT_COM_AttackOverlaps);
+
 	float Distance = FVector::Distance(GetActorLocation(), Target->GetActorLocation());
 	if (Distance < 150.0f)
 	{
-		Explosion();
+		UCombatVFXSubsystem* CombatVFX = GetWorld()->GetSubsystem<UCombatVFXSubsystem>();
+		CombatVFX->Release(LongAttackVFX);
+		CombatVFX->SpawnAtLocation(ExplosionEffect.LoadSynchronous(), ECombatVFXType::BossAttack, GetActorLocation(), GetActorRotation());
+
+		if (USoundBase* Sound = ExplosionSound.LoadSynchronous())
+		{
+			UGameplayStatics::SpawnSoundAtLocation(this, Sound, GetActorLocation());
+		}
+
 		GetCharacterMovement()->MaxWalkSpeed = 350.0f;
 		EndAttack();
 	}
@@ -136,6 +240,7 @@ void AEnemyBoss::StateLongBossAttack()
 		{
 
 			TSet<AActor*> OverlappingActors;
+			INC_DWORD_STAT(STAT_COM_OverlapQueries);
 			DamageCollisionForLongAttack->GetOverlappingActors(OverlappingActors);
 
 			for (AActor* OtherActor : OverlappingActors)
@@ -144,7 +249,7 @@ void AEnemyBoss::StateLongBossAttack()
 				{
 					continue;
 				}
-				if (!AttackHitActors.Contains(OtherActor))
+				if (!HasAttackHit(OtherActor))
 				{
 					float AppliedDamage = UGameplayStatics::ApplyDamage(OtherActor, ClassDamage, GetController(), this, UDamageType::StaticClass());
 
@@ -156,7 +261,7 @@ void AEnemyBoss::StateLongBossAttack()
 
 					if (AppliedDamage > 0.0f)
 					{
-						AttackHitActors.Add(OtherActor);
+						RegisterAttackHit(OtherActor);
 					}
 				}
 			}
@@ -172,10 +277,13 @@ void AEnemyBoss::MoveForward()
 
 void AEnemyBoss::StateAttack()
 {
+	COM_SCOPE(STAT_COM_AttackOverlaps);
+
 	if (AttackDamaging)
 	{
 
 		TSet<AActor*> OverlappingActors;
+		INC_DWORD_STAT(STAT_COM_OverlapQueries);
 		DamageCollisionForHand->GetOverlappingActors(OverlappingActors);
 
 		for (AActor* OtherActor : OverlappingActors)
@@ -184,7 +292,7 @@ void AEnemyBoss::StateAttack()
 			{
 				continue;
 			}
-			if (!AttackHitActors.Contains(OtherActor))
+			if (!HasAttackHit(OtherActor))
 			{
 				float AppliedDamage = UGameplayStatics::ApplyDamage(OtherActor, ClassDamage, GetController(), this, UDamageType::StaticClass());
 
@@ -196,7 +304,7 @@ void AEnemyBoss::StateAttack()
 
 				if (AppliedDamage > 0.0f)
 				{
-					AttackHitActors.Add(OtherActor);
+					RegisterAttackHit(OtherActor);
 				}
 			}
 		}
@@ -213,12 +321,18 @@ void AEnemyBoss::LongAttack(bool Rotate)
 	GetCharacterMovement()->MaxWalkSpeed = 600.0f;;
 	SetState(State::LongBossAttack);
 	AttackDamaging = true;
+	LongAttackVFX = GetWorld()->GetSubsystem<UCombatVFXSubsystem>()->SpawnAttached(LongAttackEffect.LoadSynchronous(), ECombatVFXType::BossAttack, GetMesh(), NAME_None);
 	AAIController* AIController = Cast<AAIController>(Controller);
 	AIController->MoveToActor(Target);
 }
 
 void AEnemyBoss::MagicAttack(bool Rotate)
 {
+	if (!AreCombatAssetsReady() || MagicSpell.Num() == 0)
+	{
+		return;
+	}
+
 	Super::Attack();
 
 	SetMovingBackwards(false);
@@ -2,8 +2,13 @@
 
 #include "CoreMinimal.h"
 #include "EnemyBase.h"
+#include "VFX/CombatVFXSubsystem.h"
 #include "EnemyBoss.generated.h"
 
+class UNiagaraSystem;
+class USoundBase;
+struct FStreamableHandle;
+
 /**
  *
  */
@@ -26,16 +31,41 @@ public:
 	UPROPERTY(VisibleDefaultsOnly, Category = "Components")
 	UCapsuleComponent* DamageCollisionForLongAttack;
 
-	UPROPERTY(EditAnywhere, Category = "Animations")
+	UPROPERTY(Transient)
 	TArray<UAnimMontage*> MagicSpell;
 
+	// no longer raised: the explosion effect and sound BP_Boss spawned here are played from C++ now
 	UFUNCTION(BlueprintCallable, BlueprintImplementableEvent, Category = "LongAttackDamage")
 	void Explosion();
 
+	// Spawned through UCombatVFXSubsystem, streamed in on BeginPlay
+	UPROPERTY(EditAnywhere, Category = "Effects")
+	TSoftObjectPtr<UNiagaraSystem> ExplosionEffect;
+
+	UPROPERTY(EditAnywhere, Category = "Effects")
+	TSoftObjectPtr<UNiagaraSystem> LongAttackEffect;
+
+	UPROPERTY(EditAnywhere, Category = "Effects")
+	TSoftObjectPtr<USoundBase> ExplosionSound;
+
 	UPROPERTY(EditAnywhere,BlueprintReadWrite,Category = "MagicAttackIndex")
 	int MagicIndex = 0;
 
+	virtual void ApplyArchetypeAssets() override;
+	virtual void ReleaseArchetypeAssets() override;
+	virtual bool AreCombatAssetsReady() const override;
+	virtual void GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const override;
+	virtual void GatherCombatEffects(TArray<UNiagaraSystem*>& OutEffects) const override;
+
+	virtual void ResetCombatState() override;
+
+#if WITH_EDITORONLY_DATA
+	virtual void VisitLegacyMontages(FLegacyMontageVisitor Visit) override;
+#endif
+
 protected:
+	virtual void BeginPlay() override;
+
 	void StateChaseClose();
 
 	void StateLongBossAttack();
@@ -68,4 +98,13 @@ private:
 
 	UPROPERTY(EditAnywhere, Category = "Combat")
 	float ForwardSpeedAttack;
+
+	FCombatVFXHandle LongAttackVFX;
+
+	TSharedPtr<FStreamableHandle> EffectsHandle;
+
+#if WITH_EDITORONLY_DATA
+	UPROPERTY()
+	TArray<UAnimMontage*> MagicSpell_DEPRECATED;
+#endif
 };
@@ -9,6 +9,6 @@ public class FUCK : ModuleRules
 		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
 
         PublicDependencyModuleNames.AddRange(new string[] { "Core", "UMG", "UIFramework", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "AIModule", "GameplayCameras", "HeadMountedDisplay", "Niagara" });
-        PrivateDependencyModuleNames.AddRange(new string[] {"Slate", "SlateCore" });
+        PrivateDependencyModuleNames.AddRange(new string[] {"Slate", "SlateCore", "NavigationSystem", "RenderCore", "Json" });
     }
 }
@@ -3,5 +3,6 @@
 #include "FUCK.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogCityOfMyths);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, FUCK, "FUCK" );
- 
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "PauseMenu.h"
 
 #include "Kismet/GameplayStatics.h"
+#include "Save/CombatSaveSubsystem.h"
 
 void UPauseMenu::Init()
 {
@@ -38,4 +39,8 @@ void UPauseMenu::Exit()
 
 void UPauseMenu::Save()
 {
+	if (UCombatSaveSubsystem* Saves = GetWorld()->GetSubsystem<UCombatSaveSubsystem>())
+	{
+		Saves->Save();
+	}
 }
@@ -20,6 +20,47 @@
 #include "Kismet/BlueprintTypeConversions.h"
 #include "UI/PlayerCharacterWidget.h"
 #include "UI/GameOver/UGameOverWidget.h"
+#include "Combat/CombatWarmupSubsystem.h"
+#include "Data/CombatantArchetype.h"
+#include "Engine/AssetManager.h"
+#include "HAL/IConsoleManager.h"
+#include "SkillsComponent.h"
+#include "Profiling/CombatHitchSubsystem.h"
+#include "Profiling/CombatStats.h"
+#include "Profiling/CombatTrace.h"
+#include "Profiling/CombatInputReplayComponent.h"
+#include "FUCK.h"
+
+static FAutoConsoleCommandWithWorldAndArgs InputLatencyCommand(
+	TEXT("com.Input.Latency"),
+	TEXT("Prints input-to-action latency of the buffered attack, roll and skill inputs. Pass 'reset' to clear the counters."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(World, 0));
+
+		if (!Player)
+		{
+			return;
+		}
+
+		USkillsComponent* Skills = Player->FindComponentByClass<USkillsComponent>();
+
+		if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+		{
+			Player->InputBuffer.ResetLatency();
+			if (Skills)
+			{
+				Skills->skillInputBuffer.ResetLatency();
+			}
+			return;
+		}
+
+		UE_LOG(LogCityOfMyths, Display, TEXT("Attack/roll input: %s"), *Player->InputBuffer.GetLatency().ToString());
+		if (Skills)
+		{
+			UE_LOG(LogCityOfMyths, Display, TEXT("Skill input: %s"), *Skills->skillInputBuffer.GetLatency().ToString());
+		}
+	}));
 
 // Sets default values
 APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
@@ -89,8 +130,8 @@ APlayerCharacter::APlayerCharacter(const FObjectInitializer& ObjectInitializer)
 	GetCharacterMovement()->MaxWalkSpeed = PassiveMovementSpeed;
 
 	MaxStamina = 100.0f;
-	CurrentStamina = MaxStamina;
-
+	StaminaRegenRate = 15.0f;
+	SprintCostStamina = 30.0f;
 
 	RollCostStamina = 30.0f;
 	AttackCostStamina = 33.0f;
@@ -102,6 +143,19 @@ void APlayerCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
+	// The player fights from the first frame, so its montages load with it rather than ahead of an encounter
+	if (Archetype)
+	{
+		ArchetypeHandle = UAssetManager::Get().LoadPrimaryAsset(Archetype->GetPrimaryAssetId(), UCombatantArchetype::GetEncounterBundles());
+
+		if (ArchetypeHandle.IsValid())
+		{
+			ArchetypeHandle->WaitUntilComplete();
+		}
+
+		ApplyArchetypeAssets();
+	}
+
 	EnemyDetectionCollider->OnComponentBeginOverlap.
 		AddDynamic(this, &APlayerCharacter::OnEnemyDetectionBeginOverlap);
 	EnemyDetectionCollider->OnComponentEndOverlap.
@@ -119,6 +173,8 @@ void APlayerCharacter::BeginPlay()
 	
 	if (PlayerCharacterWidgetClass)
 	{
+		LLM_SCOPE_BYTAG(CityOfMyths_UI);
+
 		if (const auto Widget = Cast<UPlayerCharacterWidget>(CreateWidget(GetGameInstance(), PlayerCharacterWidgetClass)))
 		{
 			Widget->Init(this);
@@ -127,11 +183,33 @@ void APlayerCharacter::BeginPlay()
 	}
 
 	XPController->Init();
+
+	Stamina.Init(MaxStamina, MaxStamina, GetWorld()->GetTimeSeconds());
+	Attributes->InitBase(ECombatAttribute::MaxStamina, MaxStamina);
+
+	InputBuffer.Window = InputBufferWindow;
+
+	// the camera manager only exists once we are possessed
+	GetWorldTimerManager().SetTimerForNextTick([WeakThis = TWeakObjectPtr<APlayerCharacter>(this)]()
+	{
+		if (!WeakThis.IsValid())
+		{
+			return;
+		}
+
+		if (auto Warmup = WeakThis->GetWorld()->GetSubsystem<UCombatWarmupSubsystem>())
+		{
+			Warmup->WarmupCameraShake(WeakThis->GetController<APlayerController>(), WeakThis->CameraShakeMinor);
+		}
+
+		UCombatInputReplayComponent::StartFromCommandLine(WeakThis.Get());
+	});
 }
 
 // Called every frame
 void APlayerCharacter::Tick(float DeltaTime)
 {
+	COM_SCOPE(STAT_COM_PlayerTick);
 	
 	if (!Dead)
 	{
@@ -141,14 +219,19 @@ void APlayerCharacter::Tick(float DeltaTime)
 
 		if (Rolling)
 		{
-			AddMovementInput(GetActorForwardVector(), 600 * GetWorld()->GetDeltaSeconds());
+			// input scales aren't rates, they get the same value at every tick rate
+			AddMovementInput(GetActorForwardVector(), 1.0f);
 		}
 		else if (Stumbling && MovingBackwards)
 		{
-			AddMovementInput(-GetActorForwardVector(), 40.0 * GetWorld()->GetDeltaSeconds());
+			// what 40 * delta time gave at 60 fps
+			AddMovementInput(-GetActorForwardVector(), 0.66f);
 		}
 		else if (Attacking && AttackDamaging)
 		{
+			COM_SCOPE(STAT_COM_AttackOverlaps);
+			INC_DWORD_STAT(STAT_COM_OverlapQueries);
+
 			TSet<AActor*> WeaponOverlappingActors;
 			Weapon->GetOverlappingActors(WeaponOverlappingActors);
 
@@ -157,13 +240,13 @@ void APlayerCharacter::Tick(float DeltaTime)
 				if (HitActor == this)
 					continue;
 
-				if (!AttackHitActors.Contains(HitActor))
+				if (!HasAttackHit(HitActor))
 				{
 					float AppliedDamage = UGameplayStatics::ApplyDamage(HitActor, ClassDamage, GetController(), this, UDamageType::StaticClass());
 
 					if (AppliedDamage > 0.0f)
 					{
-						AttackHitActors.Add(HitActor);
+						RegisterAttackHit(HitActor);
 
 						GetWorld()->GetFirstPlayerController()->PlayerCameraManager->StartCameraShake(CameraShakeMinor);
 					}
@@ -171,29 +254,22 @@ void APlayerCharacter::Tick(float DeltaTime)
 			}
 		}
 
+		UpdateStaminaRate();
+
 		if (Sprint)
 		{
-			if (!TargetLocked && GetCharacterMovement()->Velocity.Size() > 0.0f && CurrentStamina > 0.0f)
-			{
-				GetCharacterMovement()->MaxWalkSpeed = 600.0f;
-				CurrentStamina = FMath::Clamp(CurrentStamina - 30 * DeltaTime, 0.0f, MaxStamina);
-			}
-			else
-			{
-				GetCharacterMovement()->MaxWalkSpeed = PassiveMovementSpeed;
-			}
+			GetCharacterMovement()->MaxWalkSpeed = Stamina.GetRate() < 0.0f ? 600.0f : PassiveMovementSpeed;
 		}
 
-		else if (!Sprint && CurrentStamina < MaxStamina && !Rolling && !Attacking)
+		else if (Stamina.GetRate() > 0.0f && GetStamina() < Stamina.GetMax())
 		{
-			CurrentStamina = FMath::Clamp(CurrentStamina + 15 * DeltaTime, 0.0f, MaxStamina);
 			GetCharacterMovement()->MaxWalkSpeed = PassiveMovementSpeed;
 		}
 
 		/*
 		if (GEngine)
 		{
-			FString StaminaText = FString::Printf(TEXT("Stamina: %.2f"), CurrentStamina);
+			FString StaminaText = FString::Printf(TEXT("Stamina: %.2f"), GetStamina());
 			GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::White, StaminaText);
 		} */
 
@@ -297,6 +373,8 @@ void APlayerCharacter::MoveRight(float Value)
 
 void APlayerCharacter::CycleTarget(bool Clockwise)
 {
+	COM_SCOPE(STAT_COM_CycleTarget);
+
 	AActor* SuitableTarget = NULL;
 
 	if (Target)
@@ -367,6 +445,17 @@ void APlayerCharacter::CycleTargetCounterClockwise()
 	CycleTarget(false);
 }
 
+void APlayerCharacter::GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	Super::GatherCombatMontages(OutMontages);
+	OutMontages.Append(Attacks);
+
+	if (CombatRoll)
+	{
+		OutMontages.Add(CombatRoll);
+	}
+}
+
 void APlayerCharacter::LookAtSmooth()
 {
 	if (!Rolling) {
@@ -384,23 +473,27 @@ float APlayerCharacter::TakeDamageProjectile(float DamageAmount)
 			return 0.0f;
 		}
 		CurrentHealth -= DamageAmount;
+		FCombatTrace::LogDamage(nullptr, this, DamageAmount);
+		INC_DWORD_STAT(STAT_COM_DamageEvents);
+		UCombatHitchSubsystem::NoteDamage();
 		HealthChanged.Broadcast(CurrentHealth);
 		if (CurrentHealth <= 0.0f)
 		{
 			Death();
 			return DamageAmount;
 		}
+		const int32 AnimationIndex = PickMontageIndex(TakeHit_StumbleBackwards, LastStumbleIndex);
+
+		if (AnimationIndex == INDEX_NONE)
+		{
+			return DamageAmount;
+		}
+
 		EndAttack();
 		SetMovingBackwards(false);
 		SetMovingForward(false);
 		Stumbling = true;
 
-		int AnimationIndex = 0;
-		do
-		{
-			AnimationIndex = FMath::RandRange(0, TakeHit_StumbleBackwards.Num() - 1);
-		} while (AnimationIndex == LastStumbleIndex);
-
 		PlayAnimMontage(TakeHit_StumbleBackwards[AnimationIndex]);
 
 		LastStumbleIndex = AnimationIndex;
@@ -409,8 +502,25 @@ float APlayerCharacter::TakeDamageProjectile(float DamageAmount)
 	
 }
 
+void APlayerCharacter::ApplyHealthDelta(float Delta, AActor* Instigator)
+{
+	if (Dead)
+	{
+		return;
+	}
+
+	Super::ApplyHealthDelta(Delta, Instigator);
+
+	if (CurrentHealth <= 0.0f)
+	{
+		Death();
+	}
+}
+
 float APlayerCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
+	COM_SCOPE(STAT_COM_TakeDamage);
+
 	if (!Dead)
 	{
 		if (DamageCauser == this || Rolling)
@@ -418,7 +528,12 @@ float APlayerCharacter::TakeDamage(float DamageAmount, FDamageEvent const& Damag
 			return 0.0f;
 		}
 
+		// only hits that land count, rejected ones cost next to nothing
+		INC_DWORD_STAT(STAT_COM_DamageEvents);
+		UCombatHitchSubsystem::NoteDamage();
+
 		CurrentHealth -= DamageAmount;
+		FCombatTrace::LogDamage(DamageCauser, this, DamageAmount);
 		HealthChanged.Broadcast(CurrentHealth);
 
 		if (CurrentHealth <= 0.0f)
@@ -427,17 +542,18 @@ float APlayerCharacter::TakeDamage(float DamageAmount, FDamageEvent const& Damag
 			return DamageAmount;
 		}
 
+		const int32 AnimationIndex = PickMontageIndex(TakeHit_StumbleBackwards, LastStumbleIndex);
+
+		if (AnimationIndex == INDEX_NONE)
+		{
+			return DamageAmount;
+		}
+
 		EndAttack();
 		SetMovingBackwards(false);
 		SetMovingForward(false);
 		Stumbling = true;
 
-		int AnimationIndex = 0;
-		do
-		{
-			AnimationIndex = FMath::RandRange(0, TakeHit_StumbleBackwards.Num() - 1);
-		} while (AnimationIndex == LastStumbleIndex);
-
 		PlayAnimMontage(TakeHit_StumbleBackwards[AnimationIndex]);
 
 		LastStumbleIndex = AnimationIndex;
@@ -472,9 +588,21 @@ void APlayerCharacter::OnEnemyDetectionEndOverlap(UPrimitiveComponent* Overlappe
 
 void APlayerCharacter::Attack()
 {
-	if ((!Attacking || NextAttackReady) && !Rolling && !Stumbling && !GetCharacterMovement()->IsFalling() && !Dead && CurrentStamina > 10.0f)
+	if (TryAttack())
+	{
+		InputBuffer.RecordImmediate();
+	}
+	else if (!Dead)
 	{
-		CurrentStamina = FMath::Clamp(CurrentStamina - AttackCostStamina, 0.0f, MaxStamina);
+		InputBuffer.Push(GetWorld()->GetTimeSeconds(), ECombatInputAction::Attack);
+	}
+}
+
+bool APlayerCharacter::TryAttack()
+{
+	if ((!Attacking || NextAttackReady) && !Rolling && !Stumbling && !GetCharacterMovement()->IsFalling() && !Dead && GetStamina() > 10.0f)
+	{
+		SpendStamina(AttackCostStamina);
 
 		Super::Attack();
 
@@ -484,8 +612,11 @@ void APlayerCharacter::Attack()
 		}
 
 		PlayAnimMontage(Attacks[AttackIndex++]);
+		return true;
 	}
 
+	return false;
+
 
 	/*
 		if (GEngine)
@@ -495,6 +626,65 @@ void APlayerCharacter::Attack()
 	} */
 }
 
+float APlayerCharacter::GetStamina() const
+{
+	return Stamina.Get(GetWorld()->GetTimeSeconds());
+}
+
+void APlayerCharacter::UpdateStaminaRate()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	float Rate = 0.0f;
+
+	if (Sprint)
+	{
+		if (!TargetLocked && GetCharacterMovement()->Velocity.Size() > 0.0f && Stamina.Get(Now) > 0.0f)
+		{
+			Rate = -SprintCostStamina;
+		}
+	}
+	else if (!Rolling && !Attacking)
+	{
+		Rate = StaminaRegenRate;
+	}
+
+	if (Stamina.SetRate(Rate, Now))
+	{
+		OnStaminaWritten();
+	}
+}
+
+void APlayerCharacter::SpendStamina(float Amount)
+{
+	Stamina.Add(-Amount, GetWorld()->GetTimeSeconds());
+	OnStaminaWritten();
+}
+
+void APlayerCharacter::OnStaminaWritten()
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	OnStaminaChanged.Broadcast(Stamina.Get(Now));
+
+	// the next UI update is when stamina runs full or empty, nothing in between needs a tick
+	const double Settled = Stamina.TimeUntilSettled(Now);
+
+	if (Settled > 0.0)
+	{
+		GetWorldTimerManager().SetTimer(StaminaSettledHandle, this, &APlayerCharacter::OnStaminaSettled, (float)Settled, false);
+	}
+	else
+	{
+		GetWorldTimerManager().ClearTimer(StaminaSettledHandle);
+	}
+}
+
+void APlayerCharacter::OnStaminaSettled()
+{
+	OnStaminaChanged.Broadcast(GetStamina());
+}
+
 void APlayerCharacter::StartSprinting()
 {
 	Sprint = true;
@@ -515,8 +705,11 @@ void APlayerCharacter::LoadGameOverScreen()
 {
 	if (GameOverWidget)
 	{
+		LLM_SCOPE_BYTAG(CityOfMyths_UI);
+
 		if (auto Widget = Cast<UUGameOverWidget>(CreateWidget(GetGameInstance(), GameOverWidget)))
 		{
+			UCombatHitchSubsystem::NoteWidgetCreated(Widget);
 			Widget->Init();
 			Widget->AddToViewport();
 		}
@@ -527,30 +720,101 @@ void APlayerCharacter::ShowPauseMenu()
 {
 	if (PauseWidget)
 	{
+		LLM_SCOPE_BYTAG(CityOfMyths_UI);
+
 		if (auto Widget = Cast<UPauseMenu>(CreateWidget(GetGameInstance(), PauseWidget)))
 		{
+			UCombatHitchSubsystem::NoteWidgetCreated(Widget);
 			Widget->Init();
 			Widget->AddToViewport();
 		}
 	}
 }
 
+void APlayerCharacter::SerializeSaveState(FArchive& Ar, int32 Version)
+{
+	// level first: loading it re-runs OnLevelChanged, so the health below is clamped to the leveled maximum
+	XPController->SerializeSaveState(Ar);
+
+	Super::SerializeSaveState(Ar, Version);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	float CurrentStamina = Stamina.Get(Now);
+
+	// max stamina comes from its attribute like max health
+	if (Version < 2)
+	{
+		float SavedMaxStamina = 0.0f;
+		Ar << SavedMaxStamina;
+	}
+
+	Ar << CurrentStamina;
+
+	if (Ar.IsLoading())
+	{
+		Stamina.Set(CurrentStamina, Now);
+		OnStaminaWritten();
+	}
+}
+
+void APlayerCharacter::ResetCombatState()
+{
+	Super::ResetCombatState();
+
+	Dead = false;
+	Rolling = false;
+	Sprint = false;
+	InputBuffer.Clear();
+	SetInCombat(false);
+
+	// enemies already inside the collider won't overlap again
+	NearbyEnemies.Reset();
+
+	TSet<AActor*> NearActors;
+	EnemyDetectionCollider->GetOverlappingActors(NearActors);
+
+	for (auto& EnemyActor : NearActors) {
+		if (Cast<AEnemyBase>(EnemyActor))
+			NearbyEnemies.Add(EnemyActor);
+	}
+}
+
 void APlayerCharacter::OnLevelChanged(int Value)
 {
-	MaxHealth *= 1.1;
-	MaxHealthChanged.Broadcast(MaxHealth);
-	
-	ClassDamage *= 1.1;
+	// absolute from the level, so stats never drift however often this runs. The starting level already
+	// counted as one step up (it used to be applied in place by the first broadcast), hence the + 1.
+	const float LevelScale = FMath::Pow(1.1f, (float)(Value + 1));
+
+	Attributes->SetModifier(ECombatAttribute::MaxHealth, TEXT("Level"), EAttributeModifierOp::Multiply, LevelScale);
+	Attributes->SetModifier(ECombatAttribute::Damage, TEXT("Level"), EAttributeModifierOp::Multiply, LevelScale);
+}
+
+void APlayerCharacter::OnAttributeChanged(ECombatAttribute Attribute, float Value)
+{
+	Super::OnAttributeChanged(Attribute, Value);
+
+	if (Attribute == ECombatAttribute::MaxStamina)
+	{
+		MaxStamina = Value;
+		Stamina.SetMax(MaxStamina, GetWorld()->GetTimeSeconds());
+		OnStaminaWritten();
+	}
 }
 
 void APlayerCharacter::Death()
 {
 	Super::Death();
+	FCombatTrace::LogDeath(this);
 	EndAttack();
 	Target = NULL;
 	SetInCombat(false);
 	Dead = true;
-	PlayAnimMontage(DeathAnimations[0]);
+	InputBuffer.Clear();
+
+	if (DeathAnimations.Num() > 0)
+	{
+		PlayAnimMontage(DeathAnimations[0]);
+	}
 
 	LoadGameOverScreen();
 }
@@ -558,6 +822,21 @@ void APlayerCharacter::Death()
 void APlayerCharacter::AttackNextReady()
 {
 	Super::AttackNextReady();
+	ConsumeInputBuffer();
+}
+
+void APlayerCharacter::EndStumble()
+{
+	Super::EndStumble();
+	ConsumeInputBuffer();
+}
+
+void APlayerCharacter::ConsumeInputBuffer()
+{
+	InputBuffer.Consume(GetWorld()->GetTimeSeconds(), [this](const FCombatInputBuffer::FEntry& Entry)
+	{
+		return Entry.Action == ECombatInputAction::Roll ? TryRoll() : TryAttack();
+	});
 }
 
 void APlayerCharacter::Jump()
@@ -570,12 +849,24 @@ void APlayerCharacter::Jump()
 
 void APlayerCharacter::Roll()
 {
-	if (Dead ||Attacking || Rolling || Stumbling || GetCharacterMovement()->IsFalling() || CurrentStamina <= 30.0f)
+	if (TryRoll())
 	{
-		return;
+		InputBuffer.RecordImmediate();
+	}
+	else if (!Dead)
+	{
+		InputBuffer.Push(GetWorld()->GetTimeSeconds(), ECombatInputAction::Roll);
+	}
+}
+
+bool APlayerCharacter::TryRoll()
+{
+	if (Dead ||Attacking || Rolling || Stumbling || GetCharacterMovement()->IsFalling() || GetStamina() <= 30.0f)
+	{
+		return false;
 	}
 
-	CurrentStamina = FMath::Clamp(CurrentStamina - RollCostStamina, 0.0f, MaxStamina);
+	SpendStamina(RollCostStamina);
 
 	EndAttack();
 
@@ -599,6 +890,7 @@ void APlayerCharacter::Roll()
 	SetActorRotation(RollRotation);
 
 	PlayAnimMontage(CombatRoll);
+	return true;
 }
 
 void APlayerCharacter::StartRoll()
@@ -615,11 +907,14 @@ void APlayerCharacter::EndRoll()
 	Rolling = false;
 
 	GetCharacterMovement()->MaxWalkSpeed = TargetLocked ? CombatMovementSpeed : PassiveMovementSpeed;
+
+	ConsumeInputBuffer();
 }
 
 void APlayerCharacter::RollRotateSmooth()
 {
-	FRotator SmoothedRotation = FMath::Lerp(GetActorRotation(), RollRotation, RotationSmoothing * GetWorld()->DeltaTimeSeconds);
+	const float Alpha = 1.0f - FMath::Exp(-RotationSmoothing * GetWorld()->DeltaTimeSeconds);
+	FRotator SmoothedRotation = FMath::Lerp(GetActorRotation(), RollRotation, Alpha);
 
 	SetActorRotation(SmoothedRotation);
 }
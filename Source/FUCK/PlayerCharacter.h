@@ -9,7 +9,11 @@
 #include "XPController.h"
 #include "UI/CombatantWidget.h"
 #include "UI/GameOver/UGameOverWidget.h"
+#include "Combat/CombatInputBuffer.h"
+#include "Combat/RegenResource.h"
 #include "PlayerCharacter.generated.h"
+
+struct FStreamableHandle;
 /**
  *
  */
@@ -17,6 +21,7 @@ UCLASS()
 class FUCK_API APlayerCharacter : public ACombatant
 {
 	GENERATED_BODY()
+	DECLARE_MULTICAST_DELEGATE_OneParam(FStaminaChangedSignature, float);
 
 public:
 	// Sets default values for this character's properties
@@ -76,11 +81,21 @@ public:
 
 	void LookAtSmooth();
 
+	virtual void GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const override;
+
 	UFUNCTION(BlueprintCallable)
 	float TakeDamageProjectile(float DamageAmount);
 	float TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent,
 		AController* EventInstigator, AActor* DamageCauser);
 
+	virtual void ApplyHealthDelta(float Delta, AActor* Instigator = nullptr) override;
+
+	virtual void SerializeSaveState(FArchive& Ar, int32 Version) override;
+	virtual bool HasSaveState() const override { return true; }
+	virtual void ResetCombatState() override;
+
+	virtual void OnAttributeChanged(ECombatAttribute Attribute, float Value) override;
+
 	UPROPERTY(EditAnywhere, Category = "Animations")
 	TArray<class UAnimMontage*> Attacks;
 
@@ -104,10 +119,15 @@ public:
 	FVector InputDirection;
 
 	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Stamina")
-	float CurrentStamina;
+	float MaxStamina;
 
+	// Per second while not sprinting, rolling or attacking
 	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Stamina")
-	float MaxStamina;
+	float StaminaRegenRate;
+
+	// Per second while sprinting
+	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Stamina")
+	float SprintCostStamina;
 
 	UPROPERTY(EditAnywhere, BluePrintReadWrite, Category = "Stamina")
 	float RollCostStamina;
@@ -117,6 +137,21 @@ public:
 
 	bool Sprint = false;
 
+	UFUNCTION(BlueprintPure, Category = "Stamina")
+	float GetStamina() const;
+
+	UFUNCTION(BlueprintPure, Category = "Stamina")
+	float GetStaminaRate() const { return Stamina.GetRate(); }
+
+	// Fires on spending, on a rate change and when stamina runs full or empty, UI interpolates in between with the rate
+	FStaminaChangedSignature OnStaminaChanged;
+
+	// Attack / roll presses that arrive mid action are kept this long and fire once the action allows it
+	UPROPERTY(EditAnywhere, Category = "Input")
+	float InputBufferWindow = 0.25f;
+
+	FCombatInputBuffer InputBuffer;
+
 	UFUNCTION()
 	void OnEnemyDetectionBeginOverlap(UPrimitiveComponent* OverlappedComp,
 		AActor* OtherActor, UPrimitiveComponent* OtherComp,
@@ -135,6 +170,7 @@ protected:
 	void MoveRight(float Value);
 
 	void Attack();
+	bool TryAttack();
 	void Jump();
 
 	void StartSprinting();
@@ -148,6 +184,21 @@ protected:
 	void AttackNextReady();
 
 	void Roll();
+	bool TryRoll();
+
+	// runs the newest buffered input if the action it asks for can start now
+	void ConsumeInputBuffer();
+
+	// stamina drains while sprinting, regenerates when idle; only written when that changes
+	void UpdateStaminaRate();
+	void SpendStamina(float Amount);
+	void OnStaminaWritten();
+	void OnStaminaSettled();
+
+	FRegenResource Stamina;
+	FTimerHandle StaminaSettledHandle;
+
+	virtual void EndStumble() override;
 
 	UFUNCTION(BlueprintCallable, Category = "Combat")
 	void StartRoll();
@@ -167,6 +218,9 @@ protected:
 	void ShowPauseMenu();
 	void OnLevelChanged(int Value);
 
+	// keeps the archetype bundles resident while the player is in play
+	TSharedPtr<FStreamableHandle> ArchetypeHandle;
+
 public:
 
 	bool Dead = false;
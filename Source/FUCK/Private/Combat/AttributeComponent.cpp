@@ -0,0 +1,141 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/AttributeComponent.h"
+
+UAttributeComponent::UAttributeComponent()
+{
+	// Values only change through modifiers, nothing here needs a tick
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UAttributeComponent::InitBase(ECombatAttribute Attribute, float Value)
+{
+	Base[(int32)Attribute] = Value;
+	Final[(int32)Attribute] = Evaluate(Attribute);
+}
+
+void UAttributeComponent::SetBase(ECombatAttribute Attribute, float Value)
+{
+	Base[(int32)Attribute] = Value;
+	Recompute(Attribute);
+}
+
+void UAttributeComponent::SetModifier(ECombatAttribute Attribute, FName Source, EAttributeModifierOp Op, float Value)
+{
+	const int32 Index = FindModifier(Attribute, Source);
+
+	if (Index != INDEX_NONE)
+	{
+		if (Ops[Index] == Op && Values[Index] == Value)
+		{
+			return;
+		}
+
+		Ops[Index] = Op;
+		Values[Index] = Value;
+	}
+	else
+	{
+		Sources.Add(Source);
+		Attributes.Add(Attribute);
+		Ops.Add(Op);
+		Values.Add(Value);
+	}
+
+	Recompute(Attribute);
+}
+
+void UAttributeComponent::RemoveModifier(ECombatAttribute Attribute, FName Source)
+{
+	const int32 Index = FindModifier(Attribute, Source);
+
+	if (Index == INDEX_NONE)
+	{
+		return;
+	}
+
+	Sources.RemoveAtSwap(Index, 1, false);
+	Attributes.RemoveAtSwap(Index, 1, false);
+	Ops.RemoveAtSwap(Index, 1, false);
+	Values.RemoveAtSwap(Index, 1, false);
+
+	Recompute(Attribute);
+}
+
+void UAttributeComponent::RemoveModifiersFrom(FName Source)
+{
+	uint32 Changed = 0;
+
+	for (int32 Index = Sources.Num() - 1; Index >= 0; Index--)
+	{
+		if (Sources[Index] == Source)
+		{
+			Changed |= 1u << (uint32)Attributes[Index];
+
+			Sources.RemoveAtSwap(Index, 1, false);
+			Attributes.RemoveAtSwap(Index, 1, false);
+			Ops.RemoveAtSwap(Index, 1, false);
+			Values.RemoveAtSwap(Index, 1, false);
+		}
+	}
+
+	for (int32 Attribute = 0; Attribute < AttributeCount; Attribute++)
+	{
+		if (Changed & (1u << Attribute))
+		{
+			Recompute((ECombatAttribute)Attribute);
+		}
+	}
+}
+
+int32 UAttributeComponent::FindModifier(ECombatAttribute Attribute, FName Source) const
+{
+	for (int32 Index = 0; Index < Sources.Num(); Index++)
+	{
+		if (Attributes[Index] == Attribute && Sources[Index] == Source)
+		{
+			return Index;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+float UAttributeComponent::Evaluate(ECombatAttribute Attribute) const
+{
+	float Added = 0.0f;
+	float Multiplier = 1.0f;
+
+	for (int32 Index = 0; Index < Attributes.Num(); Index++)
+	{
+		if (Attributes[Index] != Attribute)
+		{
+			continue;
+		}
+
+		if (Ops[Index] == EAttributeModifierOp::Add)
+		{
+			Added += Values[Index];
+		}
+		else
+		{
+			Multiplier *= Values[Index];
+		}
+	}
+
+	return (Base[(int32)Attribute] + Added) * Multiplier;
+}
+
+void UAttributeComponent::Recompute(ECombatAttribute Attribute)
+{
+	const float Value = Evaluate(Attribute);
+
+	if (Value == Final[(int32)Attribute])
+	{
+		return;
+	}
+
+	Final[(int32)Attribute] = Value;
+	OnAttributeChanged.Broadcast(Attribute, Value);
+}
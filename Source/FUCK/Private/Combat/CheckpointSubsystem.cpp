@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CheckpointSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "TimerManager.h"
+#include "Combat/EncounterSubsystem.h"
+#include "Save/CombatSaveSubsystem.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/FUCK.h"
+
+bool UCheckpointSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCheckpointSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (UEncounterSubsystem* Encounters = InWorld.GetSubsystem<UEncounterSubsystem>())
+	{
+		EncounterStartedHandle = Encounters->OnEncounterStarted.AddUObject(this, &UCheckpointSubsystem::Capture);
+	}
+
+	// The level start is the first checkpoint, once actors have begun play
+	InWorld.GetTimerManager().SetTimerForNextTick(this, &UCheckpointSubsystem::Capture);
+}
+
+void UCheckpointSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		if (UEncounterSubsystem* Encounters = World->GetSubsystem<UEncounterSubsystem>())
+		{
+			Encounters->OnEncounterStarted.Remove(EncounterStartedHandle);
+		}
+	}
+
+	Snapshots.Empty();
+	Bytes.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCheckpointSubsystem::Capture()
+{
+	Snapshots.Reset();
+	Bytes.Reset();
+
+	FMemoryWriter Ar(Bytes);
+
+	for (TActorIterator<ACombatant> It(GetWorld()); It; ++It)
+	{
+		const AEnemyBase* Enemy = Cast<AEnemyBase>(*It);
+
+		FSnapshot& Snapshot = Snapshots.AddDefaulted_GetRef();
+		Snapshot.Combatant = *It;
+		Snapshot.Transform = It->GetActorTransform();
+		Snapshot.bDead = Enemy && Enemy->ActiveState == State::DEAD;
+		Snapshot.Offset = Bytes.Num();
+
+		It->SerializeSaveState(Ar, UCombatSaveSubsystem::SaveVersion);
+
+		Snapshot.Size = Bytes.Num() - Snapshot.Offset;
+	}
+
+	UE_LOG(LogCityOfMyths, Verbose, TEXT("Checkpoint: %d combatants, %d bytes"), Snapshots.Num(), Bytes.Num());
+}
+
+bool UCheckpointSubsystem::Restore()
+{
+	if (Snapshots.IsEmpty())
+	{
+		return false;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (const FSnapshot& Snapshot : Snapshots)
+	{
+		ACombatant* Combatant = Snapshot.Combatant.Get();
+
+		if (!Combatant)
+		{
+			continue;
+		}
+
+		const AEnemyBase* Enemy = Cast<AEnemyBase>(Combatant);
+
+		if (Snapshot.bDead && Enemy && Enemy->ActiveState == State::DEAD)
+		{
+			continue;
+		}
+
+		Combatant->ResetCombatState();
+		Combatant->SetActorTransform(Snapshot.Transform, false, nullptr, ETeleportType::TeleportPhysics);
+
+		if (Combatant->IsPlayerControlled())
+		{
+			Combatant->GetController()->SetControlRotation(Snapshot.Transform.Rotator());
+		}
+
+		FMemoryReaderView Ar(MakeArrayView(Bytes.GetData() + Snapshot.Offset, Snapshot.Size));
+		Combatant->SerializeSaveState(Ar, UCombatSaveSubsystem::SaveVersion);
+	}
+
+	LastRestoreMilliseconds = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	UE_LOG(LogCityOfMyths, Log, TEXT("Checkpoint restored in %.3f ms"), LastRestoreMilliseconds);
+
+	return true;
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CombatInputBuffer.h"
+
+#include "CoreGlobals.h"
+
+FString FCombatInputLatency::ToString() const
+{
+	return FString::Printf(TEXT("%d immediate, %d buffered (avg %.1f ms / %.2f frames, max %.1f ms), %d expired"),
+		Immediate, Buffered,
+		Buffered > 0 ? TotalBufferedMs / Buffered : 0.0,
+		Buffered > 0 ? (double)TotalBufferedFrames / Buffered : 0.0,
+		MaxBufferedMs, Expired);
+}
+
+void FCombatInputBuffer::Push(double Now, ECombatInputAction Action, int32 Slot)
+{
+	DropExpired(Now);
+
+	if (Entries.Num() == MaxEntries)
+	{
+		Entries.RemoveAt(0, 1, false);
+		Latency.Expired++;
+	}
+
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.Action = Action;
+	Entry.Slot = Slot;
+	Entry.Time = Now;
+	Entry.Frame = GFrameCounter;
+}
+
+bool FCombatInputBuffer::Consume(double Now, TFunctionRef<bool(const FEntry&)> TryExecute)
+{
+	DropExpired(Now);
+
+	if (Entries.IsEmpty())
+	{
+		return false;
+	}
+
+	const FEntry Newest = Entries.Last();
+
+	if (!TryExecute(Newest))
+	{
+		return false;
+	}
+
+	const double LatencyMs = (Now - Newest.Time) * 1000.0;
+
+	Latency.Buffered++;
+	Latency.Expired += Entries.Num() - 1;
+	Latency.TotalBufferedMs += LatencyMs;
+	Latency.MaxBufferedMs = FMath::Max(Latency.MaxBufferedMs, LatencyMs);
+	Latency.TotalBufferedFrames += GFrameCounter - Newest.Frame;
+
+	Entries.Reset();
+	return true;
+}
+
+void FCombatInputBuffer::DropExpired(double Now)
+{
+	const int32 Before = Entries.Num();
+
+	Entries.RemoveAll([this, Now](const FEntry& Entry) { return Now - Entry.Time > Window; });
+
+	Latency.Expired += Before - Entries.Num();
+}
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CombatRandom.h"
+
+// Unseeded sessions still differ from run to run
+int32 FCombatRandom::CurrentSeed = (int32)FPlatformTime::Cycles();
+uint32 FCombatRandom::Generation = 1;
+
+void FCombatRandom::Seed(int32 InSeed)
+{
+	CurrentSeed = InSeed;
+	Generation++;
+}
+
+void FCombatRandomStream::Init(const UObject* Owner)
+{
+	// The name, not the FName index, which differs between processes
+	Key = FCrc::StrCrc32(*Owner->GetName());
+	Generation = 0;
+}
+
+FRandomStream& FCombatRandomStream::Get()
+{
+	if (Generation != FCombatRandom::GetGeneration())
+	{
+		Generation = FCombatRandom::GetGeneration();
+		Stream.Initialize((int32)HashCombine((uint32)FCombatRandom::GetSeed(), Key));
+	}
+
+	return Stream;
+}
+
+int32 FCombatRandomStream::RandRange(int32 Min, int32 Max)
+{
+	return Get().RandRange(Min, Max);
+}
+
+float FCombatRandomStream::FRand()
+{
+	return Get().FRand();
+}
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CombatSimulationSubsystem.h"
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Combat/CombatRandom.h"
+#include "FUCK/FUCK.h"
+
+static FAutoConsoleCommandWithWorldAndArgs FixedStepCommand(
+	TEXT("com.Sim.FixedStep"),
+	TEXT("Runs combat at a fixed step. Usage: com.Sim.FixedStep <hz, 0 turns it off> [unpaced]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UCombatSimulationSubsystem* Simulation = World ? World->GetSubsystem<UCombatSimulationSubsystem>() : nullptr;
+
+		if (!Simulation)
+		{
+			return;
+		}
+
+		const float Rate = Args.Num() > 0 ? FCString::Atof(*Args[0]) : Simulation->StepRate;
+
+		if (Rate > 0.0f)
+		{
+			Simulation->EnableFixedStep(Rate, Args.Num() > 1 && Args[1] == TEXT("unpaced"));
+		}
+		else
+		{
+			Simulation->DisableFixedStep();
+		}
+	}));
+
+bool UCombatSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatSimulationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	FParse::Value(FCommandLine::Get(), TEXT("-CombatSeed="), Seed);
+
+	if (Seed != 0)
+	{
+		FCombatRandom::Seed(Seed);
+	}
+
+	float Rate = StepRate;
+	const bool bCommandLine = FParse::Param(FCommandLine::Get(), TEXT("CombatFixedStep"))
+		|| FParse::Value(FCommandLine::Get(), TEXT("-CombatFixedStep="), Rate);
+
+	if (bFixedStep || bCommandLine)
+	{
+		EnableFixedStep(Rate, bUnpaced || FParse::Param(FCommandLine::Get(), TEXT("CombatUnpaced")));
+	}
+}
+
+void UCombatSimulationSubsystem::Deinitialize()
+{
+	DisableFixedStep();
+
+	Super::Deinitialize();
+}
+
+void UCombatSimulationSubsystem::EnableFixedStep(float InStepRate, bool bInUnpaced)
+{
+	DisableFixedStep();
+
+	StepRate = FMath::Max(InStepRate, 1.0f);
+	bUnpaced = bInUnpaced;
+
+	bWasFixedTimeStep = FApp::UseFixedTimeStep();
+	SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+	bWasFixedFrameRate = GEngine->bUseFixedFrameRate;
+	SavedFixedFrameRate = GEngine->FixedFrameRate;
+	bWasSmoothFrameRate = GEngine->bSmoothFrameRate;
+
+	GEngine->bSmoothFrameRate = false;
+
+	if (bUnpaced)
+	{
+		// The engine takes the fixed delta without waiting for the clock
+		FApp::SetUseFixedTimeStep(true);
+		FApp::SetFixedDeltaTime(1.0 / StepRate);
+	}
+	else
+	{
+		// Waits out the rest of each step, the delta stays fixed when a frame runs long
+		GEngine->bUseFixedFrameRate = true;
+		GEngine->FixedFrameRate = StepRate;
+	}
+
+	bActive = true;
+	StartRealTime = FPlatformTime::Seconds();
+	StartWorldTime = GetWorld()->GetTimeSeconds();
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Combat fixed step: %.1f Hz, %s, seed %d"),
+		StepRate, bUnpaced ? TEXT("unpaced") : TEXT("paced"), FCombatRandom::GetSeed());
+}
+
+void UCombatSimulationSubsystem::DisableFixedStep()
+{
+	if (!bActive)
+	{
+		return;
+	}
+
+	FApp::SetUseFixedTimeStep(bWasFixedTimeStep);
+	FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+	GEngine->bUseFixedFrameRate = bWasFixedFrameRate;
+	GEngine->FixedFrameRate = SavedFixedFrameRate;
+	GEngine->bSmoothFrameRate = bWasSmoothFrameRate;
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Combat fixed step off, ran at %.1fx real time"), GetSpeedup());
+
+	bActive = false;
+}
+
+double UCombatSimulationSubsystem::GetSpeedup() const
+{
+	const double RealSeconds = FPlatformTime::Seconds() - StartRealTime;
+	const UWorld* World = GetWorld();
+
+	if (!bActive || !World || RealSeconds <= 0.0)
+	{
+		return 1.0;
+	}
+
+	return (World->GetTimeSeconds() - StartWorldTime) / RealSeconds;
+}
@@ -0,0 +1,316 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CombatWarmupSubsystem.h"
+
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Camera/CameraShakeBase.h"
+#include "Camera/CameraShake.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "Combat/EncounterSubsystem.h"
+#include "Data/CombatantArchetype.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/FUCK.h"
+#include "FUCK/PlayerCharacter.h"
+#include "SkillBase.h"
+#include "SkillsComponent.h"
+
+namespace CombatWarmup
+{
+	// Warmup effects are spawned well below the player so they never show up on screen
+	const FVector HiddenOffset(0.0f, 0.0f, -10000.0f);
+}
+
+static FAutoConsoleCommandWithWorld CombatWarmupReportCommand(
+	TEXT("com.Warmup.Report"),
+	TEXT("Prints what the combat warmup stage has preloaded so far"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UCombatWarmupSubsystem* Warmup = World ? World->GetSubsystem<UCombatWarmupSubsystem>() : nullptr)
+		{
+			UE_LOG(LogCityOfMyths, Display, TEXT("Combat warmup: %s"), *Warmup->GetReport().ToString());
+		}
+	}));
+
+FString FCombatWarmupReport::ToString() const
+{
+	return FString::Printf(TEXT("%d montages, %d niagara systems, %d camera shakes, %d skills in %.2f ms"),
+		Montages, NiagaraSystems, CameraShakes, Skills, Milliseconds);
+}
+
+bool UCombatWarmupSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatWarmupSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (UEncounterSubsystem* Encounters = InWorld.GetSubsystem<UEncounterSubsystem>())
+	{
+		ArchetypeResidentHandle = Encounters->OnArchetypeResident.AddUObject(this, &UCombatWarmupSubsystem::WarmupArchetype);
+		EnemyNearbyHandle = Encounters->OnEnemyNearby.AddUObject(this, &UCombatWarmupSubsystem::WarmupEnemy);
+	}
+}
+
+void UCombatWarmupSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		if (UEncounterSubsystem* Encounters = World->GetSubsystem<UEncounterSubsystem>())
+		{
+			Encounters->OnArchetypeResident.Remove(ArchetypeResidentHandle);
+			Encounters->OnEnemyNearby.Remove(EnemyNearbyHandle);
+		}
+	}
+
+	Warmed.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCombatWarmupSubsystem::WarmupArchetype(const UCombatantArchetype* Archetype)
+{
+	if (!Archetype)
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// The archetype's montages need an anim instance, WarmupEnemy plays them once an enemy has applied them
+	for (const TSoftObjectPtr<UNiagaraSystem>& Effect : Archetype->Effects)
+	{
+		WarmupNiagara(Effect.Get());
+	}
+
+	Report.Milliseconds += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	UE_LOG(LogCityOfMyths, Log, TEXT("Warmed archetype %s: %s"), *Archetype->GetName(), *Report.ToString());
+}
+
+void UCombatWarmupSubsystem::WarmupEnemy(AEnemyBase* Enemy)
+{
+	if (!Enemy || Warmed.Contains(Enemy->GetClass()) || Enemy->ActiveState != State::IDLE || !Enemy->AreCombatAssetsReady())
+	{
+		return;
+	}
+
+	UAnimInstance* AnimInstance = Enemy->GetMesh()->GetAnimInstance();
+
+	// Tried again on the next encounter update
+	if (!AnimInstance || AnimInstance->IsAnyMontagePlaying())
+	{
+		return;
+	}
+
+	Warmed.Add(Enemy->GetClass());
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<UAnimMontage*> Montages;
+	Enemy->GatherCombatMontages(Montages);
+
+	for (UAnimMontage* Montage : TSet<UAnimMontage*>(Montages))
+	{
+		WarmupMontage(Montage, AnimInstance);
+	}
+
+	TArray<UNiagaraSystem*> Effects;
+	Enemy->GatherCombatEffects(Effects);
+
+	for (UNiagaraSystem* Effect : Effects)
+	{
+		WarmupNiagara(Effect);
+	}
+
+	Report.Milliseconds += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	UE_LOG(LogCityOfMyths, Log, TEXT("Warmed %s: %s"), *Enemy->GetClass()->GetName(), *Report.ToString());
+}
+
+void UCombatWarmupSubsystem::WarmupSkills(const TArray<USkillBase*>& Skills)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// Skill montages play on the player; not while it is in one of its own
+	const ACharacter* Player = UGameplayStatics::GetPlayerCharacter(GetWorld(), 0);
+	UAnimInstance* PlayerAnimInstance = Player ? Player->GetMesh()->GetAnimInstance() : nullptr;
+
+	if (PlayerAnimInstance && PlayerAnimInstance->IsAnyMontagePlaying())
+	{
+		PlayerAnimInstance = nullptr;
+	}
+
+	TArray<FSoftObjectPath> SkillAssets;
+
+	for (const USkillBase* Skill : Skills)
+	{
+		if (!Skill || Warmed.Contains(Skill))
+		{
+			continue;
+		}
+
+		Warmed.Add(Skill);
+		++Report.Skills;
+
+		Skill->GatherSoftAssets(SkillAssets);
+	}
+
+	for (const FSoftObjectPath& Path : SkillAssets)
+	{
+		UObject* Asset = Path.ResolveObject();
+
+		if (UNiagaraSystem* System = Cast<UNiagaraSystem>(Asset))
+		{
+			WarmupNiagara(System);
+		}
+		else if (UAnimMontage* Montage = Cast<UAnimMontage>(Asset))
+		{
+			WarmupMontage(Montage, PlayerAnimInstance);
+		}
+	}
+
+	Report.Milliseconds += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+	UE_LOG(LogCityOfMyths, Log, TEXT("Warmed skills: %s"), *Report.ToString());
+}
+
+void UCombatWarmupSubsystem::WarmupCameraShake(APlayerController* PlayerController, TSubclassOf<UCameraShakeBase> ShakeClass)
+{
+	if (!PlayerController || !PlayerController->PlayerCameraManager || !ShakeClass || Warmed.Contains(ShakeClass.Get()))
+	{
+		return;
+	}
+
+	Warmed.Add(ShakeClass.Get());
+
+	// Stopping immediately hands the instance to the camera manager's expired shake pool,
+	// so the first real hit reuses it instead of constructing one
+	if (UCameraShakeBase* Shake = PlayerController->PlayerCameraManager->StartCameraShake(ShakeClass, KINDA_SMALL_NUMBER))
+	{
+		PlayerController->PlayerCameraManager->StopCameraShake(Shake, true);
+	}
+
+	++Report.CameraShakes;
+}
+
+void UCombatWarmupSubsystem::WarmupMontage(UAnimMontage* Montage, UAnimInstance* AnimInstance)
+{
+	if (!Montage || !AnimInstance || Warmed.Contains(Montage))
+	{
+		return;
+	}
+
+	// Builds the montage instance with its slot, notify and curve setup. Stopped before the
+	// anim instance updates, so no notify fires and no pose is blended in.
+	if (AnimInstance->Montage_Play(Montage) <= 0.0f)
+	{
+		// A montage for another skeleton, it stays cold
+		return;
+	}
+
+	AnimInstance->Montage_Stop(0.0f, Montage);
+
+	Warmed.Add(Montage);
+	++Report.Montages;
+}
+
+void UCombatWarmupSubsystem::WarmupNiagara(UNiagaraSystem* System)
+{
+	if (!System || Warmed.Contains(System))
+	{
+		return;
+	}
+
+	Warmed.Add(System);
+
+	const APawn* Player = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
+	const FVector Location = (Player ? Player->GetActorLocation() : FVector::ZeroVector) + CombatWarmup::HiddenOffset;
+
+	// Activating once initializes the system instance and its render resources, releasing
+	// leaves the component in the world pool for the first real spawn
+	if (UNiagaraComponent* Component = UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), System, Location,
+		FRotator::ZeroRotator, FVector(1.0f), false, true, ENCPoolMethod::ManualRelease, false))
+	{
+		Component->ReleaseToPool();
+	}
+
+	++Report.NiagaraSystems;
+}
+
+void UCombatWarmupSubsystem::GatherFirstUseProbes(TArray<FCombatFirstUseProbe>& OutProbes) const
+{
+	APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerPawn(GetWorld(), 0));
+
+	if (Player)
+	{
+		if (USkillsComponent* Skills = Player->FindComponentByClass<USkillsComponent>())
+		{
+			for (USkillBase* Skill : Skills->skillsObject)
+			{
+				if (Skill)
+				{
+					OutProbes.Add({ Skill->GetClass()->GetName(), [Skill]() { Skill->Cast(); } });
+				}
+			}
+		}
+
+		APlayerController* PlayerController = Player->GetController<APlayerController>();
+
+		if (PlayerController && PlayerController->PlayerCameraManager && Player->CameraShakeMinor)
+		{
+			OutProbes.Add({ Player->CameraShakeMinor->GetName(), [PlayerController, Shake = Player->CameraShakeMinor]()
+			{
+				PlayerController->PlayerCameraManager->StartCameraShake(Shake);
+			} });
+		}
+	}
+
+	if (const UEncounterSubsystem* Encounters = GetWorld()->GetSubsystem<UEncounterSubsystem>())
+	{
+		// One enemy per class is enough, later instances share the montages
+		TSet<UClass*> ProbedClasses;
+
+		for (const TWeakObjectPtr<AEnemyBase>& WeakEnemy : Encounters->GetEnemies())
+		{
+			AEnemyBase* Enemy = WeakEnemy.Get();
+
+			if (!Enemy || ProbedClasses.Contains(Enemy->GetClass()))
+			{
+				continue;
+			}
+
+			ProbedClasses.Add(Enemy->GetClass());
+
+			TArray<UAnimMontage*> Montages;
+			Enemy->GatherCombatMontages(Montages);
+
+			for (UAnimMontage* Montage : TSet<UAnimMontage*>(Montages))
+			{
+				if (!Montage)
+				{
+					continue;
+				}
+
+				OutProbes.Add({ FString::Printf(TEXT("%s.%s"), *Enemy->GetClass()->GetName(), *Montage->GetName()), [WeakEnemy, Montage]()
+				{
+					if (AEnemyBase* ProbedEnemy = WeakEnemy.Get())
+					{
+						ProbedEnemy->PlayAnimMontage(Montage);
+					}
+				} });
+			}
+		}
+	}
+}
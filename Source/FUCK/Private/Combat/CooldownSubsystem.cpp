@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CooldownSubsystem.h"
+
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "Profiling/CombatStats.h"
+
+bool UCooldownSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCooldownSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(WheelTimer);
+	}
+
+	Cooldowns.Empty();
+	FreeCooldowns.Empty();
+
+	Super::Deinitialize();
+}
+
+void UCooldownSubsystem::Start(FCooldownHandle& Handle, float Duration, FSimpleDelegate OnReady)
+{
+	LLM_SCOPE_BYTAG(CityOfMyths_Combat);
+
+	if (!Find(Handle))
+	{
+		Handle.Index = FreeCooldowns.Num() > 0 ? FreeCooldowns.Pop(false) : Cooldowns.AddDefaulted();
+		Handle.Generation = ++Cooldowns[Handle.Index].Generation;
+	}
+
+	FCooldown& Cooldown = Cooldowns[Handle.Index];
+	Cooldown.OnReady = MoveTemp(OnReady);
+	Cooldown.ExpiryTime = GetNow() + FMath::Max(Duration, 0.0f);
+
+	Schedule(Handle.Index);
+}
+
+void UCooldownSubsystem::Reduce(const FCooldownHandle& Handle, float Seconds)
+{
+	FCooldown* Cooldown = Find(Handle);
+
+	if (!Cooldown || Cooldown->WheelEntry == INDEX_NONE)
+	{
+		return;
+	}
+
+	Cooldown->ExpiryTime -= Seconds;
+
+	if (Cooldown->ExpiryTime <= GetNow())
+	{
+		Finish(Handle);
+	}
+	else
+	{
+		Schedule(Handle.Index);
+	}
+}
+
+void UCooldownSubsystem::Finish(const FCooldownHandle& Handle)
+{
+	FCooldown* Cooldown = Find(Handle);
+
+	if (!Cooldown || Cooldown->WheelEntry == INDEX_NONE)
+	{
+		return;
+	}
+
+	Wheel.Cancel(Cooldown->WheelEntry);
+	Cooldown->WheelEntry = INDEX_NONE;
+	Cooldown->ExpiryTime = GetNow();
+
+	ArmTimer();
+	Expire(Handle.Index);
+}
+
+void UCooldownSubsystem::Free(FCooldownHandle& Handle)
+{
+	if (FCooldown* Cooldown = Find(Handle))
+	{
+		Wheel.Cancel(Cooldown->WheelEntry);
+		Cooldown->WheelEntry = INDEX_NONE;
+		Cooldown->OnReady.Unbind();
+		++Cooldown->Generation;
+
+		FreeCooldowns.Add(Handle.Index);
+		ArmTimer();
+	}
+
+	Handle = FCooldownHandle();
+}
+
+float UCooldownSubsystem::GetRemaining(const FCooldownHandle& Handle) const
+{
+	const FCooldown* Cooldown = Find(Handle);
+
+	return Cooldown ? FMath::Max((float)(Cooldown->ExpiryTime - GetNow()), 0.0f) : 0.0f;
+}
+
+UCooldownSubsystem::FCooldown* UCooldownSubsystem::Find(const FCooldownHandle& Handle)
+{
+	return Cooldowns.IsValidIndex(Handle.Index) && Cooldowns[Handle.Index].Generation == Handle.Generation ? &Cooldowns[Handle.Index] : nullptr;
+}
+
+const UCooldownSubsystem::FCooldown* UCooldownSubsystem::Find(const FCooldownHandle& Handle) const
+{
+	return Cooldowns.IsValidIndex(Handle.Index) && Cooldowns[Handle.Index].Generation == Handle.Generation ? &Cooldowns[Handle.Index] : nullptr;
+}
+
+void UCooldownSubsystem::Schedule(int32 Index)
+{
+	FCooldown& Cooldown = Cooldowns[Index];
+
+	Wheel.Cancel(Cooldown.WheelEntry);
+
+	// An idle wheel may lag far behind the clock, catch it up so the new entry lands in the right block
+	if (Wheel.Num() == 0)
+	{
+		Wheel.Advance(ToTick(GetNow()), [](int32) {});
+	}
+
+	Cooldown.WheelEntry = Wheel.Schedule((uint64)FMath::CeilToDouble(Cooldown.ExpiryTime * TicksPerSecond), Index);
+
+	ArmTimer();
+}
+
+void UCooldownSubsystem::Expire(int32 Index)
+{
+	Cooldowns[Index].WheelEntry = INDEX_NONE;
+
+	// The callback may start this or another cooldown and grow the array
+	const FSimpleDelegate OnReady = Cooldowns[Index].OnReady;
+	OnReady.ExecuteIfBound();
+}
+
+void UCooldownSubsystem::ArmTimer()
+{
+	UWorld* World = GetWorld();
+	const uint64 NextTick = Wheel.GetNextEventTick();
+
+	if (NextTick == MAX_uint64)
+	{
+		World->GetTimerManager().ClearTimer(WheelTimer);
+		return;
+	}
+
+	const float Delay = (float)(NextTick / TicksPerSecond - GetNow());
+	World->GetTimerManager().SetTimer(WheelTimer, this, &UCooldownSubsystem::OnWheelTimer, FMath::Max(Delay, 0.001f), false);
+}
+
+void UCooldownSubsystem::OnWheelTimer()
+{
+	COM_SCOPE(STAT_COM_Cooldowns);
+
+	Wheel.Advance(ToTick(GetNow()), [this](int32 Index) { Expire(Index); });
+
+	ArmTimer();
+}
+
+double UCooldownSubsystem::GetNow() const
+{
+	return GetWorld()->GetTimeSeconds();
+}
+
+uint64 UCooldownSubsystem::ToTick(double Time) const
+{
+	// Small bias so a timer landing a hair before its tick still counts as on it
+	return (uint64)FMath::FloorToDouble(Time * TicksPerSecond + KINDA_SMALL_NUMBER);
+}
@@ -0,0 +1,197 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/CooldownTimingWheel.h"
+
+FCooldownTimingWheel::FCooldownTimingWheel()
+{
+	for (int32 Level = 0; Level < LevelCount; Level++)
+	{
+		Occupied[Level] = 0;
+
+		for (int32 Slot = 0; Slot < SlotCount; Slot++)
+		{
+			Heads[Level][Slot] = INDEX_NONE;
+		}
+	}
+}
+
+int32 FCooldownTimingWheel::Schedule(uint64 ExpiryTick, int32 Payload)
+{
+	const int32 EntryId = FreeEntries.Num() > 0 ? FreeEntries.Pop(false) : Entries.AddDefaulted();
+
+	FEntry& Entry = Entries[EntryId];
+	Entry.ExpiryTick = FMath::Clamp(ExpiryTick, CurrentTick + 1, CurrentTick + MaxRange - 1);
+	Entry.Payload = Payload;
+
+	Link(EntryId);
+	++Count;
+
+	return EntryId;
+}
+
+void FCooldownTimingWheel::Cancel(int32 EntryId)
+{
+	if (!Entries.IsValidIndex(EntryId) || Entries[EntryId].Level == INDEX_NONE)
+	{
+		return;
+	}
+
+	Unlink(EntryId);
+	Entries[EntryId].Payload = INDEX_NONE;
+	FreeEntries.Add(EntryId);
+	--Count;
+}
+
+void FCooldownTimingWheel::Advance(uint64 ToTick, TFunctionRef<void(int32 Payload)> OnExpired)
+{
+	while (CurrentTick < ToTick)
+	{
+		// Nothing to cascade or fire, an idle wheel can skip ahead in one go
+		if (Count == 0)
+		{
+			CurrentTick = ToTick;
+			return;
+		}
+
+		// Jump straight to the next occupied level 0 slot, never past a block boundary so cascades aren't missed
+		uint64 NextTick = (CurrentTick | (SlotCount - 1)) + 1;
+
+		const uint64 Ahead = Occupied[0] & ~(((uint64)2 << GetSlot(CurrentTick, 0)) - 1);
+		if (Ahead)
+		{
+			NextTick = FMath::Min(NextTick, (CurrentTick & ~(uint64)(SlotCount - 1)) + FMath::CountTrailingZeros64(Ahead));
+		}
+
+		CurrentTick = FMath::Min(NextTick, ToTick);
+
+		if (GetSlot(CurrentTick, 0) == 0)
+		{
+			// Every level whose lower digits all rolled over brings its current slot down, highest first
+			int32 TopLevel = 1;
+			while (TopLevel + 1 < LevelCount && GetSlot(CurrentTick, TopLevel) == 0)
+			{
+				TopLevel++;
+			}
+
+			for (int32 Level = TopLevel; Level >= 1; Level--)
+			{
+				Cascade(Level, GetSlot(CurrentTick, Level));
+			}
+		}
+
+		const int32 Slot = GetSlot(CurrentTick, 0);
+
+		// Callbacks may schedule again, those land at CurrentTick + 1 at the earliest and never in this slot
+		while (Heads[0][Slot] != INDEX_NONE)
+		{
+			const int32 EntryId = Heads[0][Slot];
+			const int32 Payload = Entries[EntryId].Payload;
+
+			Cancel(EntryId);
+			OnExpired(Payload);
+		}
+	}
+}
+
+uint64 FCooldownTimingWheel::GetNextEventTick() const
+{
+	if (Count == 0)
+	{
+		return MAX_uint64;
+	}
+
+	// Lower levels always fire before the next cascade of a higher one
+	for (int32 Level = 0; Level < LevelCount; Level++)
+	{
+		if (!Occupied[Level])
+		{
+			continue;
+		}
+
+		const int32 Shift = SlotBits * Level;
+		const uint64 Block = CurrentTick >> (Shift + SlotBits);
+		const uint64 Ahead = Occupied[Level] & ~(((uint64)2 << GetSlot(CurrentTick, Level)) - 1);
+
+		if (Ahead)
+		{
+			return ((Block << SlotBits) + FMath::CountTrailingZeros64(Ahead)) << Shift;
+		}
+
+		// Only the top level holds entries that wrapped into the next block
+		return (((Block + 1) << SlotBits) + FMath::CountTrailingZeros64(Occupied[Level])) << Shift;
+	}
+
+	return MAX_uint64;
+}
+
+void FCooldownTimingWheel::Link(int32 EntryId)
+{
+	FEntry& Entry = Entries[EntryId];
+
+	// Lowest level whose block also contains the current tick
+	int32 Level = 0;
+	while (Level + 1 < LevelCount && (Entry.ExpiryTick >> (SlotBits * (Level + 1))) != (CurrentTick >> (SlotBits * (Level + 1))))
+	{
+		Level++;
+	}
+
+	const int32 Slot = GetSlot(Entry.ExpiryTick, Level);
+
+	Entry.Level = (int8)Level;
+	Entry.Slot = (uint8)Slot;
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = Heads[Level][Slot];
+
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = EntryId;
+	}
+
+	Heads[Level][Slot] = EntryId;
+	Occupied[Level] |= (uint64)1 << Slot;
+}
+
+void FCooldownTimingWheel::Unlink(int32 EntryId)
+{
+	FEntry& Entry = Entries[EntryId];
+
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		Heads[Entry.Level][Entry.Slot] = Entry.Next;
+	}
+
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+
+	if (Heads[Entry.Level][Entry.Slot] == INDEX_NONE)
+	{
+		Occupied[Entry.Level] &= ~((uint64)1 << Entry.Slot);
+	}
+
+	Entry.Level = INDEX_NONE;
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = INDEX_NONE;
+}
+
+void FCooldownTimingWheel::Cascade(int32 Level, int32 Slot)
+{
+	int32 EntryId = Heads[Level][Slot];
+
+	Heads[Level][Slot] = INDEX_NONE;
+	Occupied[Level] &= ~((uint64)1 << Slot);
+
+	// Everything here now shares the current block at this level, so it relinks strictly lower
+	while (EntryId != INDEX_NONE)
+	{
+		const int32 Next = Entries[EntryId].Next;
+		Link(EntryId);
+		EntryId = Next;
+	}
+}
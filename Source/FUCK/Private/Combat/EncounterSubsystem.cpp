@@ -0,0 +1,215 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/EncounterSubsystem.h"
+
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Data/CombatantArchetype.h"
+#include "Profiling/CombatStats.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/FUCK.h"
+
+void UEncounterSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	InWorld.GetTimerManager().SetTimer(UpdateHandle, this, &UEncounterSubsystem::UpdateEncounter, UpdateInterval, true, 0.0f);
+}
+
+void UEncounterSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(UpdateHandle);
+	}
+
+	if (UAssetManager* AssetManager = UAssetManager::GetIfValid())
+	{
+		for (const TPair<FPrimaryAssetId, FArchetypeLoad>& Load : Loads)
+		{
+			AssetManager->UnloadPrimaryAsset(Load.Key);
+		}
+	}
+
+	Loads.Empty();
+	Preloaded.Empty();
+	Enemies.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UEncounterSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEncounterSubsystem::RegisterEnemy(AEnemyBase* Enemy)
+{
+	if (Enemy)
+	{
+		Enemies.AddUnique(Enemy);
+	}
+}
+
+void UEncounterSubsystem::UnregisterEnemy(AEnemyBase* Enemy)
+{
+	ReleaseArchetype(Enemy);
+	Enemies.Remove(Enemy);
+}
+
+void UEncounterSubsystem::UpdateEncounter()
+{
+	COM_SCOPE(STAT_COM_Encounter);
+	LLM_SCOPE_BYTAG(CityOfMyths_Combat);
+
+	const APawn* Player = UGameplayStatics::GetPlayerPawn(GetWorld(), 0);
+
+	Enemies.RemoveAll([](const TWeakObjectPtr<AEnemyBase>& Enemy) { return !Enemy.IsValid(); });
+
+	bool AnyEngaged = false;
+	int32 Engaged = 0;
+
+	for (const TWeakObjectPtr<AEnemyBase>& WeakEnemy : Enemies)
+	{
+		AEnemyBase* Enemy = WeakEnemy.Get();
+
+		if (Enemy->ActiveState == State::DEAD)
+		{
+			// Dead enemies keep their assets until the encounter is over
+			continue;
+		}
+
+		if (Enemy->ActiveState != State::IDLE)
+		{
+			AnyEngaged = true;
+			Engaged++;
+		}
+
+		if (!Player)
+		{
+			continue;
+		}
+
+		const float Distance = FVector::Distance(Player->GetActorLocation(), Enemy->GetActorLocation());
+
+		if (Distance <= PreloadDistance)
+		{
+			AcquireArchetype(Enemy);
+			OnEnemyNearby.Broadcast(Enemy);
+		}
+		else if (Distance > ReleaseDistance && Enemy->ActiveState == State::IDLE)
+		{
+			ReleaseArchetype(Enemy);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_COM_RegisteredEnemies, Enemies.Num());
+	SET_DWORD_STAT(STAT_COM_EngagedEnemies, Engaged);
+
+	if (AnyEngaged && !bEncounterActive)
+	{
+		bEncounterActive = true;
+		OnEncounterStarted.Broadcast();
+	}
+	else if (!AnyEngaged && bEncounterActive)
+	{
+		bEncounterActive = false;
+
+		for (const TWeakObjectPtr<AEnemyBase>& WeakEnemy : Enemies)
+		{
+			if (WeakEnemy->ActiveState == State::DEAD)
+			{
+				ReleaseArchetype(WeakEnemy.Get());
+			}
+		}
+
+		OnEncounterEnded.Broadcast();
+	}
+}
+
+void UEncounterSubsystem::AcquireArchetype(AEnemyBase* Enemy)
+{
+	if (!Enemy->Archetype || Preloaded.Contains(Enemy))
+	{
+		return;
+	}
+
+	Preloaded.Add(Enemy);
+
+	const FPrimaryAssetId ArchetypeId = Enemy->Archetype->GetPrimaryAssetId();
+	FArchetypeLoad& Load = Loads.FindOrAdd(ArchetypeId);
+	Load.Users.Add(Enemy);
+
+	if (Load.bLoaded)
+	{
+		Enemy->ApplyArchetypeAssets();
+		return;
+	}
+
+	if (!Load.Handle.IsValid())
+	{
+		Load.Handle = UAssetManager::Get().LoadPrimaryAsset(ArchetypeId, UCombatantArchetype::GetEncounterBundles(),
+			FStreamableDelegate::CreateUObject(this, &UEncounterSubsystem::OnArchetypeLoaded, ArchetypeId));
+
+		// No handle means everything was already resident (or the archetype is not scanned)
+		if (!Load.Handle.IsValid() || Load.Handle->HasLoadCompleted())
+		{
+			OnArchetypeLoaded(ArchetypeId);
+		}
+	}
+}
+
+void UEncounterSubsystem::ReleaseArchetype(AEnemyBase* Enemy)
+{
+	if (!Enemy || !Preloaded.Remove(Enemy))
+	{
+		return;
+	}
+
+	Enemy->ReleaseArchetypeAssets();
+
+	const FPrimaryAssetId ArchetypeId = Enemy->Archetype->GetPrimaryAssetId();
+	FArchetypeLoad* Load = Loads.Find(ArchetypeId);
+
+	if (!Load)
+	{
+		return;
+	}
+
+	Load->Users.Remove(Enemy);
+
+	if (Load->Users.IsEmpty())
+	{
+		Loads.Remove(ArchetypeId);
+		UAssetManager::Get().UnloadPrimaryAsset(ArchetypeId);
+	}
+}
+
+void UEncounterSubsystem::OnArchetypeLoaded(FPrimaryAssetId ArchetypeId)
+{
+	FArchetypeLoad* Load = Loads.Find(ArchetypeId);
+
+	if (!Load || Load->bLoaded)
+	{
+		return;
+	}
+
+	Load->bLoaded = true;
+
+	UE_LOG(LogCityOfMyths, Verbose, TEXT("Archetype %s resident for %d enemies"), *ArchetypeId.ToString(), Load->Users.Num());
+
+	if (const UCombatantArchetype* Archetype = UAssetManager::Get().GetPrimaryAssetObject<UCombatantArchetype>(ArchetypeId))
+	{
+		OnArchetypeResident.Broadcast(Archetype);
+	}
+
+	for (const TWeakObjectPtr<AEnemyBase>& User : Load->Users)
+	{
+		if (AEnemyBase* Enemy = User.Get())
+		{
+			Enemy->ApplyArchetypeAssets();
+		}
+	}
+}
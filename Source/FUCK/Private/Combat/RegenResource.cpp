@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/RegenResource.h"
+
+void FRegenResource::Init(float InMax, float InValue, double Now)
+{
+	Max = InMax;
+	Rate = 0.0f;
+	Set(InValue, Now);
+}
+
+float FRegenResource::Get(double Now) const
+{
+	return FMath::Clamp(Value + Rate * (float)(Now - Time), 0.0f, Max);
+}
+
+void FRegenResource::Set(float NewValue, double Now)
+{
+	Value = FMath::Clamp(NewValue, 0.0f, Max);
+	Time = Now;
+}
+
+bool FRegenResource::SetRate(float NewRate, double Now)
+{
+	if (Rate == NewRate)
+	{
+		return false;
+	}
+
+	Set(Get(Now), Now);
+	Rate = NewRate;
+	return true;
+}
+
+void FRegenResource::SetMax(float NewMax, double Now)
+{
+	const float Current = Get(Now);
+
+	Max = FMath::Max(NewMax, 0.0f);
+	Set(Current, Now);
+}
+
+double FRegenResource::TimeUntil(float Threshold, double Now) const
+{
+	const float Current = Get(Now);
+
+	if (Current == Threshold)
+	{
+		return 0.0;
+	}
+
+	if (Rate == 0.0f)
+	{
+		return -1.0;
+	}
+
+	const double Seconds = (Threshold - Current) / Rate;
+	return Seconds >= 0.0 ? Seconds : -1.0;
+}
+
+double FRegenResource::TimeUntilSettled(double Now) const
+{
+	if (Rate == 0.0f)
+	{
+		return -1.0;
+	}
+
+	const double Seconds = TimeUntil(Rate > 0.0f ? Max : 0.0f, Now);
+	return Seconds > 0.0 ? Seconds : -1.0;
+}
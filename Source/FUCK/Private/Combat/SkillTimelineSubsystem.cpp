@@ -0,0 +1,419 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/SkillTimelineSubsystem.h"
+
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "TimerManager.h"
+#include "FUCK/Combatant.h"
+#include "Profiling/CombatStats.h"
+#include "FUCK/FUCK.h"
+
+static FAutoConsoleCommandWithWorld SkillTimelineStatsCommand(
+	TEXT("com.Skills.TimelineStats"),
+	TEXT("Prints how many skill timelines are running and the time spent in their steps"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const USkillTimelineSubsystem* Timelines = World ? World->GetSubsystem<USkillTimelineSubsystem>() : nullptr)
+		{
+			const int32 Steps = Timelines->GetStepCount();
+			UE_LOG(LogCityOfMyths, Display, TEXT("Skill timelines: %d running, %d steps in %.3f ms (%.4f ms per step)"),
+				Timelines->GetRunningCount(), Steps, Timelines->GetStepMilliseconds(), Steps > 0 ? Timelines->GetStepMilliseconds() / Steps : 0.0);
+		}
+	}));
+
+FSkillTimeline& FSkillTimeline::Then(TFunction<void()> Action)
+{
+	FStep& Step = Steps.AddDefaulted_GetRef();
+	Step.Type = EStep::Call;
+	Step.Action = [Action = MoveTemp(Action)](int32) { Action(); };
+	return *this;
+}
+
+FSkillTimeline& FSkillTimeline::Delay(float Seconds)
+{
+	FStep& Step = Steps.AddDefaulted_GetRef();
+	Step.Type = EStep::Delay;
+	Step.Seconds = Seconds;
+	return *this;
+}
+
+FSkillTimeline& FSkillTimeline::Every(float Interval, int32 Count, TFunction<void(int32)> Action)
+{
+	FStep& Step = Steps.AddDefaulted_GetRef();
+	Step.Type = EStep::Every;
+	Step.Seconds = Interval;
+	Step.Count = Count;
+	Step.Action = MoveTemp(Action);
+	return *this;
+}
+
+FSkillTimeline& FSkillTimeline::WaitNotify(FName NotifyName, float Timeout)
+{
+	FStep& Step = Steps.AddDefaulted_GetRef();
+	Step.Type = EStep::Notify;
+	Step.Seconds = Timeout;
+	Step.NotifyName = NotifyName;
+	return *this;
+}
+
+FSkillTimeline& FSkillTimeline::WaitForHit(float Timeout)
+{
+	FStep& Step = Steps.AddDefaulted_GetRef();
+	Step.Type = EStep::Hit;
+	Step.Seconds = Timeout;
+	return *this;
+}
+
+bool USkillTimelineSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void USkillTimelineSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(WakeTimer);
+	}
+
+	Timelines.Empty();
+	Wakes.Empty();
+	ReleaseHits();
+
+	Super::Deinitialize();
+}
+
+FSkillTimelineHandle USkillTimelineSubsystem::Run(UObject* Owner, ACombatant* Caster, FSkillTimeline&& Timeline)
+{
+	LLM_SCOPE_BYTAG(CityOfMyths_Skills);
+
+	FSkillTimelineHandle Handle;
+
+	if (!Owner || Timeline.Steps.IsEmpty())
+	{
+		return Handle;
+	}
+
+	FRunningTimeline Running;
+	Running.Steps = MakeShared<const TArray<FSkillTimeline::FStep>>(MoveTemp(Timeline.Steps));
+	Running.Owner = Owner;
+	Running.Caster = Caster;
+	Running.Serial = NextSerial++;
+
+	Handle.Index = Timelines.Add(MoveTemp(Running));
+	Handle.Serial = Timelines[Handle.Index].Serial;
+
+	Step(Handle.Index);
+
+	return Handle;
+}
+
+void USkillTimelineSubsystem::Cancel(const FSkillTimelineHandle& Handle)
+{
+	if (Find(Handle))
+	{
+		Finish(Handle.Index);
+	}
+}
+
+int32 USkillTimelineSubsystem::CancelAll(const UObject* Owner)
+{
+	int32 Cancelled = 0;
+
+	for (auto It = Timelines.CreateIterator(); It; ++It)
+	{
+		if (It->Owner.Get() == Owner)
+		{
+			It.RemoveCurrent();
+			Cancelled++;
+		}
+	}
+
+	ReleaseHits();
+
+	return Cancelled;
+}
+
+bool USkillTimelineSubsystem::IsRunning(const FSkillTimelineHandle& Handle) const
+{
+	return Timelines.IsValidIndex(Handle.Index) && Timelines[Handle.Index].Serial == Handle.Serial;
+}
+
+USkillTimelineSubsystem::FRunningTimeline* USkillTimelineSubsystem::Find(const FSkillTimelineHandle& Handle)
+{
+	return IsRunning(Handle) ? &Timelines[Handle.Index] : nullptr;
+}
+
+void USkillTimelineSubsystem::Step(int32 Index)
+{
+	const FSkillTimelineHandle Handle{ Index, Timelines[Index].Serial };
+
+	// Actions may cancel their own timeline or start others, so look it up again after each one
+	while (FRunningTimeline* Timeline = Find(Handle))
+	{
+		if (!Timeline->Owner.IsValid() || Timeline->StepIndex >= Timeline->Steps->Num())
+		{
+			Finish(Index);
+			return;
+		}
+
+		const FSkillTimeline::FStep& Current = (*Timeline->Steps)[Timeline->StepIndex];
+		ACombatant* Caster = Timeline->Caster.Get();
+
+		switch (Current.Type)
+		{
+		case FSkillTimeline::EStep::Call:
+			RunAction(Index, Timeline->StepIndex++, 0);
+			break;
+
+		case FSkillTimeline::EStep::Delay:
+			WaitFor(Index, EWait::Time, Current.Seconds);
+			return;
+
+		case FSkillTimeline::EStep::Every:
+			if (Current.Count <= 0)
+			{
+				Timeline->StepIndex++;
+				break;
+			}
+
+			Timeline->Repeat = 0;
+			WaitFor(Index, EWait::Time, Current.Seconds);
+			return;
+
+		case FSkillTimeline::EStep::Notify:
+		case FSkillTimeline::EStep::Hit:
+			// Nothing to listen to without a caster
+			if (!Caster)
+			{
+				Timeline->StepIndex++;
+				break;
+			}
+
+			if (Current.Type == FSkillTimeline::EStep::Notify)
+			{
+				BindNotify(Caster);
+				WaitFor(Index, EWait::Notify, Current.Seconds);
+			}
+			else
+			{
+				BindHit(Caster);
+				WaitFor(Index, EWait::Hit, Current.Seconds);
+			}
+			return;
+		}
+	}
+}
+
+void USkillTimelineSubsystem::Resume(int32 Index)
+{
+	FRunningTimeline& Timeline = Timelines[Index];
+
+	if (!Timeline.Owner.IsValid())
+	{
+		Finish(Index);
+		return;
+	}
+
+	const FSkillTimeline::FStep& Current = (*Timeline.Steps)[Timeline.StepIndex];
+
+	Timeline.Wait = EWait::None;
+	Timeline.WaitId++;
+
+	if (Current.Type == FSkillTimeline::EStep::Every)
+	{
+		const FSkillTimelineHandle Handle{ Index, Timeline.Serial };
+		const int32 Count = Current.Count;
+		const float Interval = Current.Seconds;
+
+		RunAction(Index, Timeline.StepIndex, Timeline.Repeat++);
+
+		FRunningTimeline* Running = Find(Handle);
+		if (!Running)
+		{
+			return;
+		}
+
+		if (Running->Repeat < Count)
+		{
+			WaitFor(Index, EWait::Time, Interval);
+			return;
+		}
+	}
+
+	Timelines[Index].StepIndex++;
+	Step(Index);
+}
+
+void USkillTimelineSubsystem::Finish(int32 Index)
+{
+	Timelines.RemoveAt(Index);
+	ReleaseHits();
+}
+
+void USkillTimelineSubsystem::WaitFor(int32 Index, EWait Wait, float Seconds)
+{
+	FRunningTimeline& Timeline = Timelines[Index];
+	Timeline.Wait = Wait;
+	Timeline.WaitId++;
+
+	// An event that never comes must not hold the timeline forever
+	if (Wait != EWait::Time && Seconds <= 0.f)
+	{
+		Seconds = FSkillTimeline::MaxEventWait;
+	}
+
+	FWake Wake;
+	Wake.Time = GetWorld()->GetTimeSeconds() + FMath::Max(Seconds, 0.f);
+	Wake.Index = Index;
+	Wake.Serial = Timeline.Serial;
+	Wake.WaitId = Timeline.WaitId;
+
+	Wakes.HeapPush(Wake);
+	ArmTimer();
+}
+
+void USkillTimelineSubsystem::RunAction(int32 Index, int32 StepIndex, int32 Argument)
+{
+	// Keeps the action alive even if it cancels this timeline
+	const TSharedPtr<const TArray<FSkillTimeline::FStep>> Steps = Timelines[Index].Steps;
+	const FSkillTimeline::FStep& Current = (*Steps)[StepIndex];
+
+	if (!Current.Action)
+	{
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	Current.Action(Argument);
+
+	StepMilliseconds += FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	StepCount++;
+}
+
+void USkillTimelineSubsystem::BindNotify(ACombatant* Caster)
+{
+	if (UAnimInstance* AnimInstance = Caster->GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->OnPlayMontageNotifyBegin.AddUniqueDynamic(this, &USkillTimelineSubsystem::OnMontageNotify);
+	}
+}
+
+void USkillTimelineSubsystem::BindHit(ACombatant* Caster)
+{
+	if (!HitBound.Contains(TObjectKey<ACombatant>(Caster)))
+	{
+		HitBound.Add(TObjectKey<ACombatant>(Caster), Caster->OnAttackHit.AddUObject(this, &USkillTimelineSubsystem::OnAttackHit, Caster));
+	}
+}
+
+void USkillTimelineSubsystem::ReleaseHits()
+{
+	for (auto It = HitBound.CreateIterator(); It; ++It)
+	{
+		ACombatant* Caster = It->Key.ResolveObjectPtr();
+
+		if (Caster)
+		{
+			bool bRunning = false;
+
+			for (const FRunningTimeline& Timeline : Timelines)
+			{
+				if (Timeline.Caster.Get() == Caster)
+				{
+					bRunning = true;
+					break;
+				}
+			}
+
+			if (bRunning)
+			{
+				continue;
+			}
+
+			Caster->OnAttackHit.Remove(It->Value);
+		}
+
+		It.RemoveCurrent();
+	}
+}
+
+void USkillTimelineSubsystem::OnMontageNotify(FName NotifyName, const FBranchingPointNotifyPayload& Payload)
+{
+	if (Payload.SkelMeshComponent)
+	{
+		ResumeWaiting(Payload.SkelMeshComponent->GetOwner(), EWait::Notify, NotifyName);
+	}
+}
+
+void USkillTimelineSubsystem::OnAttackHit(AActor* HitActor, ACombatant* Caster)
+{
+	ResumeWaiting(Caster, EWait::Hit, NAME_None);
+}
+
+void USkillTimelineSubsystem::ResumeWaiting(const AActor* Caster, EWait Wait, FName NotifyName)
+{
+	COM_SCOPE(STAT_COM_SkillTimelines);
+
+	TArray<FSkillTimelineHandle> Waiting;
+
+	for (auto It = Timelines.CreateConstIterator(); It; ++It)
+	{
+		if (It->Wait == Wait && It->Caster.Get() == Caster
+			&& (Wait != EWait::Notify || (*It->Steps)[It->StepIndex].NotifyName == NotifyName))
+		{
+			Waiting.Add({ It.GetIndex(), It->Serial });
+		}
+	}
+
+	for (const FSkillTimelineHandle& Handle : Waiting)
+	{
+		const FRunningTimeline* Timeline = Find(Handle);
+
+		if (Timeline && Timeline->Wait == Wait)
+		{
+			Resume(Handle.Index);
+		}
+	}
+}
+
+void USkillTimelineSubsystem::ArmTimer()
+{
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+
+	if (Wakes.IsEmpty())
+	{
+		TimerManager.ClearTimer(WakeTimer);
+		return;
+	}
+
+	const float Delay = (float)(Wakes.HeapTop().Time - GetWorld()->GetTimeSeconds());
+	TimerManager.SetTimer(WakeTimer, this, &USkillTimelineSubsystem::OnWakeTimer, FMath::Max(Delay, 0.001f), false);
+}
+
+void USkillTimelineSubsystem::OnWakeTimer()
+{
+	COM_SCOPE(STAT_COM_SkillTimelines);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	while (!Wakes.IsEmpty() && Wakes.HeapTop().Time <= Now + KINDA_SMALL_NUMBER)
+	{
+		FWake Wake;
+		Wakes.HeapPop(Wake, false);
+
+		const FRunningTimeline* Timeline = Find({ Wake.Index, Wake.Serial });
+
+		// Stale wakes belong to a wait that already ended through its event
+		if (Timeline && Timeline->WaitId == Wake.WaitId && Timeline->Wait != EWait::None)
+		{
+			Resume(Wake.Index);
+		}
+	}
+
+	ArmTimer();
+}
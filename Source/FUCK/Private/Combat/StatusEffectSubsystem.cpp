@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Combat/StatusEffectSubsystem.h"
+
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "FUCK/Combatant.h"
+#include "Profiling/CombatStats.h"
+
+bool UStatusEffectSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStatusEffectSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(UpdateHandle);
+	}
+
+	Super::Deinitialize();
+}
+
+void UStatusEffectSubsystem::ApplyEffect(ACombatant* Target, const FStatusEffectSpec& Spec, AActor* Instigator)
+{
+	LLM_SCOPE_BYTAG(CityOfMyths_Combat);
+
+	if (!Target || Spec.Duration <= 0.0f)
+	{
+		return;
+	}
+
+	const int32 TargetIndex = AddTarget(Target);
+
+	if (Spec.Stacking != EStatusEffectStacking::Independent)
+	{
+		const int32 Existing = FindEffect(TargetIndex, Spec.Id);
+
+		if (Existing != INDEX_NONE)
+		{
+			HealthRates[Existing] = Spec.HealthPerSecond;
+			Magnitudes[Existing] = Spec.Magnitude;
+			Remaining[Existing] = Spec.Duration;
+			Instigators[Existing] = Instigator;
+
+			if (Spec.Stacking == EStatusEffectStacking::Stack)
+			{
+				Stacks[Existing] = FMath::Min(Stacks[Existing] + 1, FMath::Max(Spec.MaxStacks, 1));
+			}
+
+			return;
+		}
+	}
+
+	TargetIndices.Add(TargetIndex);
+	Ids.Add(Spec.Id);
+	HealthRates.Add(Spec.HealthPerSecond);
+	Magnitudes.Add(Spec.Magnitude);
+	Remaining.Add(Spec.Duration);
+	Stacks.Add(1);
+	Instigators.Add(Instigator);
+
+	TargetEffectCounts[TargetIndex]++;
+
+	FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+
+	if (!TimerManager.IsTimerActive(UpdateHandle))
+	{
+		LastUpdateTime = GetWorld()->GetTimeSeconds();
+		TimerManager.SetTimer(UpdateHandle, this, &UStatusEffectSubsystem::UpdateEffects, UpdateInterval, true);
+	}
+}
+
+void UStatusEffectSubsystem::RemoveEffect(ACombatant* Target, FName Id)
+{
+	const int32 TargetIndex = FindTarget(Target);
+
+	for (int32 i = Ids.Num() - 1; TargetIndex != INDEX_NONE && i >= 0; i--)
+	{
+		if (TargetIndices[i] == TargetIndex && Ids[i] == Id)
+		{
+			RemoveEffectAt(i);
+		}
+	}
+}
+
+void UStatusEffectSubsystem::RemoveAllEffects(ACombatant* Target)
+{
+	const int32 TargetIndex = FindTarget(Target);
+
+	for (int32 i = Ids.Num() - 1; TargetIndex != INDEX_NONE && i >= 0; i--)
+	{
+		if (TargetIndices[i] == TargetIndex)
+		{
+			RemoveEffectAt(i);
+		}
+	}
+}
+
+int32 UStatusEffectSubsystem::GetStackCount(const ACombatant* Target, FName Id) const
+{
+	const int32 TargetIndex = FindTarget(Target);
+	int32 Count = 0;
+
+	for (int32 i = 0; TargetIndex != INDEX_NONE && i < Ids.Num(); i++)
+	{
+		if (TargetIndices[i] == TargetIndex && Ids[i] == Id)
+		{
+			Count += Stacks[i];
+		}
+	}
+
+	return Count;
+}
+
+float UStatusEffectSubsystem::GetMagnitude(const ACombatant* Target, FName Id) const
+{
+	const int32 TargetIndex = FindTarget(Target);
+	float Magnitude = 0.0f;
+
+	for (int32 i = 0; TargetIndex != INDEX_NONE && i < Ids.Num(); i++)
+	{
+		if (TargetIndices[i] == TargetIndex && Ids[i] == Id)
+		{
+			Magnitude += Magnitudes[i] * Stacks[i];
+		}
+	}
+
+	return Magnitude;
+}
+
+int32 UStatusEffectSubsystem::FindTarget(const ACombatant* Target) const
+{
+	const int32* Index = TargetLookup.Find(TObjectKey<ACombatant>(Target));
+	return Index ? *Index : INDEX_NONE;
+}
+
+int32 UStatusEffectSubsystem::AddTarget(ACombatant* Target)
+{
+	int32 Index = FindTarget(Target);
+
+	if (Index != INDEX_NONE)
+	{
+		return Index;
+	}
+
+	if (FreeTargets.Num() > 0)
+	{
+		Index = FreeTargets.Pop(false);
+		Targets[Index] = TObjectKey<ACombatant>(Target);
+		TargetEffectCounts[Index] = 0;
+		PendingHealth[Index] = 0.0f;
+		PendingInstigators[Index].Reset();
+	}
+	else
+	{
+		Index = Targets.Add(TObjectKey<ACombatant>(Target));
+		TargetEffectCounts.Add(0);
+		PendingHealth.Add(0.0f);
+		PendingInstigators.AddDefaulted();
+	}
+
+	TargetLookup.Add(Targets[Index], Index);
+	return Index;
+}
+
+int32 UStatusEffectSubsystem::FindEffect(int32 TargetIndex, FName Id) const
+{
+	for (int32 i = 0; i < Ids.Num(); i++)
+	{
+		if (TargetIndices[i] == TargetIndex && Ids[i] == Id)
+		{
+			return i;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+void UStatusEffectSubsystem::RemoveEffectAt(int32 Index)
+{
+	const int32 TargetIndex = TargetIndices[Index];
+
+	TargetIndices.RemoveAtSwap(Index, 1, false);
+	Ids.RemoveAtSwap(Index, 1, false);
+	HealthRates.RemoveAtSwap(Index, 1, false);
+	Magnitudes.RemoveAtSwap(Index, 1, false);
+	Remaining.RemoveAtSwap(Index, 1, false);
+	Stacks.RemoveAtSwap(Index, 1, false);
+	Instigators.RemoveAtSwap(Index, 1, false);
+
+	if (--TargetEffectCounts[TargetIndex] == 0)
+	{
+		TargetLookup.Remove(Targets[TargetIndex]);
+		Targets[TargetIndex] = TObjectKey<ACombatant>();
+		PendingHealth[TargetIndex] = 0.0f;
+		PendingInstigators[TargetIndex].Reset();
+		FreeTargets.Add(TargetIndex);
+	}
+}
+
+void UStatusEffectSubsystem::UpdateEffects()
+{
+	COM_SCOPE(STAT_COM_StatusEffects);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float DeltaTime = (float)(Now - LastUpdateTime);
+	LastUpdateTime = Now;
+
+	for (int32 i = 0; i < Ids.Num(); i++)
+	{
+		// The last step only counts the part of the interval the effect was still running
+		PendingHealth[TargetIndices[i]] += HealthRates[i] * Stacks[i] * FMath::Min(DeltaTime, Remaining[i]);
+		Remaining[i] -= DeltaTime;
+
+		if (HealthRates[i] < 0.0f && Instigators[i].IsValid())
+		{
+			PendingInstigators[TargetIndices[i]] = Instigators[i];
+		}
+	}
+
+	// One health change per combatant. Death can remove effects, so slots are only cleared, never shifted.
+	for (int32 Index = 0; Index < Targets.Num(); Index++)
+	{
+		const float Delta = PendingHealth[Index];
+
+		if (Delta == 0.0f)
+		{
+			continue;
+		}
+
+		PendingHealth[Index] = 0.0f;
+		AActor* Instigator = PendingInstigators[Index].Get();
+		PendingInstigators[Index].Reset();
+
+		if (ACombatant* Target = Targets[Index].ResolveObjectPtr())
+		{
+			Target->ApplyHealthDelta(Delta, Instigator);
+		}
+	}
+
+	for (int32 i = Ids.Num() - 1; i >= 0; i--)
+	{
+		if (Remaining[i] <= 0.0f || !Targets[TargetIndices[i]].ResolveObjectPtr())
+		{
+			RemoveEffectAt(i);
+		}
+	}
+
+	if (Ids.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(UpdateHandle);
+	}
+}
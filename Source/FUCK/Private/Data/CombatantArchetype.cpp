@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Data/CombatantArchetype.h"
+
+const FPrimaryAssetType UCombatantArchetype::PrimaryAssetType = TEXT("CombatantArchetype");
+
+const FName UCombatantArchetype::CombatBundle = TEXT("Combat");
+const FName UCombatantArchetype::DeathBundle = TEXT("Death");
+const FName UCombatantArchetype::FXBundle = TEXT("FX");
+
+FPrimaryAssetId UCombatantArchetype::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+TArray<FName> UCombatantArchetype::GetEncounterBundles()
+{
+	return { CombatBundle, DeathBundle, FXBundle };
+}
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatBalanceGameMode.h"
+
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "TimerManager.h"
+#include "Combat/CombatRandom.h"
+#include "Combat/CombatSimulationSubsystem.h"
+#include "Profiling/CombatBenchmarkGameMode.h"
+#include "Profiling/CombatBotComponent.h"
+#include "FUCK/CombatManager.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/FUCK.h"
+#include "FUCK/PlayerCharacter.h"
+
+const TCHAR* ACombatBalanceGameMode::CsvHeader = TEXT("Win,Seconds,TimeToKill,DamageTaken,PlayerHealth,EnemiesKilled,Enemies");
+
+ACombatBalanceGameMode::ACombatBalanceGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	// The game over screen may pause the game
+	PrimaryActorTick.bTickEvenWhenPaused = true;
+}
+
+void ACombatBalanceGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	Androids = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Androids"), Androids), 0);
+	Mechs = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Mechs"), Mechs), 0);
+	Bosses = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Bosses"), Bosses), 0);
+	TimeLimit = FMath::Max(CombatBenchmark::GetFloatOption(Options, TEXT("TimeLimit"), TimeLimit), 1.0f);
+	StepRate = FMath::Max(CombatBenchmark::GetFloatOption(Options, TEXT("StepRate"), StepRate), 1.0f);
+	Seed = UGameplayStatics::GetIntOption(Options, TEXT("Seed"), Seed);
+
+	FString Remaining = Options;
+	FString Option;
+
+	while (UGameplayStatics::GrabOption(Remaining, Option))
+	{
+		FString Key, Value, Target, Property;
+		UGameplayStatics::GetKeyValue(Option, Key, Value);
+
+		if (Key.Split(TEXT("."), &Target, &Property))
+		{
+			Overrides.FindOrAdd(Target).Add(FName(*Property), FCString::Atof(*Value));
+		}
+	}
+
+	OutputPath = UGameplayStatics::ParseOption(Options, TEXT("Output"));
+
+	if (OutputPath.IsEmpty())
+	{
+		OutputPath = FPaths::Combine(FPaths::ProfilingDir(), FString::Printf(TEXT("CombatBalance_%s_A%d_M%d_B%d_%d.csv"),
+			*FPaths::GetBaseFilename(MapName), Androids, Mechs, Bosses, Seed));
+	}
+}
+
+UClass* ACombatBalanceGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+	if (UClass* Class = PlayerClass.LoadSynchronous())
+	{
+		return Class;
+	}
+
+	return Super::GetDefaultPawnClassForController_Implementation(InController);
+}
+
+void ACombatBalanceGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(this, 0));
+
+	if (!Player.IsValid())
+	{
+		UE_LOG(LogCityOfMyths, Error, TEXT("Combat balance: no APlayerCharacter to fight with, check PlayerClass"));
+		FPlatformMisc::RequestExitWithStatus(false, 1);
+		return;
+	}
+
+	// Before anything draws from the streams
+	FCombatRandom::Seed(Seed);
+
+	if (UCombatSimulationSubsystem* Simulation = GetWorld()->GetSubsystem<UCombatSimulationSubsystem>())
+	{
+		Simulation->EnableFixedStep(StepRate, true);
+	}
+
+	APlayerCharacter* Character = Player.Get();
+	ApplyOverrides(Character, TEXT("Player"));
+
+	// The player is already in play, its base attributes were read in BeginPlay
+	if (const TMap<FName, float>* PlayerOverrides = Overrides.Find(TEXT("Player")))
+	{
+		if (const float* Value = PlayerOverrides->Find(TEXT("MaxHealth")))
+		{
+			Character->Attributes->SetBase(ECombatAttribute::MaxHealth, *Value);
+		}
+
+		if (const float* Value = PlayerOverrides->Find(TEXT("ClassDamage")))
+		{
+			Character->Attributes->SetBase(ECombatAttribute::Damage, *Value);
+		}
+	}
+
+	Character->SetHealth(Character->GetMaxHealth());
+	LastHealth = Character->GetHealth();
+	Character->HealthChanged.AddUObject(this, &ACombatBalanceGameMode::OnPlayerHealthChanged);
+
+	if (UCombatManager* Manager = Character->FindComponentByClass<UCombatManager>())
+	{
+		ApplyOverrides(Manager, TEXT("CombatManager"));
+		GetWorldTimerManager().SetTimer(Manager->attackCDHandle, Manager, &UCombatManager::NextAttacker, Manager->attackCooldown, true);
+	}
+
+	TMap<UClass*, FString> Targets;
+	TArray<UClass*> Classes;
+
+	auto AddClass = [&Classes, &Targets](const TSoftClassPtr<AEnemyBase>& SoftClass, int32 Count, const TCHAR* Target)
+	{
+		UClass* Class = Count > 0 ? SoftClass.LoadSynchronous() : nullptr;
+
+		if (Count > 0 && !Class)
+		{
+			UE_LOG(LogCityOfMyths, Warning, TEXT("Combat balance: can't load %s, %d enemies skipped"), *SoftClass.ToString(), Count);
+			return;
+		}
+
+		Targets.Add(Class, Target);
+
+		for (int32 i = 0; i < Count; i++)
+		{
+			Classes.Add(Class);
+		}
+	};
+
+	AddClass(BossClass, Bosses, TEXT("Boss"));
+	AddClass(MechClass, Mechs, TEXT("Mech"));
+	AddClass(AndroidClass, Androids, TEXT("Android"));
+
+	// Before BeginPlay, so MaxHealth and ClassDamage become the attribute bases
+	ACombatBenchmarkGameMode::SpawnEnemyRings(GetWorld(), Character->GetActorLocation(), Classes, MinSpawnRadius, SpawnSpacing,
+		[this, &Targets](AEnemyBase* Enemy)
+		{
+			ApplyOverrides(Enemy, Targets.FindRef(Enemy->GetClass()));
+		}, Enemies);
+
+	UCombatBotComponent::Toggle(GetWorld(), Seed);
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Combat balance: %d androids, %d mechs, %d bosses, seed %d, %g Hz, %d overridden targets"),
+		Androids, Mechs, Bosses, Seed, StepRate, Overrides.Num());
+}
+
+void ACombatBalanceGameMode::ApplyOverrides(UObject* Object, const FString& Target) const
+{
+	const TMap<FName, float>* TargetOverrides = Overrides.Find(Target);
+
+	if (!TargetOverrides)
+	{
+		return;
+	}
+
+	for (const TPair<FName, float>& Override : *TargetOverrides)
+	{
+		if (FFloatProperty* Property = FindFProperty<FFloatProperty>(Object->GetClass(), Override.Key))
+		{
+			Property->SetPropertyValue_InContainer(Object, Override.Value);
+		}
+		else
+		{
+			UE_LOG(LogCityOfMyths, Warning, TEXT("Combat balance: %s has no float property %s"), *Object->GetClass()->GetName(), *Override.Key.ToString());
+		}
+	}
+}
+
+void ACombatBalanceGameMode::OnPlayerHealthChanged(float Health)
+{
+	// Heals don't pay back damage taken
+	DamageTaken += FMath::Max(LastHealth - Health, 0.0f);
+	LastHealth = Health;
+}
+
+void ACombatBalanceGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bFinished || !Player.IsValid())
+	{
+		return;
+	}
+
+	Elapsed += DeltaSeconds;
+
+	const bool bAllDead = !Enemies.ContainsByPredicate([](const TWeakObjectPtr<AEnemyBase>& Enemy)
+	{
+		return Enemy.IsValid() && Enemy->ActiveState != State::DEAD;
+	});
+
+	if (Player->Dead)
+	{
+		Finish(false);
+	}
+	else if (bAllDead)
+	{
+		Finish(true);
+	}
+	else if (Elapsed >= TimeLimit)
+	{
+		Finish(false);
+	}
+}
+
+void ACombatBalanceGameMode::Finish(bool bWin)
+{
+	bFinished = true;
+
+	const int32 Killed = Enemies.FilterByPredicate([](const TWeakObjectPtr<AEnemyBase>& Enemy)
+	{
+		return !Enemy.IsValid() || Enemy->ActiveState == State::DEAD;
+	}).Num();
+
+	// Time to kill is left empty for fights that weren't won
+	const FString Row = FString::Printf(TEXT("%d,%.3f,%s,%.1f,%.1f,%d,%d"), bWin ? 1 : 0, Elapsed,
+		bWin ? *FString::Printf(TEXT("%.3f"), Elapsed) : TEXT(""), DamageTaken, Player->GetHealth(), Killed, Enemies.Num());
+
+	const bool bWritten = FFileHelper::SaveStringToFile(FString::Printf(TEXT("%s\n%s\n"), CsvHeader, *Row), *OutputPath);
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Combat balance: %s after %.1f s, %d of %d killed, %.0f damage taken, %s %s"),
+		bWin ? TEXT("won") : TEXT("lost"), Elapsed, Killed, Enemies.Num(), DamageTaken,
+		bWritten ? TEXT("written to") : TEXT("failed to write"), *OutputPath);
+
+	FPlatformMisc::RequestExitWithStatus(false, bWritten ? 0 : 1);
+}
@@ -0,0 +1,541 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatBenchmarkGameMode.h"
+
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "NavigationSystem.h"
+#include "RenderCore.h"
+#include "Profiling/CombatBotComponent.h"
+#include "Profiling/CombatPerfGate.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/FUCK.h"
+#include "FUCK/PlayerCharacter.h"
+
+#if STATS
+#include "Stats/StatsData.h"
+#endif
+
+namespace CombatBenchmark
+{
+	const FName ImmortalSource(TEXT("Benchmark"));
+
+	// Scenarios of a gate run that failed so far, kept across the map reloads between them
+	int32 FailedScenarios = 0;
+
+	// Nearest rank percentile of an ascending array
+	float Percentile(const TArray<float>& Sorted, float Fraction)
+	{
+		if (Sorted.IsEmpty())
+		{
+			return 0.0f;
+		}
+
+		const int32 Index = FMath::Clamp(FMath::CeilToInt(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+		return Sorted[Index];
+	}
+
+	FString Distribution(TArray<float> Values)
+	{
+		Values.Sort();
+
+		double Sum = 0.0;
+		for (const float Value : Values)
+		{
+			Sum += Value;
+		}
+
+		return FString::Printf(TEXT("{ \"avg\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }"),
+			Values.IsEmpty() ? 0.0 : Sum / Values.Num(), Percentile(Values, 0.5f), Percentile(Values, 0.9f),
+			Percentile(Values, 0.95f), Percentile(Values, 0.99f), Values.IsEmpty() ? 0.0f : Values.Last());
+	}
+
+	double ToMegabytes(uint64 Bytes)
+	{
+		return Bytes / (1024.0 * 1024.0);
+	}
+
+	float GetFloatOption(const FString& Options, const TCHAR* Key, float Default)
+	{
+		const FString Value = UGameplayStatics::ParseOption(Options, Key);
+		return Value.IsEmpty() ? Default : FCString::Atof(*Value);
+	}
+
+	uint64 GetAllocationCount()
+	{
+#if !UE_BUILD_SHIPPING
+		return FMalloc::TotalMallocCalls.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+}
+
+ACombatBenchmarkGameMode::ACombatBenchmarkGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+void ACombatBenchmarkGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	bGate = UGameplayStatics::HasOption(Options, TEXT("Gate"));
+	bUpdateBaselines = UGameplayStatics::HasOption(Options, TEXT("UpdateBaselines"));
+	ScenarioName = UGameplayStatics::ParseOption(Options, TEXT("Scenario"));
+
+	if (ScenarioName.IsEmpty() && (bGate || bUpdateBaselines) && !Scenarios.IsEmpty())
+	{
+		ScenarioName = Scenarios[0].Name;
+	}
+
+	if (!ScenarioName.IsEmpty())
+	{
+		const FCombatBenchScenario* Scenario = Scenarios.FindByPredicate([this](const FCombatBenchScenario& Candidate)
+		{
+			return Candidate.Name == ScenarioName;
+		});
+
+		if (Scenario)
+		{
+			Androids = Scenario->Androids;
+			Mechs = Scenario->Mechs;
+			Bosses = Scenario->Bosses;
+		}
+		else
+		{
+			UE_LOG(LogCityOfMyths, Warning, TEXT("Combat bench: no scenario named %s"), *ScenarioName);
+		}
+	}
+
+	// Explicit counts win over the scenario's
+	Androids = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Androids"), Androids), 0);
+	Mechs = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Mechs"), Mechs), 0);
+	Bosses = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Bosses"), Bosses), 0);
+	Duration = FMath::Max(CombatBenchmark::GetFloatOption(Options, TEXT("Duration"), Duration), 1.0f);
+	Warmup = FMath::Max(CombatBenchmark::GetFloatOption(Options, TEXT("Warmup"), Warmup), 0.0f);
+	Seed = UGameplayStatics::GetIntOption(Options, TEXT("Seed"), Seed);
+
+	OutputPath = UGameplayStatics::ParseOption(Options, TEXT("Output"));
+
+	if (OutputPath.IsEmpty() && !ScenarioName.IsEmpty())
+	{
+		OutputPath = FPaths::Combine(FPaths::ProfilingDir(), FString::Printf(TEXT("CombatBench_%s.json"), *ScenarioName));
+	}
+	else if (OutputPath.IsEmpty())
+	{
+		OutputPath = FPaths::Combine(FPaths::ProfilingDir(), FString::Printf(TEXT("CombatBench_%s_A%d_M%d_B%d.json"),
+			*FPaths::GetBaseFilename(MapName), Androids, Mechs, Bosses));
+	}
+}
+
+UClass* ACombatBenchmarkGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+	if (UClass* Class = PlayerClass.LoadSynchronous())
+	{
+		return Class;
+	}
+
+	return Super::GetDefaultPawnClassForController_Implementation(InController);
+}
+
+void ACombatBenchmarkGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(this, 0));
+
+	if (!Player.IsValid())
+	{
+		UE_LOG(LogCityOfMyths, Error, TEXT("Combat bench: no APlayerCharacter to fight with, check PlayerClass"));
+		FPlatformMisc::RequestExitWithStatus(false, 1);
+		return;
+	}
+
+	if (bImmortalPlayer)
+	{
+		Player->Attributes->SetModifier(ECombatAttribute::MaxHealth, CombatBenchmark::ImmortalSource, EAttributeModifierOp::Add, 1000000.0f);
+		Player->SetHealth(Player->GetMaxHealth());
+	}
+
+	SpawnEnemies();
+
+	UCombatBotComponent::Toggle(GetWorld(), Seed);
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &ACombatBenchmarkGameMode::OnWorldTickStart);
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &ACombatBenchmarkGameMode::OnWorldPreActorTick);
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ACombatBenchmarkGameMode::OnWorldPostActorTick);
+
+#if STATS
+	// Fills FLatestGameThreadStatsData with the group every frame; nothing is drawn without a renderer
+	GEngine->Exec(GetWorld(), TEXT("stat CityOfMyths"));
+#endif
+
+	Samples.Reserve(FMath::CeilToInt(Duration * 240.0f));
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Combat bench: %d androids, %d mechs, %d bosses, %.0f s warmup, %.0f s measured, seed %d"),
+		Androids, Mechs, Bosses, Warmup, Duration, Seed);
+}
+
+void ACombatBenchmarkGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACombatBenchmarkGameMode::SpawnEnemies()
+{
+	TArray<UClass*> Classes;
+	Classes.Reserve(Androids + Mechs + Bosses);
+
+	// Bigger enemies take the inner rings
+	auto AddClass = [&Classes](const TSoftClassPtr<AEnemyBase>& SoftClass, int32 Count)
+	{
+		UClass* Class = Count > 0 ? SoftClass.LoadSynchronous() : nullptr;
+
+		if (Count > 0 && !Class)
+		{
+			UE_LOG(LogCityOfMyths, Warning, TEXT("Combat bench: can't load %s, %d enemies skipped"), *SoftClass.ToString(), Count);
+			return;
+		}
+
+		for (int32 i = 0; i < Count; i++)
+		{
+			Classes.Add(Class);
+		}
+	};
+
+	AddClass(BossClass, Bosses);
+	AddClass(MechClass, Mechs);
+	AddClass(AndroidClass, Androids);
+
+	SpawnEnemyRings(GetWorld(), Player->GetActorLocation(), Classes, MinSpawnRadius, SpawnSpacing, [](AEnemyBase*) {}, Enemies);
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Combat bench: spawned %d of %d enemies"), Enemies.Num(), Classes.Num());
+}
+
+void ACombatBenchmarkGameMode::SpawnEnemyRings(UWorld* World, const FVector& Center, const TArray<UClass*>& Classes, float MinRadius, float Spacing,
+	TFunctionRef<void(AEnemyBase*)> Configure, TArray<TWeakObjectPtr<AEnemyBase>>& OutEnemies)
+{
+	const UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+
+	float Radius = MinRadius;
+	int32 RingStart = 0;
+	int32 RingSize = FMath::Max(FMath::FloorToInt(UE_TWO_PI * Radius / Spacing), 1);
+
+	for (int32 i = 0; i < Classes.Num(); i++)
+	{
+		if (i - RingStart >= RingSize)
+		{
+			RingStart = i;
+			Radius += Spacing;
+			RingSize = FMath::Max(FMath::FloorToInt(UE_TWO_PI * Radius / Spacing), 1);
+		}
+
+		const float Angle = UE_TWO_PI * (i - RingStart) / RingSize;
+		FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Radius;
+
+		FNavLocation NavLocation;
+		if (NavSystem && NavSystem->ProjectPointToNavigation(Location, NavLocation))
+		{
+			Location = NavLocation.Location + FVector(0.0f, 0.0f, Classes[i]->GetDefaultObject<AEnemyBase>()->GetSimpleCollisionHalfHeight());
+		}
+
+		const FRotator Rotation = (Center - Location).GetSafeNormal2D().Rotation();
+		const FTransform Transform(Rotation, Location);
+
+		if (AEnemyBase* Enemy = World->SpawnActorDeferred<AEnemyBase>(Classes[i], Transform, nullptr, nullptr,
+			ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn))
+		{
+			Configure(Enemy);
+			Enemy->FinishSpawning(Transform);
+
+			if (!Enemy->GetController())
+			{
+				Enemy->SpawnDefaultController();
+			}
+
+			OutEnemies.Add(Enemy);
+		}
+	}
+}
+
+void ACombatBenchmarkGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bFinished || !Player.IsValid())
+	{
+		return;
+	}
+
+	Elapsed += DeltaSeconds;
+
+	APlayerCharacter* Character = Player.Get();
+
+	if (bImmortalPlayer && Character->GetHealth() < Character->GetMaxHealth() * 0.5f)
+	{
+		Character->SetHealth(Character->GetMaxHealth());
+	}
+
+	if (!bMeasuring && Elapsed >= Warmup)
+	{
+		bMeasuring = true;
+		PeakUsedPhysical = StartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+		LastAllocations = CombatBenchmark::GetAllocationCount();
+	}
+
+	if (bMeasuring && Elapsed >= Warmup + Duration)
+	{
+		Finish();
+	}
+}
+
+void ACombatBenchmarkGameMode::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	if (bMeasuring && !bFinished && TickStartCycles != 0)
+	{
+		Sample();
+	}
+
+	TickStartCycles = FPlatformTime::Cycles64();
+	PreActorTickCycles = PostActorTickCycles = TickStartCycles;
+}
+
+void ACombatBenchmarkGameMode::OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		PreActorTickCycles = FPlatformTime::Cycles64();
+	}
+}
+
+void ACombatBenchmarkGameMode::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		PostActorTickCycles = FPlatformTime::Cycles64();
+	}
+}
+
+void ACombatBenchmarkGameMode::Sample()
+{
+	FFrameSample& Frame = Samples.AddDefaulted_GetRef();
+	Frame.FrameMs = FApp::GetDeltaTime() * 1000.0;
+	Frame.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Frame.PreActorTickMs = FPlatformTime::ToMilliseconds64(PreActorTickCycles - TickStartCycles);
+	Frame.ActorTickMs = FPlatformTime::ToMilliseconds64(PostActorTickCycles - PreActorTickCycles);
+	Frame.OtherMs = FMath::Max(Frame.GameThreadMs - Frame.PreActorTickMs - Frame.ActorTickMs, 0.0f);
+
+	const uint64 Allocations = CombatBenchmark::GetAllocationCount();
+	Frame.Allocations = (uint32)(Allocations - LastAllocations);
+	LastAllocations = Allocations;
+
+	PeakUsedPhysical = FMath::Max(PeakUsedPhysical, FPlatformMemory::GetStats().UsedPhysical);
+
+	SampleCombatStats();
+}
+
+void ACombatBenchmarkGameMode::SampleCombatStats()
+{
+#if STATS
+	const FGameThreadStatsData* StatsData = FLatestGameThreadStatsData::Get().Latest;
+
+	if (!StatsData)
+	{
+		return;
+	}
+
+	const FName GroupName(TEXT("STATGROUP_CityOfMyths"));
+
+	for (int32 GroupIndex = 0; GroupIndex < StatsData->ActiveStatGroups.Num(); GroupIndex++)
+	{
+		if (!StatsData->GroupNames.IsValidIndex(GroupIndex) || StatsData->GroupNames[GroupIndex] != GroupName)
+		{
+			continue;
+		}
+
+		for (const FComplexStatMessage& Message : StatsData->ActiveStatGroups[GroupIndex].FlatAggregate)
+		{
+			if (Message.NameAndInfo.GetFlag(EStatMetaFlags::IsCycle))
+			{
+				CombatStatMs.FindOrAdd(Message.GetDescription()) += FPlatformTime::ToMilliseconds(Message.GetValue_Duration(EComplexStatField::IncAve));
+			}
+		}
+
+		CombatStatSamples++;
+	}
+#endif
+}
+
+void ACombatBenchmarkGameMode::Finish()
+{
+	bFinished = true;
+
+	const FString Report = BuildReport();
+	const bool bWritten = FFileHelper::SaveStringToFile(Report, *OutputPath);
+
+	if (bWritten)
+	{
+		UE_LOG(LogCityOfMyths, Display, TEXT("Combat bench: %d frames written to %s"), Samples.Num(), *OutputPath);
+	}
+	else
+	{
+		UE_LOG(LogCityOfMyths, Error, TEXT("Combat bench: failed to write %s"), *OutputPath);
+	}
+
+	const bool bGateRun = bGate || bUpdateBaselines;
+
+	if (!bWritten || (bGateRun && !RunGate(Report)))
+	{
+		CombatBenchmark::FailedScenarios++;
+	}
+
+	if (bGateRun && TravelToNextScenario())
+	{
+		return;
+	}
+
+	if (bGate)
+	{
+		UE_LOG(LogCityOfMyths, Display, TEXT("Combat perf gate: %s (%d scenarios failed)"),
+			CombatBenchmark::FailedScenarios > 0 ? TEXT("FAILED") : TEXT("passed"), CombatBenchmark::FailedScenarios);
+	}
+
+	FPlatformMisc::RequestExitWithStatus(false, CombatBenchmark::FailedScenarios > 0 ? 1 : 0);
+}
+
+bool ACombatBenchmarkGameMode::RunGate(const FString& Report)
+{
+	const FString BaselinePath = GetBaselinePath();
+
+	if (bUpdateBaselines)
+	{
+		const bool bSaved = FFileHelper::SaveStringToFile(Report, *BaselinePath);
+		UE_LOG(LogCityOfMyths, Display, TEXT("Combat perf gate: %s baseline %s"), bSaved ? TEXT("updated") : TEXT("failed to write"), *BaselinePath);
+		return bSaved;
+	}
+
+	FString Baseline;
+
+	if (!FFileHelper::LoadFileToString(Baseline, *BaselinePath))
+	{
+		// a scenario without a baseline would pass every regression unnoticed
+		UE_LOG(LogCityOfMyths, Error, TEXT("Combat perf gate: no baseline %s for %s, run with ?UpdateBaselines to create it"), *BaselinePath, *ScenarioName);
+		return false;
+	}
+
+	FCombatPerfGateThresholds Thresholds;
+	Thresholds.GameThreadP95 = GateGameThreadP95Tolerance;
+	Thresholds.AllocationsPerFrame = GateAllocationsTolerance;
+	Thresholds.MemoryMB = GateMemoryToleranceMB;
+
+	TArray<FString> Failures;
+
+	if (FCombatPerfGate::Compare(Report, Baseline, Thresholds, Failures))
+	{
+		UE_LOG(LogCityOfMyths, Display, TEXT("Combat perf gate: %s passed"), *ScenarioName);
+		return true;
+	}
+
+	for (const FString& Failure : Failures)
+	{
+		UE_LOG(LogCityOfMyths, Error, TEXT("Combat perf gate: %s regressed, %s"), *ScenarioName, *Failure);
+	}
+
+	return false;
+}
+
+FString ACombatBenchmarkGameMode::GetBaselinePath() const
+{
+	return FPaths::Combine(FPaths::ProjectDir(), BaselineDir, ScenarioName + TEXT(".json"));
+}
+
+bool ACombatBenchmarkGameMode::TravelToNextScenario()
+{
+	const int32 Index = Scenarios.IndexOfByPredicate([this](const FCombatBenchScenario& Candidate)
+	{
+		return Candidate.Name == ScenarioName;
+	});
+
+	if (Index == INDEX_NONE || Index + 1 >= Scenarios.Num())
+	{
+		return false;
+	}
+
+	const FString Options = FString::Printf(TEXT("game=%s?Scenario=%s?Duration=%g?Warmup=%g?Seed=%d?%s"), *GetClass()->GetPathName(),
+		*Scenarios[Index + 1].Name, Duration, Warmup, Seed, bUpdateBaselines ? TEXT("UpdateBaselines") : TEXT("Gate"));
+
+	UGameplayStatics::OpenLevel(this, FName(*UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName())), true, Options);
+	return true;
+}
+
+FString ACombatBenchmarkGameMode::BuildReport() const
+{
+	TArray<float> FrameMs;
+	TArray<float> GameThreadMs;
+	TArray<float> Allocations;
+	double PreActorTickMs = 0.0;
+	double ActorTickMs = 0.0;
+	double OtherMs = 0.0;
+
+	for (const FFrameSample& Frame : Samples)
+	{
+		FrameMs.Add(Frame.FrameMs);
+		GameThreadMs.Add(Frame.GameThreadMs);
+		Allocations.Add(Frame.Allocations);
+		PreActorTickMs += Frame.PreActorTickMs;
+		ActorTickMs += Frame.ActorTickMs;
+		OtherMs += Frame.OtherMs;
+	}
+
+	const int32 FrameCount = FMath::Max(Samples.Num(), 1);
+
+	int32 Alive = 0;
+	for (const TWeakObjectPtr<AEnemyBase>& Enemy : Enemies)
+	{
+		Alive += Enemy.IsValid() && Enemy->ActiveState != State::DEAD;
+	}
+
+	const FPlatformMemoryStats Memory = FPlatformMemory::GetStats();
+
+	FString Json = TEXT("{\n");
+	Json += FString::Printf(TEXT("\t\"map\": \"%s\",\n"), *UWorld::RemovePIEPrefix(GetWorld()->GetMapName()));
+	Json += FString::Printf(TEXT("\t\"androids\": %d,\n\t\"mechs\": %d,\n\t\"bosses\": %d,\n"), Androids, Mechs, Bosses);
+	Json += FString::Printf(TEXT("\t\"enemiesSpawned\": %d,\n\t\"enemiesAlive\": %d,\n"), Enemies.Num(), Alive);
+	Json += FString::Printf(TEXT("\t\"durationSeconds\": %.1f,\n\t\"frames\": %d,\n"), Duration, Samples.Num());
+	Json += FString::Printf(TEXT("\t\"frameMs\": %s,\n"), *CombatBenchmark::Distribution(FrameMs));
+	Json += FString::Printf(TEXT("\t\"gameThreadMs\": %s,\n"), *CombatBenchmark::Distribution(GameThreadMs));
+	Json += FString::Printf(TEXT("\t\"gameThreadBreakdownMs\": { \"preActorTick\": %.3f, \"actorTick\": %.3f, \"other\": %.3f },\n"),
+		PreActorTickMs / FrameCount, ActorTickMs / FrameCount, OtherMs / FrameCount);
+
+	Json += TEXT("\t\"combatScopesMs\": {");
+	int32 ScopeIndex = 0;
+	for (const TPair<FString, double>& Scope : CombatStatMs)
+	{
+		Json += FString::Printf(TEXT("%s\n\t\t\"%s\": %.4f"), ScopeIndex++ > 0 ? TEXT(",") : TEXT(""), *Scope.Key,
+			Scope.Value / FMath::Max(CombatStatSamples, 1));
+	}
+	Json += ScopeIndex > 0 ? TEXT("\n\t},\n") : TEXT(" },\n");
+
+	Json += FString::Printf(TEXT("\t\"allocationsPerFrame\": %s,\n"), *CombatBenchmark::Distribution(Allocations));
+	Json += FString::Printf(TEXT("\t\"memoryMB\": { \"usedPhysicalStart\": %.1f, \"usedPhysicalEnd\": %.1f, \"usedPhysicalPeak\": %.1f, \"usedVirtual\": %.1f }\n"),
+		CombatBenchmark::ToMegabytes(StartUsedPhysical), CombatBenchmark::ToMegabytes(Memory.UsedPhysical),
+		CombatBenchmark::ToMegabytes(PeakUsedPhysical), CombatBenchmark::ToMegabytes(Memory.UsedVirtual));
+	Json += TEXT("}\n");
+
+	return Json;
+}
@@ -0,0 +1,321 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatBotComponent.h"
+
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "GameFramework/InputSettings.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/FUCK.h"
+#include "FUCK/PlayerCharacter.h"
+#include "SkillsComponent.h"
+
+static FAutoConsoleCommandWithWorldAndArgs CombatBotCommand(
+	TEXT("com.Bot"),
+	TEXT("Lets a seeded bot play the player character, or stops it. Usage: com.Bot [seed]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UCombatBotComponent::Toggle(World, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 0);
+	}));
+
+UCombatBotComponent::UCombatBotComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	// Input is processed in the controller's tick, after this
+	PrimaryComponentTick.TickGroup = TG_PrePhysics;
+}
+
+UCombatBotComponent* UCombatBotComponent::Toggle(UWorld* World, int32 Seed)
+{
+	APlayerController* Controller = World ? World->GetFirstPlayerController() : nullptr;
+
+	if (!Controller)
+	{
+		return nullptr;
+	}
+
+	if (UCombatBotComponent* Existing = Controller->FindComponentByClass<UCombatBotComponent>())
+	{
+		UE_LOG(LogCityOfMyths, Display, TEXT("Combat bot stopped after %d actions"), Existing->GetActionCount());
+		Existing->DestroyComponent();
+		return nullptr;
+	}
+
+	UCombatBotComponent* Bot = NewObject<UCombatBotComponent>(Controller);
+	Bot->SetSeed(Seed);
+	Bot->RegisterComponent();
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Combat bot playing with seed %d"), Seed);
+
+	return Bot;
+}
+
+void UCombatBotComponent::SetSeed(int32 Seed)
+{
+	Random.Initialize(Seed);
+}
+
+void UCombatBotComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	ReleaseAll();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCombatBotComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const APlayerController* Controller = Cast<APlayerController>(GetOwner());
+	APlayerCharacter* Player = Controller ? Cast<APlayerCharacter>(Controller->GetPawn()) : nullptr;
+
+	if (!Player || Player->Dead)
+	{
+		ReleaseAll();
+		return;
+	}
+
+	if (AActor* Goal = Player->Target ? Player->Target : ExploreTarget.Get())
+	{
+		FaceTowards(Player, Goal->GetActorLocation(), DeltaTime);
+	}
+
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	if (Now >= NextDecisionTime)
+	{
+		Decide(Player);
+		NextDecisionTime = Now + DecisionInterval + Random.FRand() * DecisionJitter;
+	}
+}
+
+void UCombatBotComponent::Decide(APlayerCharacter* Player)
+{
+	// Enemies close by but nothing locked: lock on to the nearest
+	if (!Player->Target && !Player->NearbyEnemies.IsEmpty())
+	{
+		ReleaseAll();
+		PressAction(TEXT("CombatModeToggle"));
+		return;
+	}
+
+	if (!Player->Target)
+	{
+		const float Now = GetWorld()->GetTimeSeconds();
+
+		if (!ExploreTarget.IsValid() || ExploreTarget->ActiveState == State::DEAD || Now >= NextExploreSearchTime)
+		{
+			ExploreTarget = FindNearestEnemy(Player);
+			NextExploreSearchTime = Now + 2.0f;
+		}
+
+		SetAxis(TEXT("MoveRight"), 0.0f);
+		SetAxis(TEXT("MoveForward"), ExploreTarget.IsValid() ? 1.0f : 0.0f);
+		SetAction(TEXT("Sprint"), ExploreTarget.IsValid() && Player->GetStamina() > Player->MaxStamina * 0.5f);
+		return;
+	}
+
+	const float Distance = FVector::Dist2D(Player->GetActorLocation(), Player->Target->GetActorLocation());
+
+	if (Distance > MeleeRange)
+	{
+		SetAxis(TEXT("MoveForward"), 1.0f);
+		SetAxis(TEXT("MoveRight"), 0.0f);
+		SetAction(TEXT("Sprint"), Distance > SprintDistance && Player->GetStamina() > Player->MaxStamina * 0.3f);
+		return;
+	}
+
+	SetAxis(TEXT("MoveForward"), 0.0f);
+	SetAction(TEXT("Sprint"), false);
+
+	DecideInRange(Player);
+}
+
+void UCombatBotComponent::DecideInRange(APlayerCharacter* Player)
+{
+	const USkillsComponent* Skills = Player->FindComponentByClass<USkillsComponent>();
+
+	TArray<int32, TInlineAllocator<8>> ReadySkills;
+	for (int32 Slot = 0; Skills && Slot < Skills->GetSkillCount(); Slot++)
+	{
+		if (Skills->GetCooldown(Slot) <= 0.0f)
+		{
+			ReadySkills.Add(Slot);
+		}
+	}
+
+	const float SkillChance = ReadySkills.IsEmpty() ? 0.0f : SkillWeight;
+	float Roll = Random.FRand() * (AttackWeight + RollWeight + SkillChance + StrafeWeight + CycleTargetWeight);
+
+	if ((Roll -= AttackWeight) < 0.0f)
+	{
+		SetAxis(TEXT("MoveRight"), 0.0f);
+		PressAction(TEXT("Attack"));
+	}
+	else if ((Roll -= RollWeight) < 0.0f)
+	{
+		// Rolls go the way the stick points
+		SetAxis(TEXT("MoveRight"), Random.RandRange(-1, 1));
+		PressAction(TEXT("Roll"));
+	}
+	else if ((Roll -= SkillChance) < 0.0f)
+	{
+		const int32 Slot = ReadySkills[Random.RandHelper(ReadySkills.Num())];
+		PressAction(FName(*FString::Printf(TEXT("Skill%d"), Slot + 1)));
+	}
+	else if ((Roll -= StrafeWeight) < 0.0f)
+	{
+		SetAxis(TEXT("MoveRight"), Random.FRand() < 0.5f ? -1.0f : 1.0f);
+	}
+	else
+	{
+		PressAction(Random.FRand() < 0.5f ? TEXT("CycleTarget+") : TEXT("CycleTarget-"));
+	}
+}
+
+AEnemyBase* UCombatBotComponent::FindNearestEnemy(const APlayerCharacter* Player) const
+{
+	AEnemyBase* Nearest = nullptr;
+	float BestDistanceSquared = TNumericLimits<float>::Max();
+
+	for (TActorIterator<AEnemyBase> It(GetWorld()); It; ++It)
+	{
+		if (It->ActiveState == State::DEAD)
+		{
+			continue;
+		}
+
+		const float DistanceSquared = FVector::DistSquared(Player->GetActorLocation(), It->GetActorLocation());
+
+		if (DistanceSquared < BestDistanceSquared)
+		{
+			BestDistanceSquared = DistanceSquared;
+			Nearest = *It;
+		}
+	}
+
+	return Nearest;
+}
+
+void UCombatBotComponent::FaceTowards(APlayerCharacter* Player, const FVector& Location, float DeltaTime)
+{
+	AController* Controller = Player->GetController();
+	const FRotator Current = Controller->GetControlRotation();
+	const float DesiredYaw = (Location - Player->GetActorLocation()).Rotation().Yaw;
+
+	// Like a player turning the camera, at a limited rate
+	const float Yaw = FMath::FixedTurn(Current.Yaw, DesiredYaw, TurnRate * DeltaTime);
+	Controller->SetControlRotation(FRotator(Current.Pitch, Yaw, 0.0f));
+}
+
+void UCombatBotComponent::PressAction(FName Action)
+{
+	APlayerController* Controller = Cast<APlayerController>(GetOwner());
+	TArray<FInputActionKeyMapping> Mappings;
+	UInputSettings::GetInputSettings()->GetActionMappingByName(Action, Mappings);
+
+	if (!Controller || Mappings.IsEmpty())
+	{
+		return;
+	}
+
+	// Goes through the bindings in SetupPlayerInputComponent like a real key press
+	Controller->InputKey(FInputKeyParams(Mappings[0].Key, IE_Pressed, 1.0, false));
+	Controller->InputKey(FInputKeyParams(Mappings[0].Key, IE_Released, 0.0, false));
+
+	ActionCount++;
+}
+
+void UCombatBotComponent::SetAction(FName Action, bool bHeld)
+{
+	APlayerController* Controller = Cast<APlayerController>(GetOwner());
+	const FKey* HeldKey = HeldKeys.Find(Action);
+
+	if (!Controller || bHeld == (HeldKey != nullptr))
+	{
+		return;
+	}
+
+	if (HeldKey)
+	{
+		Controller->InputKey(FInputKeyParams(*HeldKey, IE_Released, 0.0, false));
+		HeldKeys.Remove(Action);
+		return;
+	}
+
+	TArray<FInputActionKeyMapping> Mappings;
+	UInputSettings::GetInputSettings()->GetActionMappingByName(Action, Mappings);
+
+	if (!Mappings.IsEmpty())
+	{
+		Controller->InputKey(FInputKeyParams(Mappings[0].Key, IE_Pressed, 1.0, false));
+		HeldKeys.Add(Action, Mappings[0].Key);
+		ActionCount++;
+	}
+}
+
+void UCombatBotComponent::SetAxis(FName Axis, float Value)
+{
+	APlayerController* Controller = Cast<APlayerController>(GetOwner());
+
+	if (!Controller)
+	{
+		return;
+	}
+
+	FKey NewKey;
+
+	if (Value != 0.0f)
+	{
+		TArray<FInputAxisKeyMapping> Mappings;
+		UInputSettings::GetInputSettings()->GetAxisMappingByName(Axis, Mappings);
+
+		// A digital key held down gives its mapping's scale, like a keyboard player
+		const FInputAxisKeyMapping* Mapping = Mappings.FindByPredicate([Value](const FInputAxisKeyMapping& Candidate)
+		{
+			return !Candidate.Key.IsAnalog() && FMath::Sign(Candidate.Scale) == FMath::Sign(Value);
+		});
+
+		if (Mapping)
+		{
+			NewKey = Mapping->Key;
+		}
+	}
+
+	const FKey* HeldKey = HeldKeys.Find(Axis);
+
+	if (HeldKey && *HeldKey == NewKey)
+	{
+		return;
+	}
+
+	if (HeldKey)
+	{
+		Controller->InputKey(FInputKeyParams(*HeldKey, IE_Released, 0.0, false));
+		HeldKeys.Remove(Axis);
+	}
+
+	if (NewKey.IsValid())
+	{
+		Controller->InputKey(FInputKeyParams(NewKey, IE_Pressed, 1.0, false));
+		HeldKeys.Add(Axis, NewKey);
+	}
+}
+
+void UCombatBotComponent::ReleaseAll()
+{
+	APlayerController* Controller = Cast<APlayerController>(GetOwner());
+
+	for (const TPair<FName, FKey>& Held : HeldKeys)
+	{
+		if (Controller)
+		{
+			Controller->InputKey(FInputKeyParams(Held.Value, IE_Released, 0.0, false));
+		}
+	}
+
+	HeldKeys.Reset();
+}
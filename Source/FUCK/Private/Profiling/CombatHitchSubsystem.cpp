@@ -0,0 +1,382 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatHitchSubsystem.h"
+
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/Paths.h"
+#include "Combat/EncounterSubsystem.h"
+#include "Profiling/CombatStats.h"
+#include "VFX/CombatVFXSubsystem.h"
+#include "FUCK/FUCK.h"
+
+static FAutoConsoleCommandWithWorldAndArgs HitchThresholdCommand(
+	TEXT("com.Hitch.Threshold"),
+	TEXT("Game thread ms above which a combat frame is recorded as a hitch. Usage: com.Hitch.Threshold <ms, 0 turns it off>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UCombatHitchSubsystem* Hitches = World ? World->GetSubsystem<UCombatHitchSubsystem>() : nullptr;
+
+		if (Hitches && Args.Num() > 0)
+		{
+			Hitches->SetThreshold(FCString::Atof(*Args[0]));
+		}
+	}));
+
+namespace CombatHitch
+{
+	// Matches enum class State in EnemyBase.h
+	const TCHAR* StateNames[] = { TEXT("Idle"), TEXT("ChaseClose"), TEXT("ChaseFar"), TEXT("Attack"), TEXT("Stumble"), TEXT("Taunt"), TEXT("Dead"), TEXT("LongBossAttack") };
+
+	// State changes kept per frame, a wave engaging at once shouldn't grow the record without bound
+	constexpr int32 MaxStateChanges = 32;
+
+	const TCHAR* GetStateName(uint8 State)
+	{
+		return State < UE_ARRAY_COUNT(StateNames) ? StateNames[State] : TEXT("Unknown");
+	}
+}
+
+UCombatHitchSubsystem::FFrameContext UCombatHitchSubsystem::Context;
+int32 UCombatHitchSubsystem::Detectors = 0;
+
+void UCombatHitchSubsystem::FFrameContext::Reset()
+{
+	StateChanges.Reset();
+	DroppedStateChanges = 0;
+	DamageEvents = 0;
+	Widgets.Reset();
+	GCRuns = 0;
+	GCSeconds = 0.0;
+}
+
+bool UCombatHitchSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatHitchSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	if (bEnabled && HitchThresholdMs > 0.0f)
+	{
+		Start();
+	}
+}
+
+void UCombatHitchSubsystem::Deinitialize()
+{
+	Stop();
+
+	if (WriteTask.IsValid())
+	{
+		WriteTask.Wait();
+	}
+
+	Writer.Reset();
+
+	Super::Deinitialize();
+}
+
+void UCombatHitchSubsystem::SetThreshold(float InThresholdMs)
+{
+	HitchThresholdMs = InThresholdMs;
+
+	if (HitchThresholdMs > 0.0f)
+	{
+		Start();
+	}
+	else
+	{
+		Stop();
+	}
+}
+
+void UCombatHitchSubsystem::Start()
+{
+	if (bRunning)
+	{
+		return;
+	}
+
+	bRunning = true;
+	Detectors++;
+	FCombatScopeTimes::AddReader();
+
+	Records.Reset(MaxRecords);
+	NextRecord = 0;
+	LastScopeCycles.Reset();
+	Context.Reset();
+	NextFlushTime = FPlatformTime::Seconds() + FlushInterval;
+
+	TickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UCombatHitchSubsystem::OnWorldTickStart);
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UCombatHitchSubsystem::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UCombatHitchSubsystem::OnPostGarbageCollect);
+}
+
+void UCombatHitchSubsystem::Stop()
+{
+	if (!bRunning)
+	{
+		return;
+	}
+
+	Flush();
+
+	FWorldDelegates::OnWorldTickStart.Remove(TickStartHandle);
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	FCombatScopeTimes::RemoveReader();
+	Detectors--;
+	bRunning = false;
+}
+
+void UCombatHitchSubsystem::NoteStateChange(const AActor* Actor, uint8 OldState, uint8 NewState)
+{
+	if (Detectors == 0)
+	{
+		return;
+	}
+
+	if (Context.StateChanges.Num() < CombatHitch::MaxStateChanges)
+	{
+		Context.StateChanges.Add({ Actor ? Actor->GetFName() : NAME_None, OldState, NewState });
+	}
+	else
+	{
+		Context.DroppedStateChanges++;
+	}
+}
+
+void UCombatHitchSubsystem::NoteDamage()
+{
+	if (Detectors > 0)
+	{
+		Context.DamageEvents++;
+	}
+}
+
+void UCombatHitchSubsystem::NoteWidgetCreated(const UObject* Widget)
+{
+	if (Detectors > 0 && Widget)
+	{
+		Context.Widgets.Add(Widget->GetClass()->GetFName());
+	}
+}
+
+void UCombatHitchSubsystem::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void UCombatHitchSubsystem::OnPostGarbageCollect()
+{
+	Context.GCRuns++;
+	Context.GCSeconds += FPlatformTime::Seconds() - GCStartTime;
+}
+
+void UCombatHitchSubsystem::OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World != GetWorld())
+	{
+		return;
+	}
+
+	// The previous frame is complete once the next world tick starts
+	FCombatScopeTimes::Read(ScopeCycles);
+
+	const float GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	const UEncounterSubsystem* Encounters = World->GetSubsystem<UEncounterSubsystem>();
+
+	// The first frame has no scope totals to diff against
+	if (LastScopeCycles.Num() > 0 && GameThreadMs > HitchThresholdMs && Encounters && Encounters->IsEncounterActive())
+	{
+		AddRecord(FApp::GetDeltaTime() * 1000.0, GameThreadMs);
+	}
+
+	Swap(LastScopeCycles, ScopeCycles);
+
+	if (const UCombatVFXSubsystem* VFX = World->GetSubsystem<UCombatVFXSubsystem>())
+	{
+		LastVFXSpawns = VFX->GetSpawnCount();
+	}
+
+	Context.Reset();
+
+	if (FPlatformTime::Seconds() >= NextFlushTime)
+	{
+		Flush();
+	}
+}
+
+void UCombatHitchSubsystem::AddRecord(float FrameMs, float GameThreadMs)
+{
+	FHitchRecord Record;
+	Record.Time = FDateTime::Now();
+	Record.Frame = GFrameCounter - 1;
+	Record.FrameMs = FrameMs;
+	Record.GameThreadMs = GameThreadMs;
+
+	if (const UEncounterSubsystem* Encounters = GetWorld()->GetSubsystem<UEncounterSubsystem>())
+	{
+		Record.Enemies = Encounters->GetEnemies().Num();
+	}
+
+	Record.StateChanges = Context.StateChanges;
+	Record.DroppedStateChanges = Context.DroppedStateChanges;
+	Record.DamageEvents = Context.DamageEvents;
+	Record.Widgets = Context.Widgets;
+	Record.GCRuns = Context.GCRuns;
+	Record.GCMs = Context.GCSeconds * 1000.0;
+
+	if (const UCombatVFXSubsystem* VFX = GetWorld()->GetSubsystem<UCombatVFXSubsystem>())
+	{
+		Record.VFXSpawns = VFX->GetSpawnCount() - LastVFXSpawns;
+	}
+
+	// Scopes hit from several places report under one name
+	TMap<FString, float> ScopeMs;
+	for (int32 i = 0; i < ScopeCycles.Num(); i++)
+	{
+		const uint64 Last = LastScopeCycles.IsValidIndex(i) ? LastScopeCycles[i].Value : 0;
+
+		if (ScopeCycles[i].Value > Last)
+		{
+			FString Name(ScopeCycles[i].Key);
+			Name.RemoveFromStart(TEXT("STAT_COM_"));
+			ScopeMs.FindOrAdd(Name) += FPlatformTime::ToMilliseconds64(ScopeCycles[i].Value - Last);
+		}
+	}
+
+	ScopeMs.ValueSort([](float A, float B) { return A > B; });
+
+	for (const TPair<FString, float>& Scope : ScopeMs)
+	{
+		if (Record.Scopes.Num() >= TopScopes)
+		{
+			break;
+		}
+
+		Record.Scopes.Add(Scope);
+	}
+
+	UE_LOG(LogCityOfMyths, Verbose, TEXT("Hitch: %.1f ms game thread, frame %llu"), GameThreadMs, Record.Frame);
+
+	const int32 Capacity = FMath::Max(MaxRecords, 1);
+
+	if (Records.Num() < Capacity)
+	{
+		Records.Add(MoveTemp(Record));
+	}
+	else
+	{
+		// Full until the next flush: the oldest record makes room
+		Records[NextRecord] = MoveTemp(Record);
+		DroppedRecords++;
+	}
+
+	NextRecord = (NextRecord + 1) % Capacity;
+}
+
+void UCombatHitchSubsystem::Flush()
+{
+	NextFlushTime = FPlatformTime::Seconds() + FlushInterval;
+
+	if (Records.Num() == 0)
+	{
+		return;
+	}
+
+	if (DroppedRecords > 0)
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Hitch: %d records dropped, raise MaxRecords or lower FlushInterval"), DroppedRecords);
+		DroppedRecords = 0;
+	}
+
+	// The file is only created once there is a hitch to write
+	if (!Writer)
+	{
+		OutputPath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("Hitches"), FString::Printf(TEXT("Hitches-%s.jsonl"), *FDateTime::Now().ToString()));
+		Writer = MakeShareable(IFileManager::Get().CreateFileWriter(*OutputPath));
+
+		if (!Writer)
+		{
+			UE_LOG(LogCityOfMyths, Warning, TEXT("Hitch: can't write %s, records dropped"), *OutputPath);
+			Records.Reset();
+			NextRecord = 0;
+			return;
+		}
+
+		UE_LOG(LogCityOfMyths, Log, TEXT("Hitch: writing records to %s"), *OutputPath);
+	}
+
+	// Oldest first
+	TArray<FHitchRecord> Batch;
+	Batch.Reserve(Records.Num());
+
+	const int32 Oldest = Records.Num() < FMath::Max(MaxRecords, 1) ? 0 : NextRecord;
+	for (int32 i = 0; i < Records.Num(); i++)
+	{
+		Batch.Add(MoveTemp(Records[(Oldest + i) % Records.Num()]));
+	}
+
+	Records.Reset();
+	NextRecord = 0;
+
+	auto Write = [File = Writer, Batch = MoveTemp(Batch)]()
+	{
+		FString Lines;
+		for (const FHitchRecord& Record : Batch)
+		{
+			Lines += FormatRecord(Record);
+			Lines += TEXT("\n");
+		}
+
+		FTCHARToUTF8 Utf8(*Lines);
+		File->Serialize(const_cast<ANSICHAR*>(Utf8.Get()), Utf8.Length());
+		File->Flush();
+	};
+
+	// Chained so the batches land in order
+	WriteTask = WriteTask.IsValid()
+		? UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Write), UE::Tasks::Prerequisites(WriteTask))
+		: UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Write));
+}
+
+FString UCombatHitchSubsystem::FormatRecord(const FHitchRecord& Record)
+{
+	FString Json = FString::Printf(TEXT("{\"time\": \"%s\", \"frame\": %llu, \"frameMs\": %.2f, \"gameThreadMs\": %.2f, \"enemies\": %d, "),
+		*Record.Time.ToIso8601(), Record.Frame, Record.FrameMs, Record.GameThreadMs, Record.Enemies);
+	Json += FString::Printf(TEXT("\"damageEvents\": %d, \"vfxSpawns\": %d, \"gcRuns\": %d, \"gcMs\": %.2f, "),
+		Record.DamageEvents, Record.VFXSpawns, Record.GCRuns, Record.GCMs);
+
+	Json += TEXT("\"stateChanges\": [");
+	for (int32 i = 0; i < Record.StateChanges.Num(); i++)
+	{
+		const FStateChange& Change = Record.StateChanges[i];
+		Json += FString::Printf(TEXT("%s{\"actor\": \"%s\", \"from\": \"%s\", \"to\": \"%s\"}"), i > 0 ? TEXT(", ") : TEXT(""),
+			*Change.Actor.ToString(), CombatHitch::GetStateName(Change.OldState), CombatHitch::GetStateName(Change.NewState));
+	}
+	Json += FString::Printf(TEXT("], \"droppedStateChanges\": %d, "), Record.DroppedStateChanges);
+
+	Json += TEXT("\"widgets\": [");
+	for (int32 i = 0; i < Record.Widgets.Num(); i++)
+	{
+		Json += FString::Printf(TEXT("%s\"%s\""), i > 0 ? TEXT(", ") : TEXT(""), *Record.Widgets[i].ToString());
+	}
+	Json += TEXT("], ");
+
+	Json += TEXT("\"scopesMs\": {");
+	for (int32 i = 0; i < Record.Scopes.Num(); i++)
+	{
+		Json += FString::Printf(TEXT("%s\"%s\": %.3f"), i > 0 ? TEXT(", ") : TEXT(""), *Record.Scopes[i].Key, Record.Scopes[i].Value);
+	}
+	Json += TEXT("}}");
+
+	return Json;
+}
@@ -0,0 +1,553 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatInputReplayComponent.h"
+
+#include "Components/InputComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "TimerManager.h"
+#include "Combat/CombatRandom.h"
+#include "Combat/EncounterSubsystem.h"
+#include "FUCK/FUCK.h"
+#include "FUCK/PlayerCharacter.h"
+
+static FAutoConsoleCommandWithWorldAndArgs InputRecordCommand(
+	TEXT("com.Input.Record"),
+	TEXT("Records the player's input to a replayable log. Usage: com.Input.Record [file]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCombatInputReplayComponent* Replay = UCombatInputReplayComponent::Find(World, true))
+		{
+			Replay->StartRecording(Args.Num() > 0 ? Args[0] : UCombatInputReplayComponent::GetDefaultPath());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs InputReplayCommand(
+	TEXT("com.Input.Replay"),
+	TEXT("Plays a recorded input log back frame by frame. Usage: com.Input.Replay [file]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCombatInputReplayComponent* Replay = UCombatInputReplayComponent::Find(World, true))
+		{
+			Replay->StartReplay(Args.Num() > 0 ? Args[0] : UCombatInputReplayComponent::GetDefaultPath());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld InputStopCommand(
+	TEXT("com.Input.Stop"),
+	TEXT("Stops an input recording or replay"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UCombatInputReplayComponent* Replay = UCombatInputReplayComponent::Find(World, false))
+		{
+			Replay->Stop();
+		}
+	}));
+
+namespace CombatInputReplay
+{
+	const TCHAR* const AxisNames[] =
+	{
+		TEXT("MoveForward"), TEXT("MoveRight"), TEXT("Turn"), TEXT("LookUp")
+	};
+
+	const TCHAR* const ActionNames[] =
+	{
+		TEXT("CombatModeToggle"), TEXT("Attack"), TEXT("Roll"), TEXT("Jump"), TEXT("Sprint"),
+		TEXT("CycleTarget+"), TEXT("CycleTarget-"), TEXT("Skill1"), TEXT("Skill2"), TEXT("Skill3"), TEXT("Skill4")
+	};
+
+	constexpr uint8 ReleasedBit = 0x80;
+
+	// Frames are handed to the writer task in chunks about this size
+	constexpr int32 ChunkSize = 16 * 1024;
+}
+
+UCombatInputReplayComponent::UCombatInputReplayComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+}
+
+FString UCombatInputReplayComponent::GetDefaultPath()
+{
+	return FPaths::Combine(FPaths::ProfilingDir(), TEXT("CombatInput.replay"));
+}
+
+UCombatInputReplayComponent* UCombatInputReplayComponent::Find(UWorld* World, bool bCreate)
+{
+	APlayerController* Controller = World ? World->GetFirstPlayerController() : nullptr;
+
+	if (!Controller)
+	{
+		return nullptr;
+	}
+
+	UCombatInputReplayComponent* Replay = Controller->FindComponentByClass<UCombatInputReplayComponent>();
+
+	if (!Replay && bCreate)
+	{
+		Replay = NewObject<UCombatInputReplayComponent>(Controller);
+		Replay->RegisterComponent();
+	}
+
+	return Replay;
+}
+
+void UCombatInputReplayComponent::StartFromCommandLine(APlayerCharacter* Player)
+{
+	FString Path;
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("-CombatInputReplay="), Path))
+	{
+		if (UCombatInputReplayComponent* Replay = Find(Player->GetWorld(), true))
+		{
+			Replay->StartReplay(Path);
+		}
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("-CombatInputRecord="), Path))
+	{
+		if (UCombatInputReplayComponent* Replay = Find(Player->GetWorld(), true))
+		{
+			Replay->StartRecording(Path);
+		}
+	}
+}
+
+bool UCombatInputReplayComponent::IsRequestedOnCommandLine()
+{
+	FString Path;
+	return FParse::Value(FCommandLine::Get(), TEXT("-CombatInputReplay="), Path)
+		|| FParse::Value(FCommandLine::Get(), TEXT("-CombatInputRecord="), Path);
+}
+
+APlayerController* UCombatInputReplayComponent::GetPlayerController() const
+{
+	return Cast<APlayerController>(GetOwner());
+}
+
+APlayerCharacter* UCombatInputReplayComponent::GetPlayer() const
+{
+	const APlayerController* Controller = GetPlayerController();
+	return Controller ? Cast<APlayerCharacter>(Controller->GetPawn()) : nullptr;
+}
+
+void UCombatInputReplayComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Stop();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UCombatInputReplayComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (Mode == ECombatInputReplayMode::Record)
+	{
+		RecordFrame(DeltaTime);
+	}
+	else if (Mode == ECombatInputReplayMode::Replay)
+	{
+		ReplayFrame();
+	}
+}
+
+bool UCombatInputReplayComponent::CanStartOutsideEncounter(const TCHAR* What) const
+{
+	const UEncounterSubsystem* Encounters = GetWorld()->GetSubsystem<UEncounterSubsystem>();
+
+	if (Encounters && Encounters->IsEncounterActive())
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("%s: an encounter is active, start outside of combat so enemies begin as they were recorded"), What);
+		return false;
+	}
+
+	return true;
+}
+
+bool UCombatInputReplayComponent::StartRecording(const FString& Path)
+{
+	Stop();
+
+	if (!CanStartOutsideEncounter(TEXT("Input record")))
+	{
+		return false;
+	}
+
+	APlayerController* Controller = GetPlayerController();
+	APlayerCharacter* Player = GetPlayer();
+
+	if (!Player || !Player->InputComponent)
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input record: no player to record"));
+		return false;
+	}
+
+	Writer = MakeShareable(IFileManager::Get().CreateFileWriter(*Path));
+
+	if (!Writer)
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input record: can't write %s"), *Path);
+		return false;
+	}
+
+	// Reseeded so the replay can make the same attack and stumble picks
+	int32 Seed = FMath::Rand();
+	FCombatRandom::Seed(Seed);
+
+	Axes.Reset();
+	Actions.Reset();
+
+	for (const TCHAR* Axis : CombatInputReplay::AxisNames)
+	{
+		Axes.Add(Axis);
+	}
+
+	for (const TCHAR* Action : CombatInputReplay::ActionNames)
+	{
+		Actions.Add(Action);
+	}
+
+	AxisValues.Init(0.0f, Axes.Num());
+	FrameActions.Reset();
+	Pending.Reset();
+
+	FMemoryWriter Ar(Pending);
+
+	uint32 Magic = LogMagic;
+	int32 Version = LogVersion;
+	FString MapName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName());
+	FVector3f Location(Player->GetActorLocation());
+	FRotator3f Rotation(Player->GetActorRotation());
+	FRotator3f ControlRotation(Controller->GetControlRotation());
+
+	Ar << Magic << Version << MapName << Seed << Location << Rotation << ControlRotation;
+	Ar << Axes << Actions;
+
+	// Sees every press before the player's bindings do, without consuming it
+	RecordInput = NewObject<UInputComponent>(Controller);
+
+	for (int32 i = 0; i < Actions.Num(); i++)
+	{
+		for (const EInputEvent Event : { IE_Pressed, IE_Released })
+		{
+			FInputActionBinding Binding(Actions[i], Event);
+			Binding.bConsumeInput = false;
+			Binding.ActionDelegate.GetDelegateForManualSet().BindUObject(this, &UCombatInputReplayComponent::OnRecordedAction, i, Event == IE_Pressed);
+			RecordInput->AddActionBinding(MoveTemp(Binding));
+		}
+	}
+
+	Controller->PushInputComponent(RecordInput);
+
+	// After the controller processed this frame's input
+	SetTickGroup(TG_PostPhysics);
+
+	Mode = ECombatInputReplayMode::Record;
+	Frame = 0;
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Input record: writing %s, seed %d"), *Path, Seed);
+
+	return true;
+}
+
+void UCombatInputReplayComponent::OnRecordedAction(int32 Index, bool bPressed)
+{
+	FrameActions.Add((uint8)Index | (bPressed ? 0 : CombatInputReplay::ReleasedBit));
+}
+
+void UCombatInputReplayComponent::RecordFrame(float DeltaTime)
+{
+	const APlayerCharacter* Player = GetPlayer();
+
+	if (!Player || !Player->InputComponent)
+	{
+		return;
+	}
+
+	FMemoryWriter Ar(Pending, false, true);
+
+	TArray<uint8, TInlineAllocator<8>> Changed;
+
+	for (int32 i = 0; i < Axes.Num(); i++)
+	{
+		const float Value = Player->InputComponent->GetAxisValue(Axes[i]);
+
+		if (Value != AxisValues[i])
+		{
+			AxisValues[i] = Value;
+			Changed.Add((uint8)i);
+		}
+	}
+
+	uint8 AxisCount = Changed.Num();
+	Ar << DeltaTime << AxisCount;
+
+	for (uint8 Index : Changed)
+	{
+		Ar << Index << AxisValues[Index];
+	}
+
+	uint8 ActionCount = FrameActions.Num();
+	Ar << ActionCount;
+	Ar.Serialize(FrameActions.GetData(), FrameActions.Num());
+
+	FrameActions.Reset();
+	Frame++;
+
+	if (Pending.Num() >= CombatInputReplay::ChunkSize)
+	{
+		FlushRecording(false);
+	}
+}
+
+void UCombatInputReplayComponent::FlushRecording(bool bClose)
+{
+	auto Write = [File = Writer, Chunk = MoveTemp(Pending), bClose]() mutable
+	{
+		File->Serialize(Chunk.GetData(), Chunk.Num());
+
+		if (bClose)
+		{
+			File->Close();
+		}
+	};
+
+	Pending.Reset();
+
+	// Chained so the chunks land in order
+	WriteTask = WriteTask.IsValid()
+		? UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Write), UE::Tasks::Prerequisites(WriteTask))
+		: UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Write));
+}
+
+bool UCombatInputReplayComponent::StartReplay(const FString& Path)
+{
+	Stop();
+
+	if (!CanStartOutsideEncounter(TEXT("Input replay")))
+	{
+		return false;
+	}
+
+	APlayerController* Controller = GetPlayerController();
+	APlayerCharacter* Player = GetPlayer();
+
+	if (!Player || !Player->InputComponent)
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input replay: no player to drive"));
+		return false;
+	}
+
+	if (!FFileHelper::LoadFileToArray(ReplayBytes, *Path))
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input replay: can't read %s"), *Path);
+		return false;
+	}
+
+	Reader = MakeUnique<FMemoryReader>(ReplayBytes);
+	FArchive& Ar = *Reader;
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Ar << Magic << Version;
+
+	if (Magic != LogMagic || Version < 1 || Version > LogVersion)
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input replay: %s is not an input log or from a newer version"), *Path);
+		Reader.Reset();
+		ReplayBytes.Empty();
+		return false;
+	}
+
+	FString MapName;
+	int32 Seed = 0;
+	FVector3f Location;
+	FRotator3f Rotation;
+	FRotator3f ControlRotation;
+
+	Ar << MapName << Seed << Location << Rotation << ControlRotation;
+	Ar << Axes << Actions;
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input replay: %s is damaged"), *Path);
+		Reader.Reset();
+		ReplayBytes.Empty();
+		return false;
+	}
+
+	if (MapName != UWorld::RemovePIEPrefix(GetWorld()->GetMapName()))
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input replay: recorded on %s, playing on another map"), *MapName);
+	}
+
+	FCombatRandom::Seed(Seed);
+
+	Player->SetActorLocationAndRotation(FVector(Location), FRotator(Rotation), false, nullptr, ETeleportType::TeleportPhysics);
+	Controller->SetControlRotation(FRotator(ControlRotation));
+
+	AxisValues.Init(0.0f, Axes.Num());
+
+	// Live input would mix in, the log drives the bindings directly
+	Player->DisableInput(Controller);
+
+	// Ahead of the player's tick, where a real key press would be processed
+	SetTickGroup(TG_PrePhysics);
+	Player->PrimaryActorTick.AddPrerequisite(this, PrimaryComponentTick);
+
+	// Every frame runs at the delta time it was recorded with
+	bWasFixedTimeStep = FApp::UseFixedTimeStep();
+	SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+
+	if (!Ar.AtEnd())
+	{
+		float NextDelta = 0.0f;
+		const int64 Position = Ar.Tell();
+		Ar << NextDelta;
+		Ar.Seek(Position);
+		FApp::SetFixedDeltaTime(NextDelta);
+	}
+
+	Mode = ECombatInputReplayMode::Replay;
+	Frame = 0;
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Input replay: playing %s, seed %d"), *Path, Seed);
+
+	return true;
+}
+
+void UCombatInputReplayComponent::ReplayFrame()
+{
+	APlayerCharacter* Player = GetPlayer();
+	FArchive& Ar = *Reader;
+
+	if (!Player || !Player->InputComponent || Ar.AtEnd())
+	{
+		UE_LOG(LogCityOfMyths, Display, TEXT("Input replay: finished after %d frames"), Frame);
+		Stop();
+		return;
+	}
+
+	float DeltaTime = 0.0f;
+	uint8 AxisCount = 0;
+	Ar << DeltaTime << AxisCount;
+
+	for (uint8 i = 0; i < AxisCount; i++)
+	{
+		uint8 Index = 0;
+		float Value = 0.0f;
+		Ar << Index << Value;
+
+		if (AxisValues.IsValidIndex(Index))
+		{
+			AxisValues[Index] = Value;
+		}
+	}
+
+	uint8 ActionCount = 0;
+	Ar << ActionCount;
+
+	for (uint8 i = 0; i < ActionCount; i++)
+	{
+		uint8 Packed = 0;
+		Ar << Packed;
+
+		const int32 Index = Packed & ~CombatInputReplay::ReleasedBit;
+
+		if (Actions.IsValidIndex(Index))
+		{
+			ExecuteAction(Player, Actions[Index], Packed & CombatInputReplay::ReleasedBit ? IE_Released : IE_Pressed);
+		}
+	}
+
+	// Like the input stack, actions first, then every axis binding each frame
+	for (FInputAxisBinding& Binding : Player->InputComponent->AxisBindings)
+	{
+		const int32 Index = Axes.IndexOfByKey(Binding.AxisName);
+
+		if (Index != INDEX_NONE)
+		{
+			Binding.AxisValue = AxisValues[Index];
+			Binding.AxisDelegate.Execute(Binding.AxisValue);
+		}
+	}
+
+	if (Ar.IsError())
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Input replay: log damaged at frame %d"), Frame);
+		Stop();
+		return;
+	}
+
+	Frame++;
+
+	if (!Ar.AtEnd())
+	{
+		float NextDelta = 0.0f;
+		const int64 Position = Ar.Tell();
+		Ar << NextDelta;
+		Ar.Seek(Position);
+		FApp::SetFixedDeltaTime(NextDelta);
+	}
+}
+
+void UCombatInputReplayComponent::ExecuteAction(APlayerCharacter* Player, FName Action, EInputEvent Event)
+{
+	UInputComponent* Input = Player->InputComponent;
+
+	for (int32 i = 0; i < Input->GetNumActionBindings(); i++)
+	{
+		FInputActionBinding& Binding = Input->GetActionBinding(i);
+
+		if (Binding.GetActionName() == Action && Binding.KeyEvent == Event)
+		{
+			Binding.ActionDelegate.Execute(FKey());
+		}
+	}
+}
+
+void UCombatInputReplayComponent::Stop()
+{
+	if (Mode == ECombatInputReplayMode::Record)
+	{
+		FlushRecording(true);
+		WriteTask.Wait();
+		Writer.Reset();
+
+		if (APlayerController* Controller = GetPlayerController())
+		{
+			Controller->PopInputComponent(RecordInput);
+		}
+
+		RecordInput = nullptr;
+
+		UE_LOG(LogCityOfMyths, Display, TEXT("Input record: %d frames written"), Frame);
+	}
+	else if (Mode == ECombatInputReplayMode::Replay)
+	{
+		Reader.Reset();
+		ReplayBytes.Empty();
+
+		FApp::SetUseFixedTimeStep(bWasFixedTimeStep);
+		FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+
+		if (APlayerCharacter* Player = GetPlayer())
+		{
+			Player->PrimaryActorTick.RemovePrerequisite(this, PrimaryComponentTick);
+			Player->EnableInput(GetPlayerController());
+		}
+	}
+
+	Mode = ECombatInputReplayMode::None;
+}
@@ -0,0 +1,230 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatMemoryReport.h"
+
+#include "EngineUtils.h"
+#include "Animation/AnimMontage.h"
+#include "Blueprint/UserWidget.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/WidgetComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectHash.h"
+#include "Data/CombatantArchetype.h"
+#include "FUCK/Combatant.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/FUCK.h"
+
+static FAutoConsoleCommandWithWorldAndArgs MemoryReportCommand(
+	TEXT("com.Memory.Report"),
+	TEXT("Estimates the memory of every combatant type, per instance and in total (writes Saved/Profiling/MemoryReport.csv). Usage: com.Memory.Report [file.csv]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		uint64 SharedTotalBytes = 0;
+		const TArray<FCombatMemoryArchetype> Archetypes = FCombatMemoryReport::Run(World, SharedTotalBytes);
+
+		FCombatMemoryReport::WriteReport(Archetypes, SharedTotalBytes,
+			Args.Num() > 0 ? Args[0] : FPaths::Combine(FPaths::ProfilingDir(), TEXT("MemoryReport.csv")));
+	}));
+
+namespace CombatMemoryReport
+{
+	double ToKilobytes(uint64 Bytes)
+	{
+		return Bytes / 1024.0;
+	}
+}
+
+uint64 FCombatMemoryReport::GetObjectBytes(UObject* Object)
+{
+	FArchiveCountMem Count(Object);
+	return Count.GetMax() + Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+}
+
+void FCombatMemoryReport::GatherInstanceObjects(AActor* Actor, TSet<UObject*>& OutObjects)
+{
+	auto AddWithInner = [&OutObjects](UObject* Object)
+	{
+		OutObjects.Add(Object);
+
+		TArray<UObject*> Inner;
+		GetObjectsWithOuter(Object, Inner, true);
+		OutObjects.Append(Inner);
+	};
+
+	// Components, skills and the anim instance are all outered to the actor
+	AddWithInner(Actor);
+
+	// Enemy AI controllers are spawned for the pawn alone
+	const APawn* Pawn = Cast<APawn>(Actor);
+	if (AController* Controller = Pawn ? Pawn->GetController() : nullptr; Controller && !Controller->IsPlayerController())
+	{
+		AddWithInner(Controller);
+	}
+
+	// Widgets are created in the game instance
+	for (const UWidgetComponent* WidgetComponent : TInlineComponentArray<UWidgetComponent*>(Actor))
+	{
+		if (UUserWidget* Widget = WidgetComponent->GetWidget())
+		{
+			AddWithInner(Widget);
+		}
+	}
+}
+
+void FCombatMemoryReport::GatherSharedAssets(AActor* Actor, TSet<UObject*>& OutAssets)
+{
+	for (const USkeletalMeshComponent* Mesh : TInlineComponentArray<USkeletalMeshComponent*>(Actor))
+	{
+		if (USkeletalMesh* Asset = Mesh->GetSkeletalMeshAsset())
+		{
+			OutAssets.Add(Asset);
+		}
+	}
+
+	if (const ACombatant* Combatant = Cast<ACombatant>(Actor))
+	{
+		TArray<UAnimMontage*> Montages;
+		Combatant->GatherCombatMontages(Montages);
+
+		for (UAnimMontage* Montage : Montages)
+		{
+			if (Montage)
+			{
+				OutAssets.Add(Montage);
+			}
+		}
+	}
+}
+
+TArray<FCombatMemoryArchetype> FCombatMemoryReport::Run(UWorld* World, uint64& OutSharedTotalBytes)
+{
+	TArray<FCombatMemoryArchetype> Archetypes;
+	OutSharedTotalBytes = 0;
+
+	if (!World)
+	{
+		return Archetypes;
+	}
+
+	TMap<UClass*, int32> ArchetypeIndices;
+	TMap<UClass*, TSet<UObject*>> SharedAssets;
+	TMap<UClass*, int32> ObjectCounts;
+
+	for (TActorIterator<ACombatant> It(World); It; ++It)
+	{
+		UClass* Class = It->GetClass();
+		int32& Index = ArchetypeIndices.FindOrAdd(Class, INDEX_NONE);
+
+		if (Index == INDEX_NONE)
+		{
+			Index = Archetypes.AddDefaulted();
+			Archetypes[Index].Name = Class->GetName();
+
+			if (const AEnemyBase* Enemy = Cast<AEnemyBase>(*It))
+			{
+				Archetypes[Index].Archetype = GetNameSafe(Enemy->Archetype);
+			}
+		}
+
+		FCombatMemoryArchetype& Archetype = Archetypes[Index];
+
+		TSet<UObject*> Objects;
+		GatherInstanceObjects(*It, Objects);
+
+		uint64 Bytes = 0;
+		for (UObject* Object : Objects)
+		{
+			Bytes += GetObjectBytes(Object);
+		}
+
+		Archetype.Instances++;
+		Archetype.InstanceBytes += Bytes;
+		Archetype.LargestInstanceBytes = FMath::Max(Archetype.LargestInstanceBytes, Bytes);
+		ObjectCounts.FindOrAdd(Class) += Objects.Num();
+
+		GatherSharedAssets(*It, SharedAssets.FindOrAdd(Class));
+	}
+
+	TSet<UObject*> AllShared;
+
+	for (const TPair<UClass*, int32>& Entry : ArchetypeIndices)
+	{
+		FCombatMemoryArchetype& Archetype = Archetypes[Entry.Value];
+		const TSet<UObject*>& Assets = SharedAssets.FindChecked(Entry.Key);
+
+		Archetype.ObjectsPerInstance = ObjectCounts.FindChecked(Entry.Key) / Archetype.Instances;
+		Archetype.SharedAssets = Assets.Num();
+
+		for (UObject* Asset : Assets)
+		{
+			const uint64 Bytes = Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+			Archetype.SharedBytes += Bytes;
+
+			bool bAlreadyCounted = false;
+			AllShared.Add(Asset, &bAlreadyCounted);
+
+			if (!bAlreadyCounted)
+			{
+				OutSharedTotalBytes += Bytes;
+			}
+		}
+	}
+
+	Archetypes.Sort([](const FCombatMemoryArchetype& A, const FCombatMemoryArchetype& B)
+	{
+		return A.InstanceBytes > B.InstanceBytes;
+	});
+
+	return Archetypes;
+}
+
+bool FCombatMemoryReport::WriteReport(const TArray<FCombatMemoryArchetype>& Archetypes, uint64 SharedTotalBytes, const FString& Path)
+{
+	using CombatMemoryReport::ToKilobytes;
+
+	FString Csv = TEXT("Class,Archetype,Instances,ObjectsPerInstance,AvgInstanceKB,MaxInstanceKB,InstancesTotalKB,SharedAssets,SharedKB\n");
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("%-32s %9s %8s %12s %12s %14s %10s"),
+		TEXT("Class"), TEXT("Instances"), TEXT("Objects"), TEXT("Avg KB"), TEXT("Max KB"), TEXT("Total KB"), TEXT("Shared KB"));
+
+	int32 TotalInstances = 0;
+	uint64 TotalInstanceBytes = 0;
+
+	for (const FCombatMemoryArchetype& Archetype : Archetypes)
+	{
+		const double AverageKB = ToKilobytes(Archetype.InstanceBytes) / FMath::Max(Archetype.Instances, 1);
+
+		UE_LOG(LogCityOfMyths, Display, TEXT("%-32s %9d %8d %12.1f %12.1f %14.1f %10.1f"),
+			*Archetype.Name, Archetype.Instances, Archetype.ObjectsPerInstance, AverageKB,
+			ToKilobytes(Archetype.LargestInstanceBytes), ToKilobytes(Archetype.InstanceBytes), ToKilobytes(Archetype.SharedBytes));
+
+		Csv += FString::Printf(TEXT("%s,%s,%d,%d,%.1f,%.1f,%.1f,%d,%.1f\n"),
+			*Archetype.Name, *Archetype.Archetype, Archetype.Instances, Archetype.ObjectsPerInstance, AverageKB,
+			ToKilobytes(Archetype.LargestInstanceBytes), ToKilobytes(Archetype.InstanceBytes), Archetype.SharedAssets, ToKilobytes(Archetype.SharedBytes));
+
+		TotalInstances += Archetype.Instances;
+		TotalInstanceBytes += Archetype.InstanceBytes;
+	}
+
+	// Shared assets used by several archetypes count once here
+	UE_LOG(LogCityOfMyths, Display, TEXT("%-32s %9d %8s %12s %12s %14.1f %10.1f"),
+		TEXT("Total"), TotalInstances, TEXT(""), TEXT(""), TEXT(""), ToKilobytes(TotalInstanceBytes), ToKilobytes(SharedTotalBytes));
+
+	Csv += FString::Printf(TEXT("Total,,%d,,,,%.1f,,%.1f\n"), TotalInstances, ToKilobytes(TotalInstanceBytes), ToKilobytes(SharedTotalBytes));
+
+	if (!FFileHelper::SaveStringToFile(Csv, *Path))
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Failed to write %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Memory report written to %s"), *Path);
+	return true;
+}
@@ -0,0 +1,202 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatMicroBench.h"
+
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "FUCK/Android.h"
+#include "FUCK/CombatManager.h"
+#include "FUCK/FUCK.h"
+#include "FUCK/PlayerCharacter.h"
+#include "XPController.h"
+
+namespace CombatMicroBench
+{
+	uint64 GetAllocationCount()
+	{
+#if !UE_BUILD_SHIPPING
+		return FMalloc::TotalMallocCalls.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+
+	// Frames a swing keeps overlapping the same actors
+	constexpr int32 SwingFrames = 8;
+
+	// Levels a single large grant spans
+	constexpr int32 GrantLevels = 50;
+}
+
+FCombatMicroBenchResult FCombatMicroBench::Measure(const FString& Name, int32 Iterations, TFunctionRef<void()> Op)
+{
+	// First call pays for lazy allocations and cold caches
+	Op();
+
+	const uint64 StartAllocations = CombatMicroBench::GetAllocationCount();
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		Op();
+	}
+
+	const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+	const uint64 Allocations = CombatMicroBench::GetAllocationCount() - StartAllocations;
+
+	FCombatMicroBenchResult Result;
+	Result.Name = Name;
+	Result.Iterations = Iterations;
+	Result.NsPerOp = Seconds * 1e9 / Iterations;
+	Result.AllocsPerOp = (double)Allocations / Iterations;
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("%-40s %12.1f ns/op %10.2f allocs/op"), *Result.Name, Result.NsPerOp, Result.AllocsPerOp);
+
+	return Result;
+}
+
+TArray<FCombatMicroBenchResult> FCombatMicroBench::Run(APlayerCharacter* Player, int32 EnemyCount, int32 Iterations)
+{
+	TArray<FCombatMicroBenchResult> Results;
+
+	if (!Player || !Player->GetController<APlayerController>())
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Micro bench needs a possessed APlayerCharacter"));
+		return Results;
+	}
+
+	UWorld* World = Player->GetWorld();
+
+	EnemyCount = FMath::Max(EnemyCount, 2);
+	Iterations = FMath::Max(Iterations, 1);
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Micro bench: %d enemies, %d iterations"), EnemyCount, Iterations);
+
+	// Two rings: the inner one within attack decision range, the outer one beyond it
+	const FVector Center = Player->GetActorLocation();
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<AActor*> Enemies;
+	Enemies.Reserve(EnemyCount);
+
+	for (int32 i = 0; i < EnemyCount; i++)
+	{
+		const float Angle = UE_TWO_PI * i / EnemyCount;
+		const float Radius = i % 2 == 0 ? 600.0f : 1500.0f;
+		const FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * Radius;
+
+		if (AAndroid* Enemy = World->SpawnActor<AAndroid>(AAndroid::StaticClass(), Location, (Center - Location).Rotation(), SpawnParams))
+		{
+			Enemy->SpawnDefaultController();
+			Enemy->Target = Player;
+			Enemies.Add(Enemy);
+		}
+	}
+
+	Player->NearbyEnemies = Enemies;
+
+	Results.Add(Measure(FString::Printf(TEXT("CycleTarget (acquire, %d)"), Enemies.Num()), Iterations, [Player]()
+	{
+		Player->Target = nullptr;
+		Player->CycleTarget();
+	}));
+
+	Results.Add(Measure(FString::Printf(TEXT("CycleTarget (cycle, %d)"), Enemies.Num()), Iterations, [Player]()
+	{
+		Player->CycleTarget(true);
+	}));
+
+	// The weapon overlap loop of one swing: unseen actors are registered, the rest skipped on every later frame
+	TSet<AActor*> Overlapping;
+	Overlapping.Append(Enemies);
+
+	Results.Add(Measure(FString::Printf(TEXT("AttackHitActors dedupe (swing, %d)"), Enemies.Num()), Iterations, [Player, &Overlapping]()
+	{
+		Player->ResetAttackHits();
+
+		for (int32 Frame = 0; Frame < CombatMicroBench::SwingFrames; Frame++)
+		{
+			for (AActor* HitActor : Overlapping)
+			{
+				if (!Player->HasAttackHit(HitActor))
+				{
+					Player->RegisterAttackHit(HitActor);
+				}
+			}
+		}
+	}));
+
+	// A fresh component, so the player's progression is left alone
+	UXPController* XP = NewObject<UXPController>(Player);
+	XP->RegisterComponent();
+
+	TArray<uint8> LevelZero;
+	FMemoryWriter LevelZeroWriter(LevelZero);
+	XP->SerializeSaveState(LevelZeroWriter);
+
+	float Grant = 0.0f;
+	for (int32 Level = 0; Level < CombatMicroBench::GrantLevels; Level++)
+	{
+		Grant += XP->FirstLevelXP * FMath::Pow(XP->LevelXPGrowth, (float)Level);
+	}
+
+	Results.Add(Measure(FString::Printf(TEXT("AddXP (%d level grant)"), CombatMicroBench::GrantLevels), Iterations, [XP, &LevelZero, Grant]()
+	{
+		FMemoryReader Reset(LevelZero);
+		XP->SerializeSaveState(Reset);
+		XP->AddXP(Grant);
+	}));
+
+	XP->DestroyComponent();
+
+	UCombatManager* CombatManager = NewObject<UCombatManager>(Player);
+
+	Results.Add(Measure(FString::Printf(TEXT("NextAttacker (%d)"), Enemies.Num()), Iterations, [CombatManager]()
+	{
+		CombatManager->NextAttacker();
+	}));
+
+	// Per enemy, with no attack turn handed out: the path every chasing enemy takes most frames
+	Results.Add(Measure(FString::Printf(TEXT("StateChaseClose (per enemy, %d)"), Enemies.Num()), Iterations, [&Enemies, Index = 0]() mutable
+	{
+		AEnemyBase* Enemy = static_cast<AEnemyBase*>(Enemies[Index]);
+		Index = (Index + 1) % Enemies.Num();
+
+		Enemy->ActiveState = State::CHASE_CLOSE;
+		Enemy->isAttackTurn = false;
+		Enemy->TickStateMachine();
+	}));
+
+	Player->ResetAttackHits();
+	Player->NearbyEnemies.Reset();
+	Player->Target = nullptr;
+
+	for (AActor* Enemy : Enemies)
+	{
+		Enemy->Destroy();
+	}
+
+	return Results;
+}
+
+bool FCombatMicroBench::WriteReport(const TArray<FCombatMicroBenchResult>& Results, int32 EnemyCount, const FString& Path)
+{
+	FString Json = FString::Printf(TEXT("{\n\t\"enemies\": %d,\n\t\"results\": [\n"), EnemyCount);
+
+	for (int32 i = 0; i < Results.Num(); i++)
+	{
+		const FCombatMicroBenchResult& Result = Results[i];
+
+		Json += FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"iterations\": %d, \"nsPerOp\": %.1f, \"allocsPerOp\": %.3f }%s\n"),
+			*Result.Name, Result.Iterations, Result.NsPerOp, Result.AllocsPerOp, i + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+	}
+
+	Json += TEXT("\t]\n}\n");
+
+	return FFileHelper::SaveStringToFile(Json, *Path);
+}
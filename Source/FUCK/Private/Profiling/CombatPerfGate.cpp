@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatPerfGate.h"
+
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace CombatPerfGate
+{
+	struct FMetrics
+	{
+		double GameThreadP95 = 0.0;
+		double AllocationsPerFrame = 0.0;
+		double MemoryMB = 0.0;
+	};
+
+	bool ReadMetrics(const FString& Json, FMetrics& OutMetrics)
+	{
+		TSharedPtr<FJsonObject> Root;
+
+		if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Root) || !Root.IsValid())
+		{
+			return false;
+		}
+
+		const TSharedPtr<FJsonObject>* GameThread = nullptr;
+		const TSharedPtr<FJsonObject>* Allocations = nullptr;
+		const TSharedPtr<FJsonObject>* Memory = nullptr;
+
+		return Root->TryGetObjectField(TEXT("gameThreadMs"), GameThread) && (*GameThread)->TryGetNumberField(TEXT("p95"), OutMetrics.GameThreadP95)
+			&& Root->TryGetObjectField(TEXT("allocationsPerFrame"), Allocations) && (*Allocations)->TryGetNumberField(TEXT("avg"), OutMetrics.AllocationsPerFrame)
+			&& Root->TryGetObjectField(TEXT("memoryMB"), Memory) && (*Memory)->TryGetNumberField(TEXT("usedPhysicalPeak"), OutMetrics.MemoryMB);
+	}
+}
+
+bool FCombatPerfGate::Compare(const FString& ReportJson, const FString& BaselineJson, const FCombatPerfGateThresholds& Thresholds, TArray<FString>& OutFailures)
+{
+	CombatPerfGate::FMetrics Report;
+	CombatPerfGate::FMetrics Baseline;
+
+	if (!CombatPerfGate::ReadMetrics(ReportJson, Report))
+	{
+		OutFailures.Add(TEXT("report is missing gameThreadMs.p95, allocationsPerFrame.avg or memoryMB.usedPhysicalPeak"));
+		return false;
+	}
+
+	if (!CombatPerfGate::ReadMetrics(BaselineJson, Baseline))
+	{
+		OutFailures.Add(TEXT("baseline is missing gameThreadMs.p95, allocationsPerFrame.avg or memoryMB.usedPhysicalPeak"));
+		return false;
+	}
+
+	const int32 StartFailures = OutFailures.Num();
+
+	if (Report.GameThreadP95 > Baseline.GameThreadP95 * (1.0 + Thresholds.GameThreadP95))
+	{
+		OutFailures.Add(FString::Printf(TEXT("p95 game thread %.3f ms, baseline %.3f ms (+%.0f%% allowed)"),
+			Report.GameThreadP95, Baseline.GameThreadP95, Thresholds.GameThreadP95 * 100.0f));
+	}
+
+	if (Report.AllocationsPerFrame > Baseline.AllocationsPerFrame * (1.0 + Thresholds.AllocationsPerFrame))
+	{
+		OutFailures.Add(FString::Printf(TEXT("allocations per frame %.1f, baseline %.1f (+%.0f%% allowed)"),
+			Report.AllocationsPerFrame, Baseline.AllocationsPerFrame, Thresholds.AllocationsPerFrame * 100.0f));
+	}
+
+	if (Report.MemoryMB > Baseline.MemoryMB + Thresholds.MemoryMB)
+	{
+		OutFailures.Add(FString::Printf(TEXT("peak resident memory %.1f MB, baseline %.1f MB (+%.0f MB allowed)"),
+			Report.MemoryMB, Baseline.MemoryMB, Thresholds.MemoryMB));
+	}
+
+	return OutFailures.Num() == StartFailures;
+}
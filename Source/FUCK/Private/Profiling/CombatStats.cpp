@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatStats.h"
+
+DEFINE_STAT(STAT_COM_PlayerTick);
+DEFINE_STAT(STAT_COM_EnemyTick);
+DEFINE_STAT(STAT_COM_StateMachine);
+DEFINE_STAT(STAT_COM_AttackOverlaps);
+DEFINE_STAT(STAT_COM_LookAtSmooth);
+DEFINE_STAT(STAT_COM_CycleTarget);
+DEFINE_STAT(STAT_COM_TakeDamage);
+DEFINE_STAT(STAT_COM_HPBarVisibility);
+DEFINE_STAT(STAT_COM_WidgetUpdate);
+DEFINE_STAT(STAT_COM_Encounter);
+DEFINE_STAT(STAT_COM_StatusEffects);
+DEFINE_STAT(STAT_COM_Cooldowns);
+DEFINE_STAT(STAT_COM_SkillTimelines);
+DEFINE_STAT(STAT_COM_VFXSpawn);
+
+DEFINE_STAT(STAT_COM_OverlapQueries);
+DEFINE_STAT(STAT_COM_DamageEvents);
+DEFINE_STAT(STAT_COM_LineOfSightChecks);
+
+DEFINE_STAT(STAT_COM_RegisteredEnemies);
+DEFINE_STAT(STAT_COM_EngagedEnemies);
+
+LLM_DEFINE_TAG(CityOfMyths);
+LLM_DEFINE_TAG(CityOfMyths_Combat, "Combat", "CityOfMyths");
+LLM_DEFINE_TAG(CityOfMyths_AI, "AI", "CityOfMyths");
+LLM_DEFINE_TAG(CityOfMyths_UI, "UI", "CityOfMyths");
+LLM_DEFINE_TAG(CityOfMyths_Skills, "Skills", "CityOfMyths");
+
+int32 FCombatScopeTimes::Readers = 0;
+
+namespace CombatScopeTimes
+{
+	FCriticalSection SlotsLock;
+	TArray<TUniquePtr<FCombatScopeTimes::FSlot>> Slots;
+}
+
+FCombatScopeTimes::FSlot& FCombatScopeTimes::Register(const TCHAR* Name)
+{
+	FScopeLock Lock(&CombatScopeTimes::SlotsLock);
+
+	TUniquePtr<FSlot>& Slot = CombatScopeTimes::Slots.Add_GetRef(MakeUnique<FSlot>());
+	Slot->Name = Name;
+	return *Slot;
+}
+
+void FCombatScopeTimes::Read(TArray<TPair<const TCHAR*, uint64>>& OutCycles)
+{
+	FScopeLock Lock(&CombatScopeTimes::SlotsLock);
+
+	OutCycles.Reset(CombatScopeTimes::Slots.Num());
+
+	for (const TUniquePtr<FSlot>& Slot : CombatScopeTimes::Slots)
+	{
+		OutCycles.Emplace(Slot->Name, Slot->Cycles.load(std::memory_order_relaxed));
+	}
+}
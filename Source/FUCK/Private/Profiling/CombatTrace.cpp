@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Profiling/CombatTrace.h"
+
+#include "GameFramework/Actor.h"
+#include "HAL/PlatformTime.h"
+
+UE_TRACE_CHANNEL_DEFINE(CombatChannel);
+
+UE_TRACE_EVENT_BEGIN(CityOfMyths, ActorInfo, NoSync | Important)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Name)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(CityOfMyths, StateChange, NoSync)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, Frame)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+	UE_TRACE_EVENT_FIELD(uint8, OldState)
+	UE_TRACE_EVENT_FIELD(uint8, NewState)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(CityOfMyths, Damage, NoSync)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, Frame)
+	UE_TRACE_EVENT_FIELD(uint32, SourceId)
+	UE_TRACE_EVENT_FIELD(uint32, TargetId)
+	UE_TRACE_EVENT_FIELD(float, Amount)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(CityOfMyths, Death, NoSync)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, Frame)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(CityOfMyths, AttackTurn, NoSync)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, Frame)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(CityOfMyths, SkillCast, NoSync)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, Frame)
+	UE_TRACE_EVENT_FIELD(uint32, ActorId)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, Skill)
+UE_TRACE_EVENT_END()
+
+namespace
+{
+	uint32 GetActorId(const UObject* Object)
+	{
+		return Object ? Object->GetUniqueID() : 0;
+	}
+}
+
+void FCombatTrace::NameActor(const AActor* Actor)
+{
+	if (!UE_TRACE_CHANNELEXPR_IS_ENABLED(CombatChannel) || !Actor)
+	{
+		return;
+	}
+
+	const FString Name = Actor->GetName();
+
+	UE_TRACE_LOG(CityOfMyths, ActorInfo, CombatChannel)
+		<< ActorInfo.ActorId(GetActorId(Actor))
+		<< ActorInfo.Name(*Name, Name.Len());
+}
+
+void FCombatTrace::LogStateChange(const AActor* Actor, uint8 OldState, uint8 NewState)
+{
+	UE_TRACE_LOG(CityOfMyths, StateChange, CombatChannel)
+		<< StateChange.Cycle(FPlatformTime::Cycles64())
+		<< StateChange.Frame((uint32)GFrameCounter)
+		<< StateChange.ActorId(GetActorId(Actor))
+		<< StateChange.OldState(OldState)
+		<< StateChange.NewState(NewState);
+}
+
+void FCombatTrace::LogDamage(const AActor* Source, const AActor* Target, float Amount)
+{
+	UE_TRACE_LOG(CityOfMyths, Damage, CombatChannel)
+		<< Damage.Cycle(FPlatformTime::Cycles64())
+		<< Damage.Frame((uint32)GFrameCounter)
+		<< Damage.SourceId(GetActorId(Source))
+		<< Damage.TargetId(GetActorId(Target))
+		<< Damage.Amount(Amount);
+}
+
+void FCombatTrace::LogDeath(const AActor* Actor)
+{
+	UE_TRACE_LOG(CityOfMyths, Death, CombatChannel)
+		<< Death.Cycle(FPlatformTime::Cycles64())
+		<< Death.Frame((uint32)GFrameCounter)
+		<< Death.ActorId(GetActorId(Actor));
+}
+
+void FCombatTrace::LogAttackTurn(const AActor* Actor)
+{
+	UE_TRACE_LOG(CityOfMyths, AttackTurn, CombatChannel)
+		<< AttackTurn.Cycle(FPlatformTime::Cycles64())
+		<< AttackTurn.Frame((uint32)GFrameCounter)
+		<< AttackTurn.ActorId(GetActorId(Actor));
+}
+
+void FCombatTrace::LogSkillCast(const AActor* Caster, const UObject* Skill)
+{
+	if (!UE_TRACE_CHANNELEXPR_IS_ENABLED(CombatChannel) || !Skill)
+	{
+		return;
+	}
+
+	const FString SkillName = Skill->GetClass()->GetName();
+
+	UE_TRACE_LOG(CityOfMyths, SkillCast, CombatChannel)
+		<< SkillCast.Cycle(FPlatformTime::Cycles64())
+		<< SkillCast.Frame((uint32)GFrameCounter)
+		<< SkillCast.ActorId(GetActorId(Caster))
+		<< SkillCast.Skill(*SkillName, SkillName.Len());
+}
@@ -0,0 +1,401 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Save/CombatSaveSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "TimerManager.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/PlayerCharacter.h"
+#include "Profiling/CombatBalanceGameMode.h"
+#include "Profiling/CombatBenchmarkGameMode.h"
+#include "Profiling/CombatInputReplayComponent.h"
+#include "FUCK/FUCK.h"
+
+namespace
+{
+	// Size prefixed so a reader can skip records it has no use for
+	void WriteRecord(FArchive& Ar, TArray<uint8>& Scratch, TFunctionRef<void(FArchive&)> Write)
+	{
+		Scratch.Reset();
+		FMemoryWriter RecordAr(Scratch);
+		Write(RecordAr);
+
+		uint32 Size = Scratch.Num();
+		Ar.SerializeIntPacked(Size);
+		Ar.Serialize(Scratch.GetData(), Scratch.Num());
+	}
+
+	FString GetMapName(const UWorld* World)
+	{
+		return UWorld::RemovePIEPrefix(World->GetMapName());
+	}
+}
+
+bool UCombatSaveSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatSaveSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Actors only begin play after the subsystems, apply on top of their defaults
+	if (ShouldLoadOnBeginPlay(InWorld) && HasSave())
+	{
+		InWorld.GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateWeakLambda(this, [this]() { Load(); }));
+	}
+}
+
+bool UCombatSaveSubsystem::ShouldLoadOnBeginPlay(const UWorld& World) const
+{
+	const AGameModeBase* GameMode = World.GetAuthGameMode();
+
+	if (!GameMode || IsSimulatedWorld(World))
+	{
+		return false;
+	}
+
+	return bLoadOnBeginPlay || UGameplayStatics::HasOption(GameMode->OptionsString, ContinueOption);
+}
+
+bool UCombatSaveSubsystem::IsSimulatedWorld(const UWorld& World)
+{
+	const AGameModeBase* GameMode = World.GetAuthGameMode();
+
+	// These worlds set up their own player and enemies, a save would overwrite them or they the player's save
+	return (GameMode && (GameMode->IsA<ACombatBenchmarkGameMode>() || GameMode->IsA<ACombatBalanceGameMode>()))
+		|| UCombatInputReplayComponent::IsRequestedOnCommandLine();
+}
+
+void UCombatSaveSubsystem::Deinitialize()
+{
+	WaitForWrite();
+
+	Super::Deinitialize();
+}
+
+void UCombatSaveSubsystem::Save()
+{
+	if (IsSimulatedWorld(*GetWorld()))
+	{
+		return;
+	}
+
+	TArray<uint8> Bytes;
+	Capture(Bytes);
+
+	const uint32 Crc = FCrc::MemCrc32(Bytes.GetData(), Bytes.Num());
+
+	// The last write failed, so the state it carried isn't on disk and has to go out again
+	if (WriteTask.IsValid() && WriteTask.IsCompleted() && !WriteTask.GetResult())
+	{
+		LastWrittenCrc = 0;
+	}
+
+	if (Crc == LastWrittenCrc)
+	{
+		return;
+	}
+
+	LastWrittenCrc = Crc;
+
+	auto Write = [Bytes = MoveTemp(Bytes), Path = GetSavePath()]()
+	{
+		// A crash mid write leaves the previous save intact
+		const FString TempPath = Path + TEXT(".tmp");
+		const bool bWritten = FFileHelper::SaveArrayToFile(Bytes, *TempPath) && IFileManager::Get().Move(*Path, *TempPath);
+
+		if (!bWritten)
+		{
+			UE_LOG(LogCityOfMyths, Warning, TEXT("Failed to write save %s"), *Path);
+		}
+
+		return bWritten;
+	};
+
+	// Chained so quick saves land in order
+	WriteTask = WriteTask.IsValid()
+		? UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Write), UE::Tasks::Prerequisites(WriteTask))
+		: UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(Write));
+}
+
+bool UCombatSaveSubsystem::Load()
+{
+	if (IsSimulatedWorld(*GetWorld()))
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Not loading save %s into a benchmark, balance or replay world"), *GetSavePath());
+		return false;
+	}
+
+	WaitForWrite();
+
+	TArray<uint8> Bytes;
+	FContents Contents;
+
+	if (!FFileHelper::LoadFileToArray(Bytes, *GetSavePath(), FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	if (!Parse(Bytes, Contents))
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Save %s is corrupt or from a newer version, ignored"), *GetSavePath());
+		return false;
+	}
+
+	Apply(Bytes, Contents);
+	return true;
+}
+
+bool UCombatSaveSubsystem::HasSave() const
+{
+	return IFileManager::Get().FileExists(*GetSavePath());
+}
+
+void UCombatSaveSubsystem::WaitForWrite()
+{
+	if (WriteTask.IsValid())
+	{
+		WriteTask.Wait();
+	}
+}
+
+FString UCombatSaveSubsystem::GetSavePath() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("SaveGames") / SlotName + TEXT(".sav");
+}
+
+void UCombatSaveSubsystem::Capture(TArray<uint8>& OutBytes, bool bChangedOnly) const
+{
+	UWorld* World = GetWorld();
+
+	OutBytes.Reset();
+	FMemoryWriter Ar(OutBytes);
+	TArray<uint8> Scratch;
+
+	uint32 Magic = SaveMagic;
+	int32 Version = SaveVersion;
+	FString MapName = GetMapName(World);
+	Ar << Magic << Version << MapName;
+
+	APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(World, 0));
+
+	WriteRecord(Ar, Scratch, [Player](FArchive& RecordAr)
+	{
+		if (Player)
+		{
+			FVector3f Location(Player->GetActorLocation());
+			float Yaw = Player->GetActorRotation().Yaw;
+			RecordAr << Location << Yaw;
+
+			Player->SerializeSaveState(RecordAr, SaveVersion);
+		}
+	});
+
+	TArray<AEnemyBase*, TInlineAllocator<64>> Enemies;
+
+	for (TActorIterator<AEnemyBase> It(World); It; ++It)
+	{
+		if (!bChangedOnly || It->HasSaveState())
+		{
+			Enemies.Add(*It);
+		}
+	}
+
+	uint32 Count = Enemies.Num();
+	Ar.SerializeIntPacked(Count);
+
+	for (AEnemyBase* Enemy : Enemies)
+	{
+		uint32 Id = GetSaveId(Enemy);
+		Ar << Id;
+
+		WriteRecord(Ar, Scratch, [Enemy](FArchive& RecordAr) { Enemy->SerializeSaveState(RecordAr, SaveVersion); });
+	}
+}
+
+bool UCombatSaveSubsystem::Parse(const TArray<uint8>& Bytes, FContents& OutContents)
+{
+	FMemoryReader Ar(Bytes);
+
+	uint32 Magic = 0;
+	Ar << Magic;
+
+	if (Magic != SaveMagic)
+	{
+		return false;
+	}
+
+	Ar << OutContents.Version;
+
+	if (OutContents.Version < 1 || OutContents.Version > SaveVersion)
+	{
+		return false;
+	}
+
+	Ar << OutContents.MapName;
+
+	auto ReadRecord = [&Ar, &Bytes](FRecord& Record)
+	{
+		uint32 Size = 0;
+		Ar.SerializeIntPacked(Size);
+
+		if (Ar.IsError() || Ar.Tell() + (int64)Size > Bytes.Num())
+		{
+			return false;
+		}
+
+		Record.Offset = (int32)Ar.Tell();
+		Record.Size = (int32)Size;
+		Ar.Seek(Record.Offset + Record.Size);
+		return true;
+	};
+
+	if (!ReadRecord(OutContents.Player))
+	{
+		return false;
+	}
+
+	uint32 Count = 0;
+	Ar.SerializeIntPacked(Count);
+
+	// Every record takes at least a byte, a larger count means the file is damaged
+	if (Ar.IsError() || Count > (uint32)Bytes.Num())
+	{
+		return false;
+	}
+
+	OutContents.Enemies.SetNum(Count);
+
+	for (FRecord& Record : OutContents.Enemies)
+	{
+		Ar << Record.Id;
+
+		if (!ReadRecord(Record))
+		{
+			return false;
+		}
+	}
+
+	return !Ar.IsError();
+}
+
+void UCombatSaveSubsystem::Apply(const TArray<uint8>& Bytes, const FContents& Contents)
+{
+	UWorld* World = GetWorld();
+
+	// Positions and enemies only mean something on the map they were saved on, progression always carries over
+	const bool bSameMap = Contents.MapName == GetMapName(World);
+
+	auto View = [&Bytes](const FRecord& Record)
+	{
+		return TArrayView<const uint8>(Bytes.GetData() + Record.Offset, Record.Size);
+	};
+
+	APlayerCharacter* Player = Cast<APlayerCharacter>(UGameplayStatics::GetPlayerCharacter(World, 0));
+
+	if (Player && Contents.Player.Size > 0)
+	{
+		FMemoryReaderView Ar(View(Contents.Player));
+
+		FVector3f Location;
+		float Yaw = 0.f;
+		Ar << Location << Yaw;
+
+		Player->SerializeSaveState(Ar, Contents.Version);
+
+		if (bSameMap)
+		{
+			Player->SetActorLocationAndRotation(FVector(Location), FRotator(0.f, Yaw, 0.f), false, nullptr, ETeleportType::TeleportPhysics);
+
+			if (AController* Controller = Player->GetController())
+			{
+				Controller->SetControlRotation(FRotator(0.f, Yaw, 0.f));
+			}
+		}
+	}
+
+	if (!bSameMap || Contents.Enemies.IsEmpty())
+	{
+		return;
+	}
+
+	TMap<uint32, AEnemyBase*> Enemies;
+
+	for (TActorIterator<AEnemyBase> It(World); It; ++It)
+	{
+		Enemies.Add(GetSaveId(*It), *It);
+	}
+
+	for (const FRecord& Record : Contents.Enemies)
+	{
+		if (AEnemyBase** Enemy = Enemies.Find(Record.Id))
+		{
+			FMemoryReaderView Ar(View(Record));
+			(*Enemy)->SerializeSaveState(Ar, Contents.Version);
+		}
+	}
+}
+
+uint32 UCombatSaveSubsystem::GetSaveId(const AActor* Actor)
+{
+	// Level placed actors keep their name between runs
+	return FCrc::StrCrc32(*Actor->GetName());
+}
+
+bool UCombatSaveSubsystem::RunBenchmark(int32 Iterations)
+{
+	Iterations = FMath::Max(Iterations, 1);
+
+	WaitForWrite();
+
+	TArray<uint8> Bytes;
+	TArray<uint8> FullBytes;
+
+	uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 i = 0; i < Iterations; i++)
+	{
+		Capture(Bytes);
+	}
+
+	const double CaptureMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles) / Iterations;
+
+	Capture(FullBytes, false);
+
+	// A scratch file, the real slot is left alone
+	const FString Path = FPaths::CreateTempFilename(*FPaths::ProjectSavedDir(), TEXT("SaveBench"), TEXT(".sav"));
+
+	StartCycles = FPlatformTime::Cycles64();
+	const bool bWritten = FFileHelper::SaveArrayToFile(Bytes, *Path);
+	const double WriteMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	TArray<uint8> ReadBytes;
+	FContents Contents;
+
+	StartCycles = FPlatformTime::Cycles64();
+	const bool bRead = bWritten && FFileHelper::LoadFileToArray(ReadBytes, *Path) && Parse(ReadBytes, Contents);
+	const double LoadMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	IFileManager::Get().Delete(*Path);
+
+	if (!bRead)
+	{
+		UE_LOG(LogCityOfMyths, Warning, TEXT("Save bench: failed to write or read back %s"), *Path);
+		return false;
+	}
+
+	UE_LOG(LogCityOfMyths, Display, TEXT("Save bench (%d iterations): capture %.3f ms, write %.3f ms, read + parse %.3f ms, %d bytes with %d changed enemies (%d bytes with every enemy)"),
+		Iterations, CaptureMs, WriteMs, LoadMs, Bytes.Num(), Contents.Enemies.Num(), FullBytes.Num());
+
+	return true;
+}
@@ -2,45 +2,102 @@
 
 
 #include "SkillBase.h"
+#include "SkillsComponent.h"
+#include "Profiling/CombatTrace.h"
 
 
 USkillBase::USkillBase()
 {
-	cooldownTimestamp = 0.f;
 	cooldown = 0.f;
 }
 
-void USkillBase::Initialize()
+bool USkillBase::Initialize()
 {
-	if (UGameplayStatics::GetTimeSeconds(GetWorld()) >= cooldownTimestamp)
-	{			
-		cooldownTimestamp = UGameplayStatics::GetTimeSeconds(GetWorld()) + cooldown;
-		Cast();
+	if (!IsReady())
+	{
+		return false;
 	}
+
+	StartCooldown(cooldown);
+	Cast();
+	FCombatTrace::LogSkillCast(caster, this);
+	return true;
 }
 
 void USkillBase::Cast_Implementation()
 {
-	
+
+}
+
+void USkillBase::GatherSoftAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+}
+
+void USkillBase::StartCooldown(float duration)
+{
+	if (UCooldownSubsystem* Cooldowns = GetWorld()->GetSubsystem<UCooldownSubsystem>())
+	{
+		Cooldowns->Start(cooldownHandle, duration, FSimpleDelegate::CreateUObject(this, &USkillBase::OnCooldownReady));
+	}
+}
+
+void USkillBase::ReleaseCooldown()
+{
+	if (UCooldownSubsystem* Cooldowns = GetWorld()->GetSubsystem<UCooldownSubsystem>())
+	{
+		Cooldowns->Free(cooldownHandle);
+	}
+}
+
+FSkillTimelineHandle USkillBase::RunTimeline(FSkillTimeline&& timeline)
+{
+	if (USkillTimelineSubsystem* Timelines = GetWorld()->GetSubsystem<USkillTimelineSubsystem>())
+	{
+		return Timelines->Run(this, caster, MoveTemp(timeline));
+	}
+
+	return FSkillTimelineHandle();
+}
+
+void USkillBase::OnTimelineCancelled()
+{
+}
+
+void USkillBase::OnCooldownReady()
+{
+	if (skillsComponent)
+	{
+		skillsComponent->NotifySkillReady(this);
+	}
 }
 
 void USkillBase::CooldownCut(float cut)
 {
-	if (cut != 0.f)
+	UCooldownSubsystem* Cooldowns = GetWorld()->GetSubsystem<UCooldownSubsystem>();
+
+	if (!Cooldowns)
 	{
-		cooldownTimestamp += -cut;
-		//GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::SanitizeFloat(cooldownTimestamp));
+		return;
+	}
 
+	if (cut != 0.f)
+	{
+		Cooldowns->Reduce(cooldownHandle, cut);
 	}
 	else
 	{
-		cooldownTimestamp = 0.0f;
-		//GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::SanitizeFloat(cooldownTimestamp));
-		//GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::SanitizeFloat(UGameplayStatics::GetTimeSeconds(GetWorld())));
+		Cooldowns->Finish(cooldownHandle);
 	}
 }
 
-float USkillBase::GetCooldown()
+float USkillBase::GetCooldown() const
+{
+	const UCooldownSubsystem* Cooldowns = GetWorld()->GetSubsystem<UCooldownSubsystem>();
+
+	return Cooldowns ? Cooldowns->GetRemaining(cooldownHandle) : 0.f;
+}
+
+bool USkillBase::IsReady() const
 {
-	return  FMath::Clamp(cooldownTimestamp - UGameplayStatics::GetTimeSeconds(GetWorld()), 0, INFINITY);
+	return GetCooldown() <= 0.f;
 }
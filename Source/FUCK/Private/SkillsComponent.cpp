@@ -2,98 +2,206 @@
 
 
 #include "SkillsComponent.h"
+#include "Engine/AssetManager.h"
+#include "Components/InputComponent.h"
+#include "Combat/CombatWarmupSubsystem.h"
+#include "Data/SkillDefinition.h"
+#include "Profiling/CombatStats.h"
+#include "FUCK/FUCK.h"
 
 // Sets default values for this component's properties
 USkillsComponent::USkillsComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
-	
-
-	// ...
+	// Cooldowns run in UCooldownSubsystem, nothing here needs a tick
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
 
 // Called when the game starts
 void USkillsComponent::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(CityOfMyths_Skills);
+
 	Super::BeginPlay();
-	
-	this->GetOwner()->InputComponent->BindAction(FName("Skill1"), IE_Pressed, this, &USkillsComponent::SkillOne);
-	this->GetOwner()->InputComponent->BindAction(FName("Skill2"), IE_Pressed, this, &USkillsComponent::SkillTwo);
-	this->GetOwner()->InputComponent->BindAction(FName("Skill3"), IE_Pressed, this, &USkillsComponent::SkillThree);
-	this->GetOwner()->InputComponent->BindAction(FName("Skill4"), IE_Pressed, this, &USkillsComponent::SkillFour);
-	
-	for (int32 i = 0; i < skillsClass.Num(); i++)
-	{
-		if (skillsClass[i])
+
+	for (USkillDefinition* skillDefinition : skillDefinitions)
+	{
+		skillsObject.Add(skillDefinition ? CreateSkill(skillDefinition->skillClass, skillDefinition) : nullptr);
+	}
+
+	for (const TSubclassOf<USkillBase>& skillClass : skillsClass)
+	{
+		skillsObject.Add(CreateSkill(skillClass, nullptr));
+	}
+
+	UE_LOG(LogCityOfMyths, Verbose, TEXT("%s: %d skill slots"), *GetNameSafe(GetOwner()), skillsObject.Num());
+
+	const float initialRemaining = initialCooldown - GetWorld()->GetTimeSeconds();
+
+	if (initialRemaining > 0.f)
+	{
+		for (USkillBase* skill : skillsObject)
 		{
-			skillsObject.Add(NewObject<USkillBase>(this->GetOwner(), skillsClass[i]));
-			GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Green, skillsClass[i]->GetName());
+			if (skill)
+			{
+				skill->StartCooldown(initialRemaining);
+			}
 		}
+	}
+
+	skillInputBuffer.Window = inputBufferWindow;
+	BindSkillInput();
 
-		if (skillsObject[i])
+	TArray<FSoftObjectPath> SkillAssets;
+	for (const USkillBase* SkillObject : skillsObject)
+	{
+		if (SkillObject)
 		{
-			GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::Printf(TEXT("Skill object %d initialized"), i));
-			skillsObject[i]->cooldownTimestamp = 1.f;
-			skillsObject[i]->skillsComponent = this;
-			skillsObject[i]->player = Cast<APlayerCharacter>(GetOwner());
+			SkillObject->GatherSoftAssets(SkillAssets);
 		}
 	}
+
+	if (SkillAssets.Num() > 0)
+	{
+		skillsAssetsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(SkillAssets,
+			FStreamableDelegate::CreateUObject(this, &USkillsComponent::OnSkillsAssetsLoaded));
+	}
+	else
+	{
+		OnSkillsAssetsLoaded();
+	}
 }
 
-// Called every frame
-void USkillsComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+USkillBase* USkillsComponent::CreateSkill(TSubclassOf<USkillBase> skillClass, USkillDefinition* definition)
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (!skillClass)
+	{
+		return nullptr;
+	}
+
+	USkillBase* skill = NewObject<USkillBase>(GetOwner(), skillClass);
+	skill->skillsComponent = this;
+	skill->caster = Cast<ACombatant>(GetOwner());
+	skill->player = Cast<APlayerCharacter>(GetOwner());
+	skill->definition = definition;
 
-	// ...
+	if (definition && definition->cooldown >= 0.f)
+	{
+		skill->cooldown = definition->cooldown;
+	}
+
+	return skill;
 }
 
-void USkillsComponent::SkillOne()
+void USkillsComponent::BindSkillInput()
 {
-	if (skillsObject.IsValidIndex(0))
-		if(skillsObject[0])
-		{
-			skillsObject[0]->Initialize();
-		}
+	// Enemies drive their skills from AI and have no input component
+	UInputComponent* Input = GetOwner()->InputComponent;
 
+	if (!Input)
+	{
+		const APawn* pawn = Cast<APawn>(GetOwner());
+		UE_CLOG(pawn && pawn->IsPlayerControlled(), LogCityOfMyths, Warning,
+			TEXT("%s: no input component at BeginPlay, %d skill slots have no input"), *GetNameSafe(GetOwner()), skillsObject.Num());
+		return;
+	}
 
+	for (int32 i = 0; i < skillsObject.Num(); i++)
+	{
+		FInputActionBinding Binding(FName(*FString::Printf(TEXT("Skill%d"), i + 1)), IE_Pressed);
+		Binding.ActionDelegate.GetDelegateForManualSet().BindUObject(this, &USkillsComponent::SkillInput, i);
+		Input->AddActionBinding(MoveTemp(Binding));
+	}
 }
 
-void USkillsComponent::SkillTwo()
+void USkillsComponent::OnSkillsAssetsLoaded()
 {
-	if (skillsObject.IsValidIndex(1))
-		if (skillsObject[1]) 
-		{
-			skillsObject[1]->Initialize();
-		}
+	if (auto Warmup = GetWorld()->GetSubsystem<UCombatWarmupSubsystem>())
+	{
+		Warmup->WarmupSkills(skillsObject);
+	}
 }
 
-void USkillsComponent::SkillThree()
+void USkillsComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (skillsObject.IsValidIndex(2))
-		if (skillsObject[2]) 
+	for (USkillBase* SkillObject : skillsObject)
+	{
+		if (SkillObject)
 		{
-			skillsObject[2]->Initialize();
+			SkillObject->ReleaseCooldown();
 		}
+	}
+
+	if (skillsAssetsHandle.IsValid())
+	{
+		skillsAssetsHandle->ReleaseHandle();
+		skillsAssetsHandle.Reset();
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void USkillsComponent::SkillFour()
+void USkillsComponent::ResetSkills()
 {
-	if (skillsObject.IsValidIndex(3))
-		if (skillsObject[3]) 
+	skillInputBuffer.Clear();
+
+	USkillTimelineSubsystem* Timelines = GetWorld()->GetSubsystem<USkillTimelineSubsystem>();
+
+	for (USkillBase* SkillObject : skillsObject)
+	{
+		if (SkillObject)
 		{
-			skillsObject[3]->Initialize();
+			const int32 Cancelled = Timelines ? Timelines->CancelAll(SkillObject) : 0;
+
+			for (int32 i = 0; i < Cancelled; i++)
+			{
+				SkillObject->OnTimelineCancelled();
+			}
+
+			SkillObject->CooldownCut();
 		}
+	}
 }
 
-void USkillsComponent::Skill(int index)
+void USkillsComponent::SkillInput(int32 index)
 {
-	if (skillsObject.IsValidIndex(index))
-		if (skillsObject[index])
-		{
-			skillsObject[index]->Initialize();
-		}
+	if (Skill(index))
+	{
+		skillInputBuffer.RecordImmediate();
+	}
+	else if (skillsObject.IsValidIndex(index) && skillsObject[index] && GetCooldown(index) <= inputBufferWindow)
+	{
+		skillInputBuffer.Push(GetWorld()->GetTimeSeconds(), ECombatInputAction::Skill, index);
+	}
+}
+
+bool USkillsComponent::Skill(int32 index)
+{
+	if (skillsObject.IsValidIndex(index) && skillsObject[index])
+	{
+		return skillsObject[index]->Initialize();
+	}
+
+	return false;
+}
+
+float USkillsComponent::GetCooldown(int32 index) const
+{
+	if (skillsObject.IsValidIndex(index) && skillsObject[index])
+	{
+		return skillsObject[index]->GetCooldown();
+	}
+
+	return 0.f;
+}
+
+void USkillsComponent::NotifySkillReady(USkillBase* skill)
+{
+	const int32 index = skillsObject.Find(skill);
+
+	if (index != INDEX_NONE)
+	{
+		OnSkillReady.Broadcast(index);
+		skillInputBuffer.Consume(GetWorld()->GetTimeSeconds(), [this](const FCombatInputBuffer::FEntry& Entry) { return Skill(Entry.Slot); });
+	}
 }
@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Combat/CombatWarmupSubsystem.h"
+#include "Profiling/CombatBenchmarkGameMode.h"
+#include "Profiling/CombatMicroBench.h"
+#include "Save/CombatSaveSubsystem.h"
+#include "FUCK/Android.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCK/PlayerCharacter.h"
+
+namespace CombatPerformanceTests
+{
+	/**
+	 * A game world of the test's own, with a game instance so actors can create
+	 * their widgets. Torn down when it goes out of scope.
+	 */
+	class FTestWorld
+	{
+	public:
+		FTestWorld()
+		{
+			GameInstance = NewObject<UGameInstance>(GEngine);
+			GameInstance->AddToRoot();
+			GameInstance->InitializeStandalone(TEXT("CombatTestWorld"));
+
+			World = GameInstance->GetWorld();
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+		}
+
+		~FTestWorld()
+		{
+			GameInstance->Shutdown();
+
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+
+			GameInstance->RemoveFromRoot();
+
+			CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+		}
+
+		UWorld* GetWorld() const { return World; }
+
+		// Possessed by a player controller of its own. The HUD widget is left out, there is no viewport.
+		APlayerCharacter* SpawnPlayer(UClass* Class, const FVector& Location = FVector::ZeroVector)
+		{
+			APlayerController* Controller = World->SpawnActor<APlayerController>();
+			APlayerCharacter* Player = World->SpawnActorDeferred<APlayerCharacter>(Class ? Class : APlayerCharacter::StaticClass(),
+				FTransform(Location), nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+
+			if (!Controller || !Player)
+			{
+				return nullptr;
+			}
+
+			Player->PlayerCharacterWidgetClass = nullptr;
+			Player->FinishSpawning(FTransform(Location));
+			Controller->Possess(Player);
+
+			return Player;
+		}
+
+		// Ticks the world Frames times, returning the slowest tick in milliseconds
+		float Tick(int32 Frames, float DeltaSeconds = 1.0f / 60.0f)
+		{
+			float WorstMs = 0.0f;
+
+			for (int32 i = 0; i < Frames; i++)
+			{
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+
+				World->Tick(LEVELTICK_All, DeltaSeconds);
+				GFrameCounter++;
+
+				WorstMs = FMath::Max(WorstMs, (float)FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+			}
+
+			return WorstMs;
+		}
+
+	private:
+		UGameInstance* GameInstance = nullptr;
+		UWorld* World = nullptr;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatMicroBenchTest, "CityOfMyths.Performance.MicroBench", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FCombatMicroBenchTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 EnemyCount = 50;
+	constexpr int32 Iterations = 10000;
+
+	CombatPerformanceTests::FTestWorld TestWorld;
+	APlayerCharacter* Player = TestWorld.SpawnPlayer(APlayerCharacter::StaticClass());
+
+	if (!TestNotNull(TEXT("Player"), Player))
+	{
+		return false;
+	}
+
+	const TArray<FCombatMicroBenchResult> Results = FCombatMicroBench::Run(Player, EnemyCount, Iterations);
+
+	if (!TestFalse(TEXT("Micro bench produced no results"), Results.IsEmpty()))
+	{
+		return false;
+	}
+
+	for (const FCombatMicroBenchResult& Result : Results)
+	{
+		AddInfo(FString::Printf(TEXT("%s: %.1f ns/op, %.2f allocs/op"), *Result.Name, Result.NsPerOp, Result.AllocsPerOp));
+	}
+
+	return TestTrue(TEXT("Report written"),
+		FCombatMicroBench::WriteReport(Results, EnemyCount, FPaths::Combine(FPaths::ProfilingDir(), TEXT("MicroBench.json"))));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatFirstCastTest, "CityOfMyths.Performance.FirstCast", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FCombatFirstCastTest::RunTest(const FString& Parameters)
+{
+	// Frames timed after each first use, the one it happened in included
+	constexpr int32 FramesPerProbe = 10;
+	// Long enough for the encounter to stream the archetypes in and warm the enemies up
+	constexpr int32 WarmupFrames = 120;
+
+	const ACombatBenchmarkGameMode* Bench = GetDefault<ACombatBenchmarkGameMode>();
+
+	CombatPerformanceTests::FTestWorld TestWorld;
+	APlayerCharacter* Player = TestWorld.SpawnPlayer(Bench->PlayerClass.LoadSynchronous());
+
+	if (!TestNotNull(TEXT("Player"), Player))
+	{
+		return false;
+	}
+
+	TArray<UClass*> Classes;
+
+	for (const TSoftClassPtr<AEnemyBase>& Class : { Bench->AndroidClass, Bench->MechClass, Bench->BossClass })
+	{
+		if (UClass* Loaded = Class.LoadSynchronous())
+		{
+			Classes.Add(Loaded);
+		}
+	}
+
+	TArray<TWeakObjectPtr<AEnemyBase>> Enemies;
+	ACombatBenchmarkGameMode::SpawnEnemyRings(TestWorld.GetWorld(), Player->GetActorLocation(), Classes, Bench->MinSpawnRadius, Bench->SpawnSpacing,
+		[](AEnemyBase*) {}, Enemies);
+
+	TestWorld.Tick(WarmupFrames);
+	FlushAsyncLoading();
+	TestWorld.Tick(1);
+
+	UCombatWarmupSubsystem* Warmup = TestWorld.GetWorld()->GetSubsystem<UCombatWarmupSubsystem>();
+
+	if (!TestNotNull(TEXT("Warmup subsystem"), Warmup))
+	{
+		return false;
+	}
+
+	TArray<FCombatFirstUseProbe> Probes;
+	Warmup->GatherFirstUseProbes(Probes);
+
+	if (!TestFalse(TEXT("No skills or attacks to probe"), Probes.IsEmpty()))
+	{
+		return false;
+	}
+
+	float Worst = 0.0f;
+	FString Json = TEXT("{\n\t\"samples\": [\n");
+
+	for (int32 i = 0; i < Probes.Num(); i++)
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		Probes[i].Action();
+		const float CastMs = (float)FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		const float WorstFrameMs = TestWorld.Tick(FramesPerProbe);
+		Worst = FMath::Max(Worst, WorstFrameMs);
+
+		AddInfo(FString::Printf(TEXT("First use %s: cast %.2f ms, worst frame %.2f ms"), *Probes[i].Name, CastMs, WorstFrameMs));
+
+		Json += FString::Printf(TEXT("\t\t{ \"name\": \"%s\", \"castMs\": %.3f, \"worstFrameMs\": %.3f }%s\n"),
+			*Probes[i].Name, CastMs, WorstFrameMs, i + 1 < Probes.Num() ? TEXT(",") : TEXT(""));
+	}
+
+	Json += FString::Printf(TEXT("\t],\n\t\"worstFrameMs\": %.3f,\n\t\"warmup\": \"%s\"\n}\n"), Worst, *Warmup->GetReport().ToString());
+
+	AddInfo(FString::Printf(TEXT("First use worst frame: %.2f ms, warmup %s"), Worst, *Warmup->GetReport().ToString()));
+
+	return TestTrue(TEXT("Report written"), FFileHelper::SaveStringToFile(Json, *FPaths::Combine(FPaths::ProfilingDir(), TEXT("FirstCast.json"))));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FCombatSaveBenchTest, "CityOfMyths.Performance.SaveBench", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FCombatSaveBenchTest::RunTest(const FString& Parameters)
+{
+	constexpr int32 EnemyCount = 200;
+	constexpr int32 Iterations = 100;
+
+	const ACombatBenchmarkGameMode* Bench = GetDefault<ACombatBenchmarkGameMode>();
+
+	CombatPerformanceTests::FTestWorld TestWorld;
+	APlayerCharacter* Player = TestWorld.SpawnPlayer(APlayerCharacter::StaticClass());
+
+	if (!TestNotNull(TEXT("Player"), Player))
+	{
+		return false;
+	}
+
+	TArray<UClass*> Classes;
+	Classes.Init(AAndroid::StaticClass(), EnemyCount);
+
+	TArray<TWeakObjectPtr<AEnemyBase>> Enemies;
+	ACombatBenchmarkGameMode::SpawnEnemyRings(TestWorld.GetWorld(), Player->GetActorLocation(), Classes, Bench->MinSpawnRadius, Bench->SpawnSpacing,
+		[](AEnemyBase*) {}, Enemies);
+
+	// A map mid playthrough: every other enemy has been in a fight and goes into the save
+	for (int32 i = 0; i < Enemies.Num(); i += 2)
+	{
+		if (AEnemyBase* Enemy = Enemies[i].Get())
+		{
+			Enemy->ApplyHealthDelta(-1.0f);
+		}
+	}
+
+	UCombatSaveSubsystem* Saves = TestWorld.GetWorld()->GetSubsystem<UCombatSaveSubsystem>();
+
+	if (!TestNotNull(TEXT("Save subsystem"), Saves))
+	{
+		return false;
+	}
+
+	return TestTrue(TEXT("Save wrote and read back"), Saves->RunBenchmark(Iterations));
+}
+
+#endif
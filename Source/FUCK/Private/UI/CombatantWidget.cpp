@@ -2,6 +2,7 @@
 
 
 #include "FUCK/Public/UI/CombatantWidget.h"
+#include "Profiling/CombatStats.h"
 
 void UCombatantWidget::Init(ACombatant* Combatant)
 {
@@ -19,12 +20,16 @@ void UCombatantWidget::NativeConstruct()
 
 void UCombatantWidget::OnHealthChanged(const float Value)
 {
+	COM_SCOPE(STAT_COM_WidgetUpdate);
+
 	Health = Value;
 	OnHealthUpdated();
 }
 
 void UCombatantWidget::OnMaxHealthChanged(const float Value)
 {
+	COM_SCOPE(STAT_COM_WidgetUpdate);
+
 	MaxHealth = Value;
 	OnMaxHealthUpdated();
 }
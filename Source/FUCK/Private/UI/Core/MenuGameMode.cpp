@@ -4,6 +4,7 @@
 #include "UI/Core/MenuGameMode.h"
 
 #include "Blueprint/UserWidget.h"
+#include "Profiling/CombatStats.h"
 
 AMenuGameMode::AMenuGameMode()
 {
@@ -15,6 +16,8 @@ void AMenuGameMode::InitializeHUDForPlayer_Implementation(APlayerController* New
 
 	if (MainMenuWidgetClass)
 	{
+		LLM_SCOPE_BYTAG(CityOfMyths_UI);
+
 		if (auto Widget = Cast<UMainMenu>(CreateWidget(GetGameInstance(), MainMenuWidgetClass)))
 		{
 			Widget->Init();
@@ -3,7 +3,46 @@
 
 #include "FUCK/Public/UI/GameHUD.h"
 
+#include "AIController.h"
 #include "Blueprint/UserWidget.h"
+#include "Engine/Canvas.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationSystem.h"
+#include "UObject/UObjectHash.h"
+#include "Combat/EncounterSubsystem.h"
+#include "Profiling/CombatStats.h"
+#include "FUCK/CombatManager.h"
+#include "FUCK/EnemyBase.h"
+
+static FAutoConsoleCommandWithWorld PerfOverlayCommand(
+	TEXT("com.PerfOverlay"),
+	TEXT("Shows or hides the combat perf overlay"),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		const APlayerController* Controller = World ? World->GetFirstPlayerController() : nullptr;
+
+		if (AGameHUD* HUD = Controller ? Cast<AGameHUD>(Controller->GetHUD()) : nullptr)
+		{
+			HUD->TogglePerfOverlay();
+		}
+	}));
+
+namespace GameHUD
+{
+	const FLinearColor Background(0.0f, 0.0f, 0.0f, 0.6f);
+	const FLinearColor Text(0.9f, 0.9f, 0.9f);
+	const FLinearColor Warning(1.0f, 0.75f, 0.2f);
+	const FLinearColor FrameLine(0.3f, 0.9f, 0.3f);
+	const FLinearColor GameThreadLine(0.3f, 0.6f, 1.0f);
+	const FLinearColor BudgetLine(1.0f, 1.0f, 1.0f, 0.3f);
+
+	// Graph top, frames above are clipped
+	constexpr float GraphMaxMs = 50.0f;
+	constexpr float LineHeight = 14.0f;
+	constexpr int32 MaxScopes = 8;
+}
 
 AGameHUD::AGameHUD()
 {
@@ -14,3 +53,244 @@ void AGameHUD::BeginPlay()
 	Super::BeginPlay();
 	PlayerCharacter = Cast<APlayerCharacter>(GetOwningPlayerController()->GetCharacter());
 }
+
+void AGameHUD::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bShowPerfOverlay)
+	{
+		TogglePerfOverlay();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AGameHUD::TogglePerfOverlay()
+{
+	bShowPerfOverlay = !bShowPerfOverlay;
+
+	if (bShowPerfOverlay)
+	{
+		FCombatScopeTimes::AddReader();
+
+		FrameMs.Init(0.0f, GraphFrames);
+		GameThreadMs.Init(0.0f, GraphFrames);
+		GraphHead = 0;
+		NextRefreshTime = 0.0;
+
+		// Leaves out what the scopes gathered before the overlay was shown
+		FCombatScopeTimes::Read(LastScopeCycles);
+		FramesSinceRefresh = 0;
+
+		PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &AGameHUD::OnPreGarbageCollect);
+		PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &AGameHUD::OnPostGarbageCollect);
+	}
+	else
+	{
+		FCombatScopeTimes::RemoveReader();
+
+		FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+		FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+	}
+}
+
+void AGameHUD::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void AGameHUD::OnPostGarbageCollect()
+{
+	LastGCMs = float((FPlatformTime::Seconds() - GCStartTime) * 1000.0);
+	GCCount++;
+}
+
+void AGameHUD::DrawHUD()
+{
+	Super::DrawHUD();
+
+	if (!bShowPerfOverlay)
+	{
+		return;
+	}
+
+	RecordFrame();
+
+	const double Now = FPlatformTime::Seconds();
+
+	if (Now >= NextRefreshTime)
+	{
+		RefreshPerfSnapshot();
+		NextRefreshTime = Now + PerfOverlayRefreshInterval;
+	}
+
+	DrawPerfOverlay();
+}
+
+void AGameHUD::RecordFrame()
+{
+	FrameMs[GraphHead] = FApp::GetDeltaTime() * 1000.0;
+	GameThreadMs[GraphHead] = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	GraphHead = (GraphHead + 1) % GraphFrames;
+	FramesSinceRefresh++;
+}
+
+void AGameHUD::RefreshPerfSnapshot()
+{
+	Snapshot = FPerfSnapshot();
+
+	// Scopes hit from several places report under one name
+	TArray<TPair<const TCHAR*, uint64>> Cycles;
+	FCombatScopeTimes::Read(Cycles);
+
+	TMap<FString, float> ScopeMs;
+	for (int32 i = 0; i < Cycles.Num(); i++)
+	{
+		const uint64 Last = LastScopeCycles.IsValidIndex(i) ? LastScopeCycles[i].Value : 0;
+
+		FString Name(Cycles[i].Key);
+		Name.RemoveFromStart(TEXT("STAT_COM_"));
+		ScopeMs.FindOrAdd(Name) += FPlatformTime::ToMilliseconds64(Cycles[i].Value - Last) / FMath::Max(FramesSinceRefresh, 1);
+	}
+
+	LastScopeCycles = MoveTemp(Cycles);
+	FramesSinceRefresh = 0;
+
+	for (const TPair<FString, float>& Scope : ScopeMs)
+	{
+		Snapshot.ScopeMs.Add(Scope);
+	}
+
+	Snapshot.ScopeMs.Sort([](const TPair<FString, float>& A, const TPair<FString, float>& B)
+	{
+		return A.Value > B.Value;
+	});
+
+	if (const UEncounterSubsystem* Encounters = GetWorld()->GetSubsystem<UEncounterSubsystem>())
+	{
+		for (const TWeakObjectPtr<AEnemyBase>& Enemy : Encounters->GetEnemies())
+		{
+			if (!Enemy.IsValid())
+			{
+				continue;
+			}
+
+			Snapshot.Enemies++;
+			Snapshot.EnemiesTicking += Enemy->IsActorTickEnabled() ? 1 : 0;
+			Snapshot.AttackTurns += Enemy->isAttackTurn ? 1 : 0;
+
+			if (Enemy->ActiveState == State::DEAD)
+			{
+				Snapshot.EnemiesDead++;
+			}
+			else if (Enemy->ActiveState == State::IDLE)
+			{
+				Snapshot.EnemiesIdle++;
+			}
+			else
+			{
+				Snapshot.EnemiesActive++;
+			}
+
+			const AAIController* AI = Cast<AAIController>(Enemy->GetController());
+			const UPathFollowingComponent* PathFollowing = AI ? AI->GetPathFollowingComponent() : nullptr;
+
+			if (PathFollowing && PathFollowing->GetStatus() == EPathFollowingStatus::Moving)
+			{
+				Snapshot.PathsMoving++;
+			}
+			else if (PathFollowing && PathFollowing->GetStatus() == EPathFollowingStatus::Waiting)
+			{
+				Snapshot.PathsWaiting++;
+			}
+		}
+	}
+
+	if (PlayerCharacter)
+	{
+		if (const UCombatManager* Manager = PlayerCharacter->FindComponentByClass<UCombatManager>())
+		{
+			Snapshot.AttackResource = Manager->attackResource;
+		}
+	}
+
+	if (const UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()))
+	{
+		Snapshot.NavBuildTasks = NavSystem->GetNumRemainingBuildTasks();
+	}
+
+	// Through the class hash, not a walk over every object
+	TArray<UObject*> Widgets;
+	GetObjectsOfClass(UUserWidget::StaticClass(), Widgets, true, RF_ClassDefaultObject);
+
+	Snapshot.Widgets = Widgets.Num();
+	for (const UObject* Widget : Widgets)
+	{
+		Snapshot.WidgetsInViewport += CastChecked<UUserWidget>(Widget)->IsInViewport() ? 1 : 0;
+	}
+}
+
+void AGameHUD::DrawPerfOverlay()
+{
+	using namespace GameHUD;
+
+	const float X = 20.0f;
+	const float Width = 340.0f;
+	const float GraphHeight = 80.0f;
+	float Y = 60.0f;
+
+	const int32 Lines = 9 + FMath::Min(Snapshot.ScopeMs.Num(), MaxScopes);
+	DrawRect(Background, X - 8.0f, Y - 8.0f, Width + 16.0f, GraphHeight + Lines * LineHeight + 24.0f);
+
+	DrawFrameGraph(X, Y, Width, GraphHeight);
+	Y += GraphHeight + 8.0f;
+
+	UFont* Font = GEngine->GetTinyFont();
+	auto Line = [this, Font, X, &Y](const FString& Text, const FLinearColor& Color = GameHUD::Text)
+	{
+		DrawText(Text, Color, X, Y, Font);
+		Y += LineHeight;
+	};
+
+	const int32 Last = (GraphHead + GraphFrames - 1) % GraphFrames;
+	Line(FString::Printf(TEXT("Frame %.1f ms   Game thread %.1f ms"), FrameMs[Last], GameThreadMs[Last]), FrameMs[Last] > 33.3f ? Warning : GameHUD::Text);
+
+	for (int32 i = 0; i < FMath::Min(Snapshot.ScopeMs.Num(), MaxScopes); i++)
+	{
+		Line(FString::Printf(TEXT("  %-20s %6.2f ms"), *Snapshot.ScopeMs[i].Key, Snapshot.ScopeMs[i].Value));
+	}
+
+	Line(FString::Printf(TEXT("Enemies %d: %d active, %d idle, %d dead, %d ticking"),
+		Snapshot.Enemies, Snapshot.EnemiesActive, Snapshot.EnemiesIdle, Snapshot.EnemiesDead, Snapshot.EnemiesTicking));
+	Line(FString::Printf(TEXT("Attack turns %d, attack resource %.0f / 100"), Snapshot.AttackTurns, Snapshot.AttackResource));
+	Line(FString::Printf(TEXT("Paths %d moving, %d waiting, %d nav build tasks"), Snapshot.PathsMoving, Snapshot.PathsWaiting, Snapshot.NavBuildTasks),
+		Snapshot.PathsWaiting > 0 ? Warning : GameHUD::Text);
+	Line(FString::Printf(TEXT("Widgets %d, %d in viewport"), Snapshot.Widgets, Snapshot.WidgetsInViewport));
+	Line(FString::Printf(TEXT("GC %d runs, last %.1f ms"), GCCount, LastGCMs), LastGCMs > 10.0f ? Warning : GameHUD::Text);
+}
+
+void AGameHUD::DrawFrameGraph(float X, float Y, float Width, float Height)
+{
+	using namespace GameHUD;
+
+	auto ToScreenY = [Y, Height](float Ms)
+	{
+		return Y + Height - FMath::Min(Ms / GraphMaxMs, 1.0f) * Height;
+	};
+
+	// 60 and 30 fps
+	DrawLine(X, ToScreenY(16.7f), X + Width, ToScreenY(16.7f), BudgetLine);
+	DrawLine(X, ToScreenY(33.3f), X + Width, ToScreenY(33.3f), BudgetLine);
+
+	const float Step = Width / (GraphFrames - 1);
+
+	// Oldest sample on the left
+	for (int32 i = 1; i < GraphFrames; i++)
+	{
+		const int32 Previous = (GraphHead + i - 1) % GraphFrames;
+		const int32 Current = (GraphHead + i) % GraphFrames;
+		const float StartX = X + (i - 1) * Step;
+
+		DrawLine(StartX, ToScreenY(FrameMs[Previous]), StartX + Step, ToScreenY(FrameMs[Current]), FrameLine);
+		DrawLine(StartX, ToScreenY(GameThreadMs[Previous]), StartX + Step, ToScreenY(GameThreadMs[Current]), GameThreadLine);
+	}
+}
@@ -3,6 +3,7 @@
 
 #include "UI/GameOver/UGameOverWidget.h"
 #include "Kismet/GameplayStatics.h"
+#include "Combat/CheckpointSubsystem.h"
 
 void UUGameOverWidget::Init()
 {
@@ -14,3 +15,25 @@ void UUGameOverWidget::LoadMainMenu()
 {
 	UGameplayStatics::OpenLevelBySoftObjectPtr(GetWorld(), MainMenuMap, false);
 }
+
+void UUGameOverWidget::Retry()
+{
+	UCheckpointSubsystem* Checkpoints = GetWorld()->GetSubsystem<UCheckpointSubsystem>();
+
+	if (!Checkpoints || !Checkpoints->Restore())
+	{
+		return;
+	}
+
+	RemoveFromParent();
+
+	GetOwningPlayer()->SetShowMouseCursor(false);
+	GetOwningPlayer()->SetInputMode(FInputModeGameOnly());
+}
+
+bool UUGameOverWidget::CanRetry() const
+{
+	const UCheckpointSubsystem* Checkpoints = GetWorld()->GetSubsystem<UCheckpointSubsystem>();
+
+	return Checkpoints && Checkpoints->HasCheckpoint();
+}
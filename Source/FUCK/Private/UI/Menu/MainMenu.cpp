@@ -5,6 +5,7 @@
 
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetSystemLibrary.h"
+#include "Save/CombatSaveSubsystem.h"
 
 void UMainMenu::Init()
 {
@@ -15,6 +16,17 @@ void UMainMenu::StartGame()
 	UGameplayStatics::OpenLevelBySoftObjectPtr(GetWorld(), StartLevel, false);
 }
 
+void UMainMenu::ContinueGame()
+{
+	UGameplayStatics::OpenLevelBySoftObjectPtr(GetWorld(), StartLevel, false, UCombatSaveSubsystem::ContinueOption);
+}
+
+bool UMainMenu::CanContinue() const
+{
+	const UCombatSaveSubsystem* Saves = GetWorld() ? GetWorld()->GetSubsystem<UCombatSaveSubsystem>() : nullptr;
+	return Saves && Saves->HasSave();
+}
+
 void UMainMenu::ExitGame()
 {
 	UKismetSystemLibrary::QuitGame(GetWorld(), GetOwningPlayer(), EQuitPreference::Quit, false);
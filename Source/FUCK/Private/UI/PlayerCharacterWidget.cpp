@@ -2,6 +2,7 @@
 
 
 #include "UI/PlayerCharacterWidget.h"
+#include "Profiling/CombatStats.h"
 
 void UPlayerCharacterWidget::Init(APlayerCharacter* PlayerCharacter)
 {
@@ -31,6 +32,8 @@ void UPlayerCharacterWidget::OnLevelChanged(const int Value)
 
 void UPlayerCharacterWidget::UpdateProgress() const
 {
+	COM_SCOPE(STAT_COM_WidgetUpdate);
+
 	XPProgressBar->SetPercent(XP / MaxXP);
 }
 
@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "VFX/CombatVFXSubsystem.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "NiagaraComponent.h"
+#include "NiagaraFunctionLibrary.h"
+#include "NiagaraSystem.h"
+#include "Profiling/CombatStats.h"
+
+bool UCombatVFXSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatVFXSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	InWorld.GetTimerManager().SetTimer(ExpireHandle, this, &UCombatVFXSubsystem::ExpireEffects, 1.0f, true);
+}
+
+void UCombatVFXSubsystem::Deinitialize()
+{
+	if (UWorld* World = GetWorld())
+	{
+		World->GetTimerManager().ClearTimer(ExpireHandle);
+	}
+
+	for (TArray<FActiveEffect>& Effects : Active)
+	{
+		Effects.Empty();
+	}
+
+	Super::Deinitialize();
+}
+
+FCombatVFXHandle UCombatVFXSubsystem::SpawnAtLocation(UNiagaraSystem* System, ECombatVFXType Type, FVector Location, FRotator Rotation)
+{
+	COM_SCOPE(STAT_COM_VFXSpawn);
+
+	if (!System || !MakeRoom(Type, Location))
+	{
+		return FCombatVFXHandle();
+	}
+
+	UNiagaraComponent* Component = UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), System, Location, Rotation,
+		FVector(1.0f), false, true, ENCPoolMethod::AutoRelease, true);
+
+	return Track(Component, Type);
+}
+
+FCombatVFXHandle UCombatVFXSubsystem::SpawnAttached(UNiagaraSystem* System, ECombatVFXType Type, USceneComponent* AttachTo, FName SocketName)
+{
+	COM_SCOPE(STAT_COM_VFXSpawn);
+
+	if (!System || !AttachTo || !MakeRoom(Type, AttachTo->GetSocketLocation(SocketName)))
+	{
+		return FCombatVFXHandle();
+	}
+
+	UNiagaraComponent* Component = UNiagaraFunctionLibrary::SpawnSystemAttached(System, AttachTo, SocketName, FVector(0.f), FRotator(0.f),
+		EAttachLocation::Type::KeepRelativeOffset, false, true, ENCPoolMethod::AutoRelease, true);
+
+	return Track(Component, Type);
+}
+
+void UCombatVFXSubsystem::Release(const FCombatVFXHandle& Handle)
+{
+	if (!Handle.IsValid())
+	{
+		return;
+	}
+
+	for (const TArray<FActiveEffect>& Effects : Active)
+	{
+		for (const FActiveEffect& Effect : Effects)
+		{
+			// A different serial means the pool already handed the component to someone else
+			if (Effect.Serial == Handle.Serial && Effect.Component == Handle.Component)
+			{
+				Handle.Component->Deactivate();
+				return;
+			}
+		}
+	}
+}
+
+int32 UCombatVFXSubsystem::GetActiveCount(ECombatVFXType Type) const
+{
+	return Active[(int32)Type].Num();
+}
+
+const FCombatVFXBudget& UCombatVFXSubsystem::GetBudget(ECombatVFXType Type) const
+{
+	for (const FCombatVFXBudget& Budget : Budgets)
+	{
+		if (Budget.Type == Type)
+		{
+			return Budget;
+		}
+	}
+
+	return DefaultBudget;
+}
+
+bool UCombatVFXSubsystem::GetViewLocation(FVector& OutLocation) const
+{
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+
+	if (!PlayerController || !PlayerController->PlayerCameraManager)
+	{
+		return false;
+	}
+
+	OutLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	return true;
+}
+
+bool UCombatVFXSubsystem::MakeRoom(ECombatVFXType Type, const FVector& Location)
+{
+	const FCombatVFXBudget& Budget = GetBudget(Type);
+
+	FVector ViewLocation;
+	const bool HasView = GetViewLocation(ViewLocation);
+	const float Significance = HasView ? FVector::DistSquared(ViewLocation, Location) : 0.0f;
+
+	if (HasView && Significance > FMath::Square(Budget.CullDistance))
+	{
+		return false;
+	}
+
+	TArray<FActiveEffect>& Effects = Active[(int32)Type];
+	Effects.RemoveAll([](const FActiveEffect& Effect) { return !Effect.Component.IsValid(); });
+
+	if (Effects.Num() < Budget.MaxActive)
+	{
+		return true;
+	}
+
+	if (Effects.IsEmpty())
+	{
+		return false;
+	}
+
+	// Without a viewer the oldest effect goes, otherwise the one furthest away if it is further than the new one
+	int32 Victim = HasView ? INDEX_NONE : 0;
+	float VictimDistance = Significance;
+
+	for (int32 i = 0; HasView && i < Effects.Num(); i++)
+	{
+		const float Distance = FVector::DistSquared(ViewLocation, Effects[i].Component->GetComponentLocation());
+
+		if (Distance > VictimDistance)
+		{
+			VictimDistance = Distance;
+			Victim = i;
+		}
+	}
+
+	if (Victim == INDEX_NONE)
+	{
+		return false;
+	}
+
+	UNiagaraComponent* Component = Effects[Victim].Component.Get();
+	Effects.RemoveAt(Victim);
+	Component->DeactivateImmediate();
+
+	return true;
+}
+
+FCombatVFXHandle UCombatVFXSubsystem::Track(UNiagaraComponent* Component, ECombatVFXType Type)
+{
+	FCombatVFXHandle Handle;
+
+	if (!Component)
+	{
+		return Handle;
+	}
+
+	Handle.Component = Component;
+	Handle.Serial = NextSerial++;
+
+	FActiveEffect& Effect = Active[(int32)Type].AddDefaulted_GetRef();
+	Effect.Component = Component;
+	Effect.Serial = Handle.Serial;
+	Effect.SpawnTime = GetWorld()->GetTimeSeconds();
+
+	Component->OnSystemFinished.AddUniqueDynamic(this, &UCombatVFXSubsystem::OnEffectFinished);
+
+	++SpawnCount;
+
+	return Handle;
+}
+
+void UCombatVFXSubsystem::OnEffectFinished(UNiagaraComponent* Component)
+{
+	for (TArray<FActiveEffect>& Effects : Active)
+	{
+		Effects.RemoveAll([Component](const FActiveEffect& Effect) { return Effect.Component == Component; });
+	}
+}
+
+void UCombatVFXSubsystem::ExpireEffects()
+{
+	const float Now = GetWorld()->GetTimeSeconds();
+
+	// Deactivating can finish the system synchronously and edit Active, so collect first
+	TArray<UNiagaraComponent*> Expired;
+
+	for (int32 Type = 0; Type < (int32)ECombatVFXType::Count; Type++)
+	{
+		const float MaxLifetime = GetBudget((ECombatVFXType)Type).MaxLifetime;
+
+		for (const FActiveEffect& Effect : Active[Type])
+		{
+			UNiagaraComponent* Component = Effect.Component.Get();
+
+			if (Component && Component->IsActive() && Now - Effect.SpawnTime > MaxLifetime)
+			{
+				Expired.Add(Component);
+			}
+		}
+	}
+
+	for (UNiagaraComponent* Component : Expired)
+	{
+		Component->Deactivate();
+	}
+}
@@ -3,64 +3,133 @@
 
 #include "XPController.h"
 
+#include "Algo/BinarySearch.h"
+#include "Curves/CurveFloat.h"
+#include "TimerManager.h"
+
 
 // Sets default values for this component's properties
 UXPController::UXPController()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	// XP only moves on grants, nothing here needs a tick
+	PrimaryComponentTick.bCanEverTick = false;
 
 	// ...
 }
 
 void UXPController::Init() const
 {
-	OnXPChanged.Broadcast(CurrentXP);
-	OnMaxXPChanged.Broadcast(MaxXP);
+	OnXPChanged.Broadcast(GetXP());
+	OnMaxXPChanged.Broadcast(GetMaxXP());
 	OnLevelChanged.Broadcast(CurrentLevel);
 }
 
 
 void UXPController::AddXP(float Value)
 {
-	CurrentXP += Value;
-	OnXPChanged.Broadcast(CurrentXP);
+	TotalXP += Value;
 	TryLevelUp();
+	OnXPChanged.Broadcast(GetXP());
 }
 
-// Called when the game starts
-void UXPController::BeginPlay()
+void UXPController::QueueXP(float Value)
 {
-	Super::BeginPlay();
+	if (QueuedXP == 0.0f)
+	{
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UXPController::FlushQueuedXP);
+	}
 
-	// ...
-	
+	QueuedXP += Value;
+}
+
+void UXPController::FlushQueuedXP()
+{
+	const float Value = QueuedXP;
+	QueuedXP = 0.0f;
+
+	if (Value != 0.0f)
+	{
+		AddXP(Value);
+	}
 }
 
+float UXPController::GetXP() const
+{
+	return TotalXP - Thresholds[CurrentLevel];
+}
 
-// Called every frame
-void UXPController::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+float UXPController::GetMaxXP() const
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	// past the last level the bar just keeps the last level's size
+	const int32 Level = FMath::Min(CurrentLevel, Thresholds.Num() - 2);
+	return Thresholds[Level + 1] - Thresholds[Level];
+}
 
-	// ...
+void UXPController::SerializeSaveState(FArchive& Ar)
+{
+	int32 Level = CurrentLevel;
+	float XP = GetXP();
+	float LevelXP = GetMaxXP();
+	Ar << Level;
+	Ar << XP;
+	// kept for the save format, the table is the authority now
+	Ar << LevelXP;
+
+	if (Ar.IsLoading())
+	{
+		const int PreviousLevel = CurrentLevel;
+
+		CurrentLevel = FMath::Clamp(Level, 0, Thresholds.Num() - 1);
+		TotalXP = Thresholds[CurrentLevel] + XP;
+
+		// BeginPlay already sent the starting values, only what the save changed goes out again
+		if (CurrentLevel != PreviousLevel)
+		{
+			OnMaxXPChanged.Broadcast(GetMaxXP());
+			OnLevelChanged.Broadcast(CurrentLevel);
+		}
+
+		OnXPChanged.Broadcast(GetXP());
+	}
+}
+
+void UXPController::OnRegister()
+{
+	Super::OnRegister();
+
+	BuildThresholds();
+}
+
+void UXPController::BuildThresholds()
+{
+	Thresholds.SetNumUninitialized(FMath::Max(MaxLevel, 1) + 1);
+	Thresholds[0] = 0.0f;
+
+	float LevelXP = FirstLevelXP;
+
+	for (int32 Level = 0; Level < Thresholds.Num() - 1; Level++)
+	{
+		if (LevelXPCurve)
+		{
+			LevelXP = LevelXPCurve->GetFloatValue((float)Level);
+		}
+
+		// a level always takes something, or the search can't tell two levels apart
+		Thresholds[Level + 1] = Thresholds[Level] + FMath::Max(LevelXP, KINDA_SMALL_NUMBER);
+
+		LevelXP *= LevelXPGrowth;
+	}
 }
 
 void UXPController::TryLevelUp()
 {
-	if (CurrentXP >= MaxXP)
+	// last threshold reached, that's the level
+	const int32 Level = FMath::Max(Algo::UpperBound(Thresholds, TotalXP) - 1, 0);
+
+	if (Level != CurrentLevel)
 	{
-		const float XPLeft = CurrentXP - MaxXP;
-		CurrentLevel++;
+		CurrentLevel = Level;
 		OnLevelChanged.Broadcast(CurrentLevel);
-		MaxXP *= 1.05;
-		OnMaxXPChanged.Broadcast(MaxXP);
-		CurrentXP = XPLeft;
-		
-		if (CurrentXP >= MaxXP)
-			TryLevelUp();
-		
-		OnXPChanged.Broadcast(CurrentXP);
+		OnMaxXPChanged.Broadcast(GetMaxXP());
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AttributeComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class ECombatAttribute : uint8
+{
+	MaxHealth,
+	Damage,
+	MaxStamina,
+	Count UMETA(Hidden)
+};
+
+UENUM(BlueprintType)
+enum class EAttributeModifierOp : uint8
+{
+	// Added to the base before any multiplier
+	Add,
+	// Multiplies base plus additions
+	Multiply
+};
+
+/**
+ * Base values plus modifier stacks for a combatant's stats. A final value is
+ * (base + additions) * multipliers, recomputed only when its base or one of
+ * its modifiers changes, so it is always exact and never drifts. Changes are
+ * pushed to the owner through OnAttributeChanged, only when the final value
+ * actually moved.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class FUCK_API UAttributeComponent : public UActorComponent
+{
+	GENERATED_BODY()
+	DECLARE_MULTICAST_DELEGATE_TwoParams(FAttributeChangedSignature, ECombatAttribute, float);
+
+public:
+	UAttributeComponent();
+
+	// Sets the base without notifying, for the owner's starting stats
+	void InitBase(ECombatAttribute Attribute, float Value);
+
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetValue(ECombatAttribute Attribute) const { return Final[(int32)Attribute]; }
+
+	UFUNCTION(BlueprintPure, Category = "Attributes")
+	float GetBase(ECombatAttribute Attribute) const { return Base[(int32)Attribute]; }
+
+	UFUNCTION(BlueprintCallable, Category = "Attributes")
+	void SetBase(ECombatAttribute Attribute, float Value);
+
+	// Adds Source's modifier to the attribute, or replaces the one it already has there
+	UFUNCTION(BlueprintCallable, Category = "Attributes")
+	void SetModifier(ECombatAttribute Attribute, FName Source, EAttributeModifierOp Op, float Value);
+
+	UFUNCTION(BlueprintCallable, Category = "Attributes")
+	void RemoveModifier(ECombatAttribute Attribute, FName Source);
+
+	// Drops every modifier Source put on any attribute
+	UFUNCTION(BlueprintCallable, Category = "Attributes")
+	void RemoveModifiersFrom(FName Source);
+
+	int32 GetModifierCount() const { return Sources.Num(); }
+
+	FAttributeChangedSignature OnAttributeChanged;
+
+private:
+	int32 FindModifier(ECombatAttribute Attribute, FName Source) const;
+
+	float Evaluate(ECombatAttribute Attribute) const;
+
+	// Stores the new final value and notifies if it moved
+	void Recompute(ECombatAttribute Attribute);
+
+	static constexpr int32 AttributeCount = (int32)ECombatAttribute::Count;
+
+	float Base[AttributeCount] = {};
+	float Final[AttributeCount] = {};
+
+	// Every modifier on every attribute, in parallel arrays
+	TArray<FName> Sources;
+	TArray<ECombatAttribute> Attributes;
+	TArray<EAttributeModifierOp> Ops;
+	TArray<float> Values;
+};
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CheckpointSubsystem.generated.h"
+
+class ACombatant;
+
+/**
+ * Snapshots every combatant in memory when an encounter starts, so a Game
+ * Over retry resets the fight in place within a frame instead of reloading
+ * the map. Combatants serialize themselves through SerializeSaveState, the
+ * same state the save file holds.
+ */
+UCLASS()
+class FUCK_API UCheckpointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintCallable, Category = "Checkpoint")
+	void Capture();
+
+	// Puts every combatant back where the last checkpoint had it. False without a checkpoint.
+	UFUNCTION(BlueprintCallable, Category = "Checkpoint")
+	bool Restore();
+
+	UFUNCTION(BlueprintPure, Category = "Checkpoint")
+	bool HasCheckpoint() const { return !Snapshots.IsEmpty(); }
+
+	double GetLastRestoreMilliseconds() const { return LastRestoreMilliseconds; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FSnapshot
+	{
+		TWeakObjectPtr<ACombatant> Combatant;
+		FTransform Transform;
+		int32 Offset = 0;
+		int32 Size = 0;
+		// Already dead enemies are left lying rather than replaying their death
+		bool bDead = false;
+	};
+
+	TArray<FSnapshot> Snapshots;
+
+	// Every combatant's state back to back, one allocation for the whole checkpoint
+	TArray<uint8> Bytes;
+
+	FDelegateHandle EncounterStartedHandle;
+
+	double LastRestoreMilliseconds = 0.0;
+};
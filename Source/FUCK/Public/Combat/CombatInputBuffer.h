@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+enum class ECombatInputAction : uint8
+{
+	Attack, Roll, Skill
+};
+
+// Input-to-action latency, in game time and in frames
+struct FCombatInputLatency
+{
+	// Executed on the frame the input arrived
+	int32 Immediate = 0;
+	// Executed later, when a window opened
+	int32 Buffered = 0;
+	// Never executed, fell out of the window or was superseded
+	int32 Expired = 0;
+
+	double TotalBufferedMs = 0.0;
+	double MaxBufferedMs = 0.0;
+	uint64 TotalBufferedFrames = 0;
+
+	FString ToString() const;
+};
+
+/**
+ * Holds inputs that arrived while the action couldn't start (mid attack,
+ * roll or stagger) so they fire the moment the owner opens a window,
+ * instead of being dropped. Only the newest input is executed, older ones
+ * are superseded. Times are the owner's world time, so a replay or a fixed
+ * step simulation sees the same windows as the recorded session.
+ */
+class FUCK_API FCombatInputBuffer
+{
+public:
+	struct FEntry
+	{
+		ECombatInputAction Action = ECombatInputAction::Attack;
+		int32 Slot = 0;
+		double Time = 0.0;
+		uint64 Frame = 0;
+	};
+
+	// Seconds an input stays valid
+	float Window = 0.25f;
+
+	void Push(double Now, ECombatInputAction Action, int32 Slot = 0);
+	void RecordImmediate() { Latency.Immediate++; }
+
+	// Offers the newest input still in the window to TryExecute, everything is cleared once it succeeds
+	bool Consume(double Now, TFunctionRef<bool(const FEntry&)> TryExecute);
+
+	void Clear() { Entries.Reset(); }
+	bool IsEmpty() const { return Entries.IsEmpty(); }
+
+	const FCombatInputLatency& GetLatency() const { return Latency; }
+	void ResetLatency() { Latency = FCombatInputLatency(); }
+
+private:
+	void DropExpired(double Now);
+
+	static constexpr int32 MaxEntries = 4;
+
+	TArray<FEntry, TInlineAllocator<MaxEntries>> Entries;
+	FCombatInputLatency Latency;
+};
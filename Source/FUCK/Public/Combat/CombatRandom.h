@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * The combat random seed behind gameplay choices such as attack, stumble and
+ * death animation picks. Unlike FMath::RandRange it can be set, so an input
+ * replay or a fixed step simulation makes the same choices every run. The
+ * numbers come from each entity's FCombatRandomStream.
+ */
+class FUCK_API FCombatRandom
+{
+public:
+	// Reseeds every FCombatRandomStream
+	static void Seed(int32 InSeed);
+	static int32 GetSeed() { return CurrentSeed; }
+
+	// Bumped by Seed, entity streams reseed themselves when it changes
+	static uint32 GetGeneration() { return Generation; }
+
+private:
+	static int32 CurrentSeed;
+	static uint32 Generation;
+};
+
+/**
+ * One entity's share of the combat random seed, keyed by its name. Its picks
+ * don't shift when another combatant draws more or fewer numbers, or when
+ * entities tick in a different order.
+ */
+struct FUCK_API FCombatRandomStream
+{
+	void Init(const UObject* Owner);
+
+	int32 RandRange(int32 Min, int32 Max);
+	float FRand();
+
+private:
+	FRandomStream& Get();
+
+	FRandomStream Stream;
+	uint32 Key = 0;
+	uint32 Generation = 0;
+};
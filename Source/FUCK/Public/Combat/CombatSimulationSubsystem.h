@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatSimulationSubsystem.generated.h"
+
+/**
+ * Optional fixed step mode for combat. Every frame then advances the game by
+ * exactly 1 / StepRate seconds whatever the renderer or the wall clock did, so
+ * a fight with the same seed and input plays out the same at any frame rate.
+ *
+ * Paced, frames wait for real time like a server at that tick rate. Unpaced,
+ * nothing waits: a headless process (-nullrhi) simulates as fast as the CPU
+ * allows, for balance runs over many fights.
+ *
+ * Turned on by bFixedStep, -CombatFixedStep[=<hz>] with -CombatUnpaced and
+ * -CombatSeed=<seed>, or com.Sim.FixedStep <hz> [unpaced]; 0 turns it off.
+ */
+UCLASS(config = Game)
+class FUCK_API UCombatSimulationSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	void EnableFixedStep(float InStepRate, bool bInUnpaced);
+	void DisableFixedStep();
+
+	bool IsFixedStep() const { return bActive; }
+	float GetStepSeconds() const { return 1.0f / StepRate; }
+
+	// Simulated seconds per real second since the fixed step was turned on
+	double GetSpeedup() const;
+
+	UPROPERTY(config)
+	bool bFixedStep = false;
+
+	// Steps per simulated second
+	UPROPERTY(config)
+	float StepRate = 30.0f;
+
+	UPROPERTY(config)
+	bool bUnpaced = false;
+
+	// Combat random seed for the session, 0 keeps a random one
+	UPROPERTY(config)
+	int32 Seed = 0;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	bool bActive = false;
+
+	bool bWasFixedTimeStep = false;
+	double SavedFixedDeltaTime = 0.0;
+	bool bWasFixedFrameRate = false;
+	float SavedFixedFrameRate = 0.0f;
+	bool bWasSmoothFrameRate = false;
+
+	double StartRealTime = 0.0;
+	double StartWorldTime = 0.0;
+};
@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatWarmupSubsystem.generated.h"
+
+class AEnemyBase;
+class UAnimInstance;
+class UAnimMontage;
+class UCameraShakeBase;
+class UCombatantArchetype;
+class UNiagaraSystem;
+class USkillBase;
+class APlayerController;
+
+struct FCombatWarmupReport
+{
+	int32 Montages = 0;
+	int32 NiagaraSystems = 0;
+	int32 CameraShakes = 0;
+	int32 Skills = 0;
+	double Milliseconds = 0.0;
+
+	FString ToString() const;
+};
+
+// One first use to time: a skill cast, a camera shake or an enemy montage
+struct FCombatFirstUseProbe
+{
+	FString Name;
+	TFunction<void()> Action;
+};
+
+/**
+ * Pays the first-use cost of everything an encounter can fire (montages,
+ * Niagara systems, camera shakes, skill FX) while the encounter is still
+ * being streamed in, instead of on the first attack or cast.
+ *
+ * Montages are started and stopped once on an idle enemy of each class (on
+ * the player for skills), which builds their montage instances before any
+ * frame evaluates them. Only what actually got instantiated is counted.
+ */
+UCLASS()
+class FUCK_API UCombatWarmupSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	void WarmupArchetype(const UCombatantArchetype* Archetype);
+
+	// Montages and own effects of the enemy's class, once per class; waits until the enemy is idle with its assets resident
+	void WarmupEnemy(AEnemyBase* Enemy);
+	void WarmupSkills(const TArray<USkillBase*>& Skills);
+	void WarmupCameraShake(APlayerController* PlayerController, TSubclassOf<UCameraShakeBase> ShakeClass);
+
+	const FCombatWarmupReport& GetReport() const { return Report; }
+
+	// Every skill of the player, its camera shake and the montages of one enemy per class, for
+	// the CityOfMyths.Performance.FirstCast test to fire once each and time the frames that follow
+	void GatherFirstUseProbes(TArray<FCombatFirstUseProbe>& OutProbes) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void WarmupMontage(UAnimMontage* Montage, UAnimInstance* AnimInstance);
+	void WarmupNiagara(UNiagaraSystem* System);
+
+	FCombatWarmupReport Report;
+
+	// Everything already warmed, so repeated encounters of the same archetype are free
+	TSet<FObjectKey> Warmed;
+
+	FDelegateHandle ArchetypeResidentHandle;
+	FDelegateHandle EnemyNearbyHandle;
+};
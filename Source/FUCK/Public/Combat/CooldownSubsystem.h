@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Combat/CooldownTimingWheel.h"
+#include "CooldownSubsystem.generated.h"
+
+// Identifies one cooldown slot; stale handles read as ready
+USTRUCT(BlueprintType)
+struct FCooldownHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Index = INDEX_NONE;
+
+	UPROPERTY()
+	int32 Generation = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+};
+
+/**
+ * Owns every cooldown in the world. Expiries live in one hierarchical timing
+ * wheel driven by a single timer armed for the next occupied tick, so running
+ * cooldowns cost nothing per frame and remaining time is a plain lookup.
+ */
+UCLASS(config = Game)
+class FUCK_API UCooldownSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// (Re)starts the cooldown behind Handle, allocating it on first use. OnReady fires once it runs out.
+	void Start(FCooldownHandle& Handle, float Duration, FSimpleDelegate OnReady);
+
+	// Moves the expiry earlier by Seconds, finishing the cooldown if that puts it in the past
+	void Reduce(const FCooldownHandle& Handle, float Seconds);
+
+	// Finishes the cooldown now and fires its ready callback
+	void Finish(const FCooldownHandle& Handle);
+
+	// Returns the slot for reuse, the ready callback is dropped
+	void Free(FCooldownHandle& Handle);
+
+	float GetRemaining(const FCooldownHandle& Handle) const;
+	bool IsReady(const FCooldownHandle& Handle) const { return GetRemaining(Handle) <= 0.0f; }
+
+	int32 GetRunningCount() const { return Wheel.Num(); }
+
+	// Wheel resolution, expiries are rounded up to the next tick
+	UPROPERTY(config)
+	float TicksPerSecond = 30.0f;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FCooldown
+	{
+		double ExpiryTime = 0.0;
+		int32 WheelEntry = INDEX_NONE;
+		int32 Generation = 0;
+		FSimpleDelegate OnReady;
+	};
+
+	FCooldown* Find(const FCooldownHandle& Handle);
+	const FCooldown* Find(const FCooldownHandle& Handle) const;
+
+	void Schedule(int32 Index);
+	void Expire(int32 Index);
+
+	void ArmTimer();
+	void OnWheelTimer();
+
+	double GetNow() const;
+	uint64 ToTick(double Time) const;
+
+	// Dense by handle index, so queries never touch the wheel
+	TArray<FCooldown> Cooldowns;
+	TArray<int32> FreeCooldowns;
+
+	FCooldownTimingWheel Wheel;
+	FTimerHandle WheelTimer;
+};
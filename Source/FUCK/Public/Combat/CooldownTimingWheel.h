@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Hierarchical timing wheel over integer ticks. Four levels of 64 slots, each
+ * slot an intrusive list, so scheduling and cancelling are O(1) and advancing
+ * only visits occupied slots and block boundaries.
+ */
+class FUCK_API FCooldownTimingWheel
+{
+public:
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 SlotCount = 1 << SlotBits;
+	static constexpr int32 LevelCount = 4;
+
+	// Furthest a schedule may reach ahead of the current tick, later expiries are clamped
+	static constexpr uint64 MaxRange = (uint64)1 << (SlotBits * LevelCount);
+
+	FCooldownTimingWheel();
+
+	// Returns an entry id for Cancel. Expiries at or before the current tick fire on the next Advance.
+	int32 Schedule(uint64 ExpiryTick, int32 Payload);
+	void Cancel(int32 EntryId);
+
+	// Moves time forward, calling OnExpired for every entry that expires up to and including ToTick
+	void Advance(uint64 ToTick, TFunctionRef<void(int32 Payload)> OnExpired);
+
+	// Earliest tick at which Advance has work to do, MAX_uint64 when empty
+	uint64 GetNextEventTick() const;
+
+	uint64 GetCurrentTick() const { return CurrentTick; }
+	int32 Num() const { return Count; }
+
+private:
+	struct FEntry
+	{
+		uint64 ExpiryTick = 0;
+		int32 Payload = INDEX_NONE;
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		int8 Level = INDEX_NONE;
+		uint8 Slot = 0;
+	};
+
+	void Link(int32 EntryId);
+	void Unlink(int32 EntryId);
+	void Cascade(int32 Level, int32 Slot);
+
+	static int32 GetSlot(uint64 Tick, int32 Level) { return (int32)((Tick >> (SlotBits * Level)) & (SlotCount - 1)); }
+
+	TArray<FEntry> Entries;
+	TArray<int32> FreeEntries;
+
+	int32 Heads[LevelCount][SlotCount];
+	uint64 Occupied[LevelCount];
+
+	uint64 CurrentTick = 0;
+	int32 Count = 0;
+};
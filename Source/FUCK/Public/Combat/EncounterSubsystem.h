@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EncounterSubsystem.generated.h"
+
+class AEnemyBase;
+class UCombatantArchetype;
+struct FStreamableHandle;
+
+/**
+ * Tracks which enemies are about to engage the player and streams their
+ * archetype bundles in before they activate, releasing them once the
+ * encounter is over.
+ */
+UCLASS(config = Game)
+class FUCK_API UEncounterSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+	DECLARE_MULTICAST_DELEGATE(FEncounterSignature);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FArchetypeSignature, const UCombatantArchetype*);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FEnemySignature, AEnemyBase*);
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	void RegisterEnemy(AEnemyBase* Enemy);
+	void UnregisterEnemy(AEnemyBase* Enemy);
+
+	bool IsEncounterActive() const { return bEncounterActive; }
+
+	const TArray<TWeakObjectPtr<AEnemyBase>>& GetEnemies() const { return Enemies; }
+
+	FEncounterSignature OnEncounterStarted;
+	FEncounterSignature OnEncounterEnded;
+
+	// Fired once an archetype's bundles are resident, before its enemies may engage
+	FArchetypeSignature OnArchetypeResident;
+
+	// Fired every update for each living enemy within PreloadDistance, with or without an archetype
+	FEnemySignature OnEnemyNearby;
+
+	// Enemies closer than this to the player get their archetype bundles requested
+	UPROPERTY(config)
+	float PreloadDistance = 2500.0f;
+
+	// Idle enemies further than this drop their archetype bundles again
+	UPROPERTY(config)
+	float ReleaseDistance = 3500.0f;
+
+	UPROPERTY(config)
+	float UpdateInterval = 0.5f;
+
+private:
+	struct FArchetypeLoad
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		TArray<TWeakObjectPtr<AEnemyBase>> Users;
+		bool bLoaded = false;
+	};
+
+	void UpdateEncounter();
+
+	void AcquireArchetype(AEnemyBase* Enemy);
+	void ReleaseArchetype(AEnemyBase* Enemy);
+	void OnArchetypeLoaded(FPrimaryAssetId ArchetypeId);
+
+	TArray<TWeakObjectPtr<AEnemyBase>> Enemies;
+	TSet<TWeakObjectPtr<AEnemyBase>> Preloaded;
+	TMap<FPrimaryAssetId, FArchetypeLoad> Loads;
+
+	FTimerHandle UpdateHandle;
+	bool bEncounterActive = false;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+};
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * A value that regenerates or drains at a constant rate (stamina, mana).
+ * Stored as value, rate, time and cap and evaluated on read, so nothing is
+ * integrated per frame: only spending, setting or a rate change writes.
+ * Times are world seconds passed in by the owner.
+ */
+struct FUCK_API FRegenResource
+{
+	void Init(float InMax, float InValue, double Now);
+
+	float Get(double Now) const;
+	float GetMax() const { return Max; }
+	float GetRate() const { return Rate; }
+
+	void Set(float NewValue, double Now);
+	void Add(float Delta, double Now) { Set(Get(Now) + Delta, Now); }
+
+	// Rebases the value at Now. False when the rate is unchanged and nothing was written.
+	bool SetRate(float NewRate, double Now);
+	void SetMax(float NewMax, double Now);
+
+	// Seconds until the value reaches Threshold at the current rate, negative if it never does
+	double TimeUntil(float Threshold, double Now) const;
+
+	// Seconds until the value is full or empty and stops changing, negative if it already has
+	double TimeUntilSettled(double Now) const;
+
+private:
+	float Value = 0.0f;
+	float Rate = 0.0f;
+	float Max = 0.0f;
+	double Time = 0.0;
+};
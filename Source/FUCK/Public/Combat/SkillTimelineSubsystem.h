@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Animation/AnimInstance.h"
+#include "SkillTimelineSubsystem.generated.h"
+
+class ACombatant;
+
+/**
+ * A skill written as a sequence of steps, e.g.
+ *
+ *	FSkillTimeline()
+ *		.Then([this]() { ... })
+ *		.WaitNotify("Release", 1.f)
+ *		.Every(0.5f, 4, [this](int32 Tick) { ... })
+ *		.Delay(2.f)
+ *		.Then([this]() { ... });
+ *
+ * Waits resume from USkillTimelineSubsystem, nothing per cast owns a timer.
+ */
+class FUCK_API FSkillTimeline
+{
+public:
+	FSkillTimeline& Then(TFunction<void()> Action);
+	FSkillTimeline& Delay(float Seconds);
+
+	// Runs Action Count times, Interval apart, the first one an Interval after the step starts
+	FSkillTimeline& Every(float Interval, int32 Count, TFunction<void(int32)> Action);
+
+	// Waits for a Montage Notify on the caster's mesh, moving on without it after Timeout.
+	// A Timeout of zero or less waits MaxEventWait seconds, no wait lasts forever.
+	FSkillTimeline& WaitNotify(FName NotifyName, float Timeout = 0.f);
+
+	// Waits until the caster's attack lands on something, with the same Timeout as WaitNotify
+	FSkillTimeline& WaitForHit(float Timeout = 0.f);
+
+	static constexpr float MaxEventWait = 5.f;
+
+private:
+	friend class USkillTimelineSubsystem;
+
+	enum class EStep : uint8
+	{
+		Call, Delay, Every, Notify, Hit
+	};
+
+	struct FStep
+	{
+		EStep Type = EStep::Call;
+		float Seconds = 0.f;
+		int32 Count = 0;
+		FName NotifyName;
+		TFunction<void(int32)> Action;
+	};
+
+	TArray<FStep> Steps;
+};
+
+struct FSkillTimelineHandle
+{
+	int32 Index = INDEX_NONE;
+	int32 Serial = 0;
+};
+
+/**
+ * Runs every skill timeline. Time waits sit in one heap behind a single
+ * timer, notify and hit waits resume from the events themselves, and all step
+ * work is timed here so casting cost can be read in one place.
+ */
+UCLASS()
+class FUCK_API USkillTimelineSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Starts right away, running every step up to the first wait. Stops on its own once Owner is gone.
+	FSkillTimelineHandle Run(UObject* Owner, ACombatant* Caster, FSkillTimeline&& Timeline);
+
+	void Cancel(const FSkillTimelineHandle& Handle);
+	// Returns how many timelines were dropped
+	int32 CancelAll(const UObject* Owner);
+
+	bool IsRunning(const FSkillTimelineHandle& Handle) const;
+	int32 GetRunningCount() const { return Timelines.Num(); }
+
+	// Time spent inside step actions since the world started
+	double GetStepMilliseconds() const { return StepMilliseconds; }
+	int32 GetStepCount() const { return StepCount; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	enum class EWait : uint8
+	{
+		None, Time, Notify, Hit
+	};
+
+	struct FRunningTimeline
+	{
+		// Shared so a step can keep running while its action starts other timelines
+		TSharedPtr<const TArray<FSkillTimeline::FStep>> Steps;
+		TWeakObjectPtr<UObject> Owner;
+		TWeakObjectPtr<ACombatant> Caster;
+		int32 Serial = 0;
+		int32 StepIndex = 0;
+		int32 Repeat = 0;
+		// Bumped on every wait so stale heap entries are skipped
+		int32 WaitId = 0;
+		EWait Wait = EWait::None;
+	};
+
+	struct FWake
+	{
+		double Time = 0.0;
+		int32 Index = INDEX_NONE;
+		int32 Serial = 0;
+		int32 WaitId = 0;
+
+		bool operator<(const FWake& Other) const { return Time < Other.Time; }
+	};
+
+	FRunningTimeline* Find(const FSkillTimelineHandle& Handle);
+
+	// Runs steps until one waits or the timeline ends
+	void Step(int32 Index);
+	// Ends the current wait, timing out event waits
+	void Resume(int32 Index);
+	void Finish(int32 Index);
+
+	void WaitFor(int32 Index, EWait Wait, float Seconds);
+	void RunAction(int32 Index, int32 StepIndex, int32 Argument);
+
+	void BindNotify(ACombatant* Caster);
+	void BindHit(ACombatant* Caster);
+	// Drops hit bindings of casters that are gone or no longer have a timeline running
+	void ReleaseHits();
+
+	UFUNCTION()
+	void OnMontageNotify(FName NotifyName, const FBranchingPointNotifyPayload& Payload);
+	void OnAttackHit(AActor* HitActor, ACombatant* Caster);
+
+	// Resumes every timeline of Caster waiting on this kind of event
+	void ResumeWaiting(const AActor* Caster, EWait Wait, FName NotifyName);
+
+	void ArmTimer();
+	void OnWakeTimer();
+
+	TSparseArray<FRunningTimeline> Timelines;
+	TArray<FWake> Wakes;
+
+	TMap<TObjectKey<ACombatant>, FDelegateHandle> HitBound;
+
+	FTimerHandle WakeTimer;
+	int32 NextSerial = 1;
+
+	double StepMilliseconds = 0.0;
+	int32 StepCount = 0;
+};
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StatusEffectSubsystem.generated.h"
+
+class ACombatant;
+
+UENUM(BlueprintType)
+enum class EStatusEffectStacking : uint8
+{
+	// Reapplying resets the duration
+	Refresh,
+	// Reapplying adds a stack up to MaxStacks and resets the duration
+	Stack,
+	// Every application runs on its own
+	Independent
+};
+
+USTRUCT(BlueprintType)
+struct FStatusEffectSpec
+{
+	GENERATED_BODY()
+
+	// Effects with the same id on the same target follow the stacking rule
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FName Id;
+
+	// Positive heals, negative burns/poisons. Scaled by stacks.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float HealthPerSecond = 0.0f;
+
+	// Free value for buffs, read back with GetMagnitude. Scaled by stacks.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Magnitude = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Duration = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EStatusEffectStacking Stacking = EStatusEffectStacking::Refresh;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (EditCondition = "Stacking == EStatusEffectStacking::Stack"))
+	int32 MaxStacks = 5;
+};
+
+/**
+ * Every heal, DoT and buff in the world. Effects live in parallel arrays and
+ * are integrated together at a fixed rate, each combatant getting at most one
+ * health change per update however many effects it carries.
+ */
+UCLASS(config = Game)
+class FUCK_API UStatusEffectSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Instigator gets the kill credit when a damaging effect finishes the target off
+	UFUNCTION(BlueprintCallable, Category = "Status Effects")
+	void ApplyEffect(ACombatant* Target, const FStatusEffectSpec& Spec, AActor* Instigator = nullptr);
+
+	UFUNCTION(BlueprintCallable, Category = "Status Effects")
+	void RemoveEffect(ACombatant* Target, FName Id);
+
+	UFUNCTION(BlueprintCallable, Category = "Status Effects")
+	void RemoveAllEffects(ACombatant* Target);
+
+	UFUNCTION(BlueprintPure, Category = "Status Effects")
+	int32 GetStackCount(const ACombatant* Target, FName Id) const;
+
+	// Sum of Magnitude * stacks over every effect with this id on the target
+	UFUNCTION(BlueprintPure, Category = "Status Effects")
+	float GetMagnitude(const ACombatant* Target, FName Id) const;
+
+	int32 GetEffectCount() const { return Ids.Num(); }
+
+	UPROPERTY(config)
+	float UpdateInterval = 0.1f;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	int32 FindTarget(const ACombatant* Target) const;
+	int32 AddTarget(ACombatant* Target);
+	int32 FindEffect(int32 TargetIndex, FName Id) const;
+
+	void RemoveEffectAt(int32 Index);
+
+	void UpdateEffects();
+
+	// Per effect, structure of arrays so the update walks contiguous memory
+	TArray<int32> TargetIndices;
+	TArray<FName> Ids;
+	TArray<float> HealthRates;
+	TArray<float> Magnitudes;
+	TArray<float> Remaining;
+	TArray<int32> Stacks;
+	TArray<TWeakObjectPtr<AActor>> Instigators;
+
+	// Per target, indexed by TargetIndices
+	TArray<TObjectKey<ACombatant>> Targets;
+	TArray<int32> TargetEffectCounts;
+	TArray<float> PendingHealth;
+	// Instigator of the last damaging effect summed into PendingHealth
+	TArray<TWeakObjectPtr<AActor>> PendingInstigators;
+	TMap<TObjectKey<ACombatant>, int32> TargetLookup;
+	TArray<int32> FreeTargets;
+
+	FTimerHandle UpdateHandle;
+	double LastUpdateTime = 0.0;
+};
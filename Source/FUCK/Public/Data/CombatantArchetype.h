@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Animation/AnimMontage.h"
+#include "CombatantArchetype.generated.h"
+
+class UNiagaraSystem;
+
+/**
+ * Per-archetype combat assets. Everything is soft referenced and grouped into
+ * Asset Manager bundles so an enemy type only becomes resident while an
+ * encounter using it is about to start or running.
+ */
+UCLASS(BlueprintType)
+class FUCK_API UCombatantArchetype : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	static const FName CombatBundle;
+	static const FName DeathBundle;
+	static const FName FXBundle;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Animations", meta = (AssetBundles = "Combat"))
+	TArray<TSoftObjectPtr<UAnimMontage>> AttackAnimations;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Animations", meta = (AssetBundles = "Combat"))
+	TArray<TSoftObjectPtr<UAnimMontage>> TakeHitAnimations;
+
+	// Android / Mech charge attacks
+	UPROPERTY(EditDefaultsOnly, Category = "Animations", meta = (AssetBundles = "Combat"))
+	TArray<TSoftObjectPtr<UAnimMontage>> LongAttackAnimations;
+
+	// Boss / Mech spell casts
+	UPROPERTY(EditDefaultsOnly, Category = "Animations", meta = (AssetBundles = "Combat"))
+	TArray<TSoftObjectPtr<UAnimMontage>> MagicSpellAnimations;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Animations", meta = (AssetBundles = "Death"))
+	TArray<TSoftObjectPtr<UAnimMontage>> DeathAnimations;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Effects", meta = (AssetBundles = "FX"))
+	TArray<TSoftObjectPtr<UNiagaraSystem>> Effects;
+
+	// Bundles requested when an encounter with this archetype is about to activate
+	static TArray<FName> GetEncounterBundles();
+
+	// Resolves a loaded soft list into hard pointers. Out is left untouched when nothing is resident.
+	template <typename T>
+	static bool Resolve(const TArray<TSoftObjectPtr<T>>& Source, TArray<T*>& Out)
+	{
+		TArray<T*> Resolved;
+		Resolved.Reserve(Source.Num());
+
+		for (const TSoftObjectPtr<T>& Entry : Source)
+		{
+			if (T* Asset = Entry.Get())
+			{
+				Resolved.Add(Asset);
+			}
+		}
+
+		if (Resolved.IsEmpty())
+		{
+			return false;
+		}
+
+		Out = MoveTemp(Resolved);
+		return true;
+	}
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SkillDefinition.generated.h"
+
+class USkillBase;
+class UTexture2D;
+
+/**
+ * One skill as a designer sees it. A USkillsComponent turns each entry of its
+ * definition list into a slot, so players and enemies share the same assets.
+ */
+UCLASS(BlueprintType)
+class FUCK_API USkillDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Skill")
+	TSubclassOf<USkillBase> skillClass;
+
+	// Overrides the class cooldown when not negative
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Skill")
+	float cooldown = -1.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "UI")
+	FText displayName;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "UI")
+	TSoftObjectPtr<UTexture2D> icon;
+};
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+#include "CombatBalanceGameMode.generated.h"
+
+class AEnemyBase;
+class APlayerCharacter;
+
+/**
+ * One simulated encounter for balance sweeps. Spawns the enemies around the
+ * player, lets UCombatBotComponent fight them at an unpaced fixed step until
+ * one side is dead or TimeLimit simulated seconds pass, writes the outcome as
+ * a one row CSV and quits:
+ *
+ *   UnrealEditor FUCK.uproject <ArenaMap>?game=/Script/FUCK.CombatBalanceGameMode?Mechs=2?Mech.MaxHealth=3000
+ *       -game -nullrhi -nosound -unattended
+ *
+ * URL options: Androids, Mechs, Bosses, Seed, TimeLimit, StepRate, Output, and
+ * <Target>.<Property>=<Value> to override a float property before the fight,
+ * Target being Player, CombatManager, Android, Mech or Boss, e.g.
+ * Boss.MagicSpell_Cooldown=10 or CombatManager.attackCooldown=0.5.
+ *
+ * The player's save is never loaded or written. The same seed and options
+ * fight the same way, which the CombatBalanceSweep commandlet checks with
+ * -CheckDeterminism while running many of these side by side.
+ */
+UCLASS(config = Game)
+class FUCK_API ACombatBalanceGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	ACombatBalanceGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+
+	// Columns of the row a run writes
+	static const TCHAR* CsvHeader;
+
+	UPROPERTY(config)
+	TSoftClassPtr<APlayerCharacter> PlayerClass;
+
+	UPROPERTY(config)
+	TSoftClassPtr<AEnemyBase> AndroidClass;
+
+	UPROPERTY(config)
+	TSoftClassPtr<AEnemyBase> MechClass;
+
+	UPROPERTY(config)
+	TSoftClassPtr<AEnemyBase> BossClass;
+
+	UPROPERTY(config)
+	int32 Androids = 0;
+
+	UPROPERTY(config)
+	int32 Mechs = 1;
+
+	UPROPERTY(config)
+	int32 Bosses = 0;
+
+	// Simulated seconds before the fight counts as lost
+	UPROPERTY(config)
+	float TimeLimit = 300.0f;
+
+	// Fixed steps per simulated second
+	UPROPERTY(config)
+	float StepRate = 30.0f;
+
+	UPROPERTY(config)
+	float SpawnSpacing = 200.0f;
+
+	UPROPERTY(config)
+	float MinSpawnRadius = 800.0f;
+
+	// Seeds the bot and the combat random streams, also ?Seed=
+	UPROPERTY(config)
+	int32 Seed = 1;
+
+private:
+	void ApplyOverrides(UObject* Object, const FString& Target) const;
+	void OnPlayerHealthChanged(float Health);
+	void Finish(bool bWin);
+
+	TWeakObjectPtr<APlayerCharacter> Player;
+	TArray<TWeakObjectPtr<AEnemyBase>> Enemies;
+
+	// Property overrides from the URL, by target
+	TMap<FString, TMap<FName, float>> Overrides;
+
+	float Elapsed = 0.0f;
+	float DamageTaken = 0.0f;
+	float LastHealth = 0.0f;
+	bool bFinished = false;
+
+	FString OutputPath;
+};
@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/GameModeBase.h"
+#include "CombatBenchmarkGameMode.generated.h"
+
+class AEnemyBase;
+class APlayerCharacter;
+
+namespace CombatBenchmark
+{
+	// A URL option as a float, GetIntOption would cut ?Duration=2.5 down to 2
+	FUCK_API float GetFloatOption(const FString& Options, const TCHAR* Key, float Default);
+}
+
+USTRUCT()
+struct FCombatBenchScenario
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config)
+	FString Name;
+
+	UPROPERTY(config)
+	int32 Androids = 0;
+
+	UPROPERTY(config)
+	int32 Mechs = 0;
+
+	UPROPERTY(config)
+	int32 Bosses = 0;
+};
+
+/**
+ * Headless combat stress benchmark. Spawns a configurable number of each
+ * enemy type in a ring around the player, lets UCombatBotComponent fight
+ * them for a fixed time, then writes frame time percentiles, a game thread breakdown and memory
+ * to Saved/Profiling as JSON and quits. Needs no GPU:
+ *
+ *   UnrealEditor FUCK.uproject <ArenaMap>?game=/Script/FUCK.CombatBenchmarkGameMode?Androids=50?Mechs=10?Bosses=1
+ *       -game -nullrhi -nosound -unattended -stdout
+ *
+ * URL options: Androids, Mechs, Bosses, Duration, Warmup, Seed, Output. The arena
+ * needs a nav mesh around the player start wide enough for the ring.
+ *
+ * ?Scenario=<Name> takes the counts from one of the configured Scenarios.
+ * ?Gate runs every scenario in turn, reloading the map between them, and
+ * compares each report with <BaselineDir>/<Name>.json; the process exits with
+ * status 1 if any of them regressed past the thresholds or has no baseline.
+ * ?UpdateBaselines writes the reports of the run as the new baselines instead;
+ * baselines are only checked in from such a run on the reference machine.
+ */
+UCLASS(config = Game)
+class FUCK_API ACombatBenchmarkGameMode : public AGameModeBase
+{
+	GENERATED_BODY()
+
+public:
+	ACombatBenchmarkGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+
+	// Spawns one enemy per class in rings around Center, earlier classes take the inner rings.
+	// Configure sees each enemy before its BeginPlay.
+	static void SpawnEnemyRings(UWorld* World, const FVector& Center, const TArray<UClass*>& Classes, float MinRadius, float Spacing,
+		TFunctionRef<void(AEnemyBase*)> Configure, TArray<TWeakObjectPtr<AEnemyBase>>& OutEnemies);
+
+	UPROPERTY(config)
+	TSoftClassPtr<APlayerCharacter> PlayerClass;
+
+	UPROPERTY(config)
+	TSoftClassPtr<AEnemyBase> AndroidClass;
+
+	UPROPERTY(config)
+	TSoftClassPtr<AEnemyBase> MechClass;
+
+	UPROPERTY(config)
+	TSoftClassPtr<AEnemyBase> BossClass;
+
+	UPROPERTY(config)
+	int32 Androids = 10;
+
+	UPROPERTY(config)
+	int32 Mechs = 0;
+
+	UPROPERTY(config)
+	int32 Bosses = 0;
+
+	// Seconds of fight that are measured
+	UPROPERTY(config)
+	float Duration = 60.0f;
+
+	// Seconds after spawning that are left out, while enemies close in and assets stream
+	UPROPERTY(config)
+	float Warmup = 5.0f;
+
+	// Distance between neighbouring enemies in the ring
+	UPROPERTY(config)
+	float SpawnSpacing = 200.0f;
+
+	UPROPERTY(config)
+	float MinSpawnRadius = 800.0f;
+
+	// Keeps the player alive so every run lasts the full duration
+	UPROPERTY(config)
+	bool bImmortalPlayer = true;
+
+	// Seed of the bot playing the fight, also ?Seed=
+	UPROPERTY(config)
+	int32 Seed = 1;
+
+	UPROPERTY(config)
+	TArray<FCombatBenchScenario> Scenarios;
+
+	// Relative to the project directory
+	UPROPERTY(config)
+	FString BaselineDir = TEXT("Perf/Baselines");
+
+	// Allowed regressions before the gate fails: fractions of the baseline, memory in MB
+	UPROPERTY(config)
+	float GateGameThreadP95Tolerance = 0.1f;
+
+	UPROPERTY(config)
+	float GateAllocationsTolerance = 0.15f;
+
+	UPROPERTY(config)
+	float GateMemoryToleranceMB = 64.0f;
+
+private:
+	struct FFrameSample
+	{
+		float FrameMs = 0.0f;
+		float GameThreadMs = 0.0f;
+		float PreActorTickMs = 0.0f;
+		float ActorTickMs = 0.0f;
+		// Game thread time outside the world's actor tick: timers, slate, streaming, frame sync
+		float OtherMs = 0.0f;
+		uint32 Allocations = 0;
+	};
+
+	void SpawnEnemies();
+
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldPreActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	// The previous frame is complete once the next world tick starts
+	void Sample();
+	void SampleCombatStats();
+	void Finish();
+	FString BuildReport() const;
+
+	// Compares the report with the scenario's baseline, or replaces the baseline. False on a regression.
+	bool RunGate(const FString& Report);
+	FString GetBaselinePath() const;
+
+	// Loads the map again with the next scenario, false after the last one
+	bool TravelToNextScenario();
+
+	TWeakObjectPtr<APlayerCharacter> Player;
+	TArray<TWeakObjectPtr<AEnemyBase>> Enemies;
+
+	float Elapsed = 0.0f;
+	bool bMeasuring = false;
+	bool bFinished = false;
+
+	TArray<FFrameSample> Samples;
+
+	// Average cost per frame of every stat CityOfMyths scope, summed over the samples
+	TMap<FString, double> CombatStatMs;
+	int32 CombatStatSamples = 0;
+
+	uint64 TickStartCycles = 0;
+	uint64 PreActorTickCycles = 0;
+	uint64 PostActorTickCycles = 0;
+	uint64 LastAllocations = 0;
+
+	uint64 StartUsedPhysical = 0;
+	uint64 PeakUsedPhysical = 0;
+
+	FDelegateHandle TickStartHandle;
+	FDelegateHandle PreActorTickHandle;
+	FDelegateHandle PostActorTickHandle;
+
+	FString OutputPath;
+	FString ScenarioName;
+	bool bGate = false;
+	bool bUpdateBaselines = false;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "CombatBotComponent.generated.h"
+
+class AEnemyBase;
+class APlayerCharacter;
+
+/**
+ * Plays the player character for soak tests and profiling captures. Sits on
+ * the local player controller and presses the same action and axis mappings
+ * a player would, so every input binding, buffer and combat rule runs as in a
+ * real session. Decisions come from a seeded random stream: the same seed and
+ * map give the same session, give or take frame timing.
+ *
+ * Out of combat it walks to the nearest living enemy; in combat it locks on
+ * with CombatModeToggle, attacks, rolls, strafes, sprints to close distance,
+ * cycles targets and casts whichever skill is ready.
+ *
+ * Start it with com.Bot [seed], e.g. -ExecCmds="com.Bot 42" for unattended runs.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class FUCK_API UCombatBotComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCombatBotComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	void SetSeed(int32 Seed);
+
+	// Adds the bot to the first local player controller, or removes it if one is already playing
+	static UCombatBotComponent* Toggle(UWorld* World, int32 Seed);
+
+	// Seconds between decisions, plus up to DecisionJitter
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float DecisionInterval = 0.15f;
+
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float DecisionJitter = 0.1f;
+
+	// Closer than this to its target it fights instead of walking up
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float MeleeRange = 300.0f;
+
+	// Sprints towards anything further than this while stamina lasts
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float SprintDistance = 900.0f;
+
+	// Relative weights of the in range choices
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float AttackWeight = 6.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float RollWeight = 1.0f;
+
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float SkillWeight = 1.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float StrafeWeight = 1.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float CycleTargetWeight = 0.5f;
+
+	// Degrees per second the camera turns towards where the bot is heading
+	UPROPERTY(EditAnywhere, Category = "Bot")
+	float TurnRate = 360.0f;
+
+	int32 GetActionCount() const { return ActionCount; }
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	void Decide(APlayerCharacter* Player);
+	void DecideInRange(APlayerCharacter* Player);
+	AEnemyBase* FindNearestEnemy(const APlayerCharacter* Player) const;
+	void FaceTowards(APlayerCharacter* Player, const FVector& Location, float DeltaTime);
+
+	void PressAction(FName Action);
+	void SetAction(FName Action, bool bHeld);
+	void SetAxis(FName Axis, float Value);
+	void ReleaseAll();
+
+	FRandomStream Random;
+
+	float NextDecisionTime = 0.0f;
+
+	// Where it walks while out of combat
+	TWeakObjectPtr<AEnemyBase> ExploreTarget;
+	float NextExploreSearchTime = 0.0f;
+
+	// Keys held down right now, by action or axis name
+	TMap<FName, FKey> HeldKeys;
+
+	int32 ActionCount = 0;
+};
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "CombatHitchSubsystem.generated.h"
+
+/**
+ * Watches game thread time during encounters and keeps a context record of
+ * every frame over HitchThresholdMs: enemy state changes, damage events,
+ * widgets created, VFX spawns, GC runs and the costliest combat scopes of
+ * that frame. Records go to a ring buffer that is written out on a
+ * background task every FlushInterval seconds, one JSON object per line, to
+ * Saved/Profiling/Hitches/Hitches-<date>.jsonl.
+ *
+ * Game code reports what happened through the Note functions, which cost a
+ * flag test while no detector runs. com.Hitch.Threshold <ms> changes the
+ * threshold, 0 turns the detector off.
+ */
+UCLASS(config = Game)
+class FUCK_API UCombatHitchSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	static void NoteStateChange(const AActor* Actor, uint8 OldState, uint8 NewState);
+	static void NoteDamage();
+	static void NoteWidgetCreated(const UObject* Widget);
+
+	void SetThreshold(float InThresholdMs);
+
+	// Writes the records not yet on disk
+	void Flush();
+
+	UPROPERTY(config)
+	bool bEnabled = true;
+
+	// Game thread milliseconds above which a combat frame is a hitch
+	UPROPERTY(config)
+	float HitchThresholdMs = 50.0f;
+
+	// Records kept until the next flush, older ones are dropped first
+	UPROPERTY(config)
+	int32 MaxRecords = 64;
+
+	// Seconds between writes to disk
+	UPROPERTY(config)
+	float FlushInterval = 10.0f;
+
+	// Costliest scopes kept per record
+	UPROPERTY(config)
+	int32 TopScopes = 5;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FStateChange
+	{
+		FName Actor;
+		uint8 OldState = 0;
+		uint8 NewState = 0;
+	};
+
+	struct FHitchRecord
+	{
+		FDateTime Time;
+		uint64 Frame = 0;
+		float FrameMs = 0.0f;
+		float GameThreadMs = 0.0f;
+		int32 Enemies = 0;
+
+		TArray<FStateChange> StateChanges;
+		int32 DroppedStateChanges = 0;
+		int32 DamageEvents = 0;
+		TArray<FName> Widgets;
+		int32 VFXSpawns = 0;
+		int32 GCRuns = 0;
+		float GCMs = 0.0f;
+		TArray<TPair<FString, float>> Scopes;
+	};
+
+	// What happened during the frame being measured, filled by the Note functions
+	struct FFrameContext
+	{
+		TArray<FStateChange> StateChanges;
+		int32 DroppedStateChanges = 0;
+		int32 DamageEvents = 0;
+		TArray<FName> Widgets;
+		int32 GCRuns = 0;
+		double GCSeconds = 0.0;
+
+		void Reset();
+	};
+
+	void Start();
+	void Stop();
+
+	void OnWorldTickStart(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	void AddRecord(float FrameMs, float GameThreadMs);
+	static FString FormatRecord(const FHitchRecord& Record);
+
+	static FFrameContext Context;
+	static int32 Detectors;
+
+	bool bRunning = false;
+
+	// Ring buffer of the records since the last flush
+	TArray<FHitchRecord> Records;
+	int32 NextRecord = 0;
+	int32 DroppedRecords = 0;
+
+	TArray<TPair<const TCHAR*, uint64>> LastScopeCycles;
+	TArray<TPair<const TCHAR*, uint64>> ScopeCycles;
+	int32 LastVFXSpawns = 0;
+	double GCStartTime = 0.0;
+	double NextFlushTime = 0.0;
+
+	FString OutputPath;
+	TSharedPtr<FArchive> Writer;
+	UE::Tasks::TTask<void> WriteTask;
+
+	FDelegateHandle TickStartHandle;
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Tasks/Task.h"
+#include "CombatInputReplayComponent.generated.h"
+
+class APlayerCharacter;
+class APlayerController;
+class FArchive;
+class UInputComponent;
+
+UENUM()
+enum class ECombatInputReplayMode : uint8
+{
+	None, Record, Replay
+};
+
+/**
+ * Records the player's bound input stream (the axes and actions set up in
+ * APlayerCharacter::SetupPlayerInputComponent and the skill slots) to a
+ * compact binary log, and plays such a log back frame by frame, so a session
+ * that ran badly can be run again under the profiler.
+ *
+ * Layout: magic, version, map name, combat random seed, the player's start
+ * transform and control rotation, the axis and action names, then one record
+ * per frame - delta time, the axes whose value changed, the action presses
+ * and releases. Recording streams the log to disk in chunks on a background
+ * task. Replay runs every frame at its recorded delta time, calling the same
+ * bindings a key press would, ahead of the player's tick.
+ *
+ * Recordings are best started with the map, -CombatInputRecord=<file> and
+ * -CombatInputReplay=<file> do that; com.Input.Record / Replay / Stop work
+ * mid session. Enemy state is not part of the log, so neither a recording nor
+ * a replay starts while an encounter is active.
+ */
+UCLASS()
+class FUCK_API UCombatInputReplayComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCombatInputReplayComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	bool StartRecording(const FString& Path);
+	bool StartReplay(const FString& Path);
+	void Stop();
+
+	ECombatInputReplayMode GetMode() const { return Mode; }
+	int32 GetFrame() const { return Frame; }
+
+	// Recording or replay on the controller of Player, started by the command line
+	static void StartFromCommandLine(APlayerCharacter* Player);
+	static bool IsRequestedOnCommandLine();
+
+	// The component on the first local player controller, created if bCreate
+	static UCombatInputReplayComponent* Find(UWorld* World, bool bCreate);
+
+	static FString GetDefaultPath();
+
+	static constexpr uint32 LogMagic = 0x504E4943;
+	static constexpr int32 LogVersion = 1;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	APlayerController* GetPlayerController() const;
+	APlayerCharacter* GetPlayer() const;
+
+	// False, with a warning, while enemies are engaged and their state would differ between the runs
+	bool CanStartOutsideEncounter(const TCHAR* What) const;
+
+	void RecordFrame(float DeltaTime);
+	void OnRecordedAction(int32 Index, bool bPressed);
+	void FlushRecording(bool bClose);
+
+	void ReplayFrame();
+	void ExecuteAction(APlayerCharacter* Player, FName Action, EInputEvent Event);
+
+	ECombatInputReplayMode Mode = ECombatInputReplayMode::None;
+	int32 Frame = 0;
+
+	TArray<FName> Axes;
+	TArray<FName> Actions;
+	TArray<float> AxisValues;
+
+	// Recording: presses and releases seen this frame, bit 7 set for a release
+	TArray<uint8> FrameActions;
+
+	UPROPERTY()
+	UInputComponent* RecordInput;
+
+	// Recording: frames not yet handed to the writer task
+	TArray<uint8> Pending;
+	TSharedPtr<FArchive> Writer;
+	UE::Tasks::TTask<void> WriteTask;
+
+	// Replay: the whole log, read as it plays
+	TArray<uint8> ReplayBytes;
+	TUniquePtr<FArchive> Reader;
+	bool bWasFixedTimeStep = false;
+	double SavedFixedDeltaTime = 0.0;
+};
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class AActor;
+class UWorld;
+
+struct FCombatMemoryArchetype
+{
+	// Actor class, e.g. BP_Android_C
+	FString Name;
+	// UCombatantArchetype asset of the enemies, if they use one
+	FString Archetype;
+
+	int32 Instances = 0;
+	// Objects owned by one instance: the actor, its components, skills, anim instance, AI controller, widgets
+	int32 ObjectsPerInstance = 0;
+	uint64 InstanceBytes = 0;
+	uint64 LargestInstanceBytes = 0;
+
+	// Meshes and montages the instances reference, counted once per archetype
+	int32 SharedAssets = 0;
+	uint64 SharedBytes = 0;
+};
+
+/**
+ * Estimates what every combatant type in the world costs in memory. Per
+ * instance it adds up the objects one combatant owns, so an AAndroid counts
+ * its components, UWidgetComponent's UCombatantWidget with its widget tree,
+ * its AI controller and its anim instance. Referenced skeletal meshes and
+ * montages are counted separately, once per archetype and once in the total.
+ *
+ * Object sizes are the same estimate obj list makes (serialized size plus
+ * exclusive resource size), good for budgets and comparing types rather than
+ * exact bytes. For the heap split by system run with -llm and use
+ * stat LLMFULL, the module's allocations are tagged CityOfMyths/Combat, AI, UI
+ * and Skills.
+ *
+ * com.Memory.Report [file.csv] logs the table and writes
+ * Saved/Profiling/MemoryReport.csv.
+ */
+class FUCK_API FCombatMemoryReport
+{
+public:
+	static TArray<FCombatMemoryArchetype> Run(UWorld* World, uint64& OutSharedTotalBytes);
+
+	static bool WriteReport(const TArray<FCombatMemoryArchetype>& Archetypes, uint64 SharedTotalBytes, const FString& Path);
+
+private:
+	// The actor and the objects only it uses
+	static void GatherInstanceObjects(AActor* Actor, TSet<UObject*>& OutObjects);
+	static void GatherSharedAssets(AActor* Actor, TSet<UObject*>& OutAssets);
+
+	static uint64 GetObjectBytes(UObject* Object);
+};
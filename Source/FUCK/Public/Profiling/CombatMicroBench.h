@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class APlayerCharacter;
+
+struct FCombatMicroBenchResult
+{
+	FString Name;
+	int32 Iterations = 0;
+	double NsPerOp = 0.0;
+	// Malloc calls per op, 0 in shipping builds
+	double AllocsPerOp = 0.0;
+};
+
+/**
+ * Times the combat hot routines in isolation against synthetic enemies,
+ * reporting ns/op and allocations per op. Run by the automation test
+ * CityOfMyths.Performance.MicroBench; the results are logged and written to
+ * Saved/Profiling/MicroBench.json as the baseline an optimization has to beat.
+ *
+ * Everything runs inside one frame on a player the caller owns: enemies are
+ * spawned around it and destroyed afterwards, its target and nearby list are
+ * left pointing at them.
+ */
+class FUCK_API FCombatMicroBench
+{
+public:
+	static TArray<FCombatMicroBenchResult> Run(APlayerCharacter* Player, int32 EnemyCount, int32 Iterations);
+
+	static bool WriteReport(const TArray<FCombatMicroBenchResult>& Results, int32 EnemyCount, const FString& Path);
+
+private:
+	static FCombatMicroBenchResult Measure(const FString& Name, int32 Iterations, TFunctionRef<void()> Op);
+};
@@ -0,0 +1,27 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FCombatPerfGateThresholds
+{
+	// Allowed growth over the baseline, as a fraction
+	float GameThreadP95 = 0.1f;
+	float AllocationsPerFrame = 0.15f;
+
+	// Allowed growth of peak resident memory, in MB
+	float MemoryMB = 64.0f;
+};
+
+/**
+ * Compares a combat benchmark report against a checked in baseline report of
+ * the same scenario: p95 game thread time, average allocations per frame and
+ * peak resident memory. A regression past the thresholds fails the gate.
+ */
+class FUCK_API FCombatPerfGate
+{
+public:
+	// False with the reasons in OutFailures when a metric regressed, or either report can't be read
+	static bool Compare(const FString& ReportJson, const FString& BaselineJson, const FCombatPerfGateThresholds& Thresholds, TArray<FString>& OutFailures);
+};
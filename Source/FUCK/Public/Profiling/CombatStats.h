@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include <atomic>
+
+// stat CityOfMyths
+DECLARE_STATS_GROUP(TEXT("CityOfMyths"), STATGROUP_CityOfMyths, STATCAT_Advanced);
+
+// Scoped timers
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player Tick"), STAT_COM_PlayerTick, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy Tick"), STAT_COM_EnemyTick, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy State Machine"), STAT_COM_StateMachine, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Attack Overlaps"), STAT_COM_AttackOverlaps, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Look At Smooth"), STAT_COM_LookAtSmooth, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cycle Target"), STAT_COM_CycleTarget, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Take Damage"), STAT_COM_TakeDamage, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HP Bar Visibility"), STAT_COM_HPBarVisibility, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Widget Updates"), STAT_COM_WidgetUpdate, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Encounter Update"), STAT_COM_Encounter, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Status Effects"), STAT_COM_StatusEffects, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cooldown Wheel"), STAT_COM_Cooldowns, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Skill Timelines"), STAT_COM_SkillTimelines, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("VFX Spawn"), STAT_COM_VFXSpawn, STATGROUP_CityOfMyths, FUCK_API);
+
+// Per frame counts, cleared every frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Overlap Queries"), STAT_COM_OverlapQueries, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Events"), STAT_COM_DamageEvents, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Line Of Sight Checks"), STAT_COM_LineOfSightChecks, STATGROUP_CityOfMyths, FUCK_API);
+
+// Current counts, kept until set again
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Registered Enemies"), STAT_COM_RegisteredEnemies, STATGROUP_CityOfMyths, FUCK_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Engaged Enemies"), STAT_COM_EngagedEnemies, STATGROUP_CityOfMyths, FUCK_API);
+
+// Low level memory tracker tags, listed under CityOfMyths when run with -llm
+LLM_DECLARE_TAG_API(CityOfMyths, FUCK_API);
+LLM_DECLARE_TAG_API(CityOfMyths_Combat, FUCK_API);
+LLM_DECLARE_TAG_API(CityOfMyths_AI, FUCK_API);
+LLM_DECLARE_TAG_API(CityOfMyths_UI, FUCK_API);
+LLM_DECLARE_TAG_API(CityOfMyths_Skills, FUCK_API);
+
+/**
+ * Time spent in each COM_SCOPE for the HUD perf overlay and the hitch detector.
+ * Also works in builds without stats; costs one flag test per scope while
+ * nobody reads it.
+ */
+class FUCK_API FCombatScopeTimes
+{
+public:
+	struct FSlot
+	{
+		const TCHAR* Name = nullptr;
+		std::atomic<uint64> Cycles { 0 };
+	};
+
+	static FSlot& Register(const TCHAR* Name);
+
+	// Running cycle totals of every scope. Scopes keep their index, readers diff against their last read.
+	static void Read(TArray<TPair<const TCHAR*, uint64>>& OutCycles);
+
+	// Scopes are timed while at least one reader is registered, game thread only
+	static void AddReader() { Readers++; }
+	static void RemoveReader() { Readers = FMath::Max(Readers - 1, 0); }
+	static bool IsEnabled() { return Readers > 0; }
+
+private:
+	static int32 Readers;
+};
+
+class FCombatScopeTimer
+{
+public:
+	explicit FCombatScopeTimer(FCombatScopeTimes::FSlot& InSlot)
+		: Slot(InSlot), StartCycles(FCombatScopeTimes::IsEnabled() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FCombatScopeTimer()
+	{
+		if (StartCycles != 0)
+		{
+			Slot.Cycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	FCombatScopeTimes::FSlot& Slot;
+	uint64 StartCycles;
+};
+
+// Times the scope for stat CityOfMyths and the perf overlay and marks it as a CPU event in Insights
+#define COM_SCOPE(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat); \
+	static FCombatScopeTimes::FSlot& ComScopeSlot_##Stat = FCombatScopeTimes::Register(TEXT(#Stat)); \
+	FCombatScopeTimer ComScopeTimer_##Stat(ComScopeSlot_##Stat)
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+
+// Record with -trace=default,Combat, export with com.Trace.ExportCombat in the editor
+UE_TRACE_CHANNEL_EXTERN(CombatChannel, FUCK_API);
+
+/**
+ * Gameplay events on the Combat trace channel, next to the CPU timing in
+ * the same .utrace: state changes, damage, deaths, attack turns and skill
+ * casts. Events are a few bytes each, actors are referred to by id and
+ * named once through NameActor. Every call is a no-op while the channel is
+ * off.
+ */
+struct FUCK_API FCombatTrace
+{
+	static void NameActor(const AActor* Actor);
+	static void LogStateChange(const AActor* Actor, uint8 OldState, uint8 NewState);
+	static void LogDamage(const AActor* Source, const AActor* Target, float Amount);
+	static void LogDeath(const AActor* Actor);
+	static void LogAttackTurn(const AActor* Actor);
+	static void LogSkillCast(const AActor* Caster, const UObject* Skill);
+};
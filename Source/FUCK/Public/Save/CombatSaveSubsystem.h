@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "CombatSaveSubsystem.generated.h"
+
+/**
+ * Saves player progression and enemy state to a small versioned binary file.
+ *
+ * Layout: magic, version, map name, then length-prefixed records - the
+ * player first, then only the enemies that changed since the level was
+ * loaded, keyed by actor name. Unknown or missing records are skipped by
+ * length, so an older save still loads after enemies are added or removed.
+ *
+ * The world is captured on the game thread, the file is written on a
+ * background task. The slot is loaded when a level opens with ?Continue
+ * (UMainMenu::ContinueGame). Benchmark, balance and replay worlds never load
+ * or write it.
+ */
+UCLASS(config = Game)
+class FUCK_API UCombatSaveSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	// Does nothing when the world is unchanged since the last save or is a simulated one
+	UFUNCTION(BlueprintCallable, Category = "Save")
+	void Save();
+
+	// Waits for a save still being written, then reads and applies the slot
+	UFUNCTION(BlueprintCallable, Category = "Save")
+	bool Load();
+
+	UFUNCTION(BlueprintPure, Category = "Save")
+	bool HasSave() const;
+
+	// bChangedOnly leaves out enemies still as placed
+	void Capture(TArray<uint8>& OutBytes, bool bChangedOnly = true) const;
+
+	void WaitForWrite();
+
+	FString GetSavePath() const;
+
+	// Capture, write, read and parse timings plus file size, logged. False if the file didn't read back.
+	// Run by the CityOfMyths.Performance.SaveBench automation test.
+	bool RunBenchmark(int32 Iterations);
+
+	UPROPERTY(config)
+	FString SlotName = TEXT("Slot0");
+
+	// Loads the slot into every game world, not only on ?Continue
+	UPROPERTY(config)
+	bool bLoadOnBeginPlay = false;
+
+	static constexpr const TCHAR* ContinueOption = TEXT("Continue");
+
+	static constexpr uint32 SaveMagic = 0x534D4F43;
+	// 2: combatants stopped saving the attribute driven values (max health, damage, max stamina)
+	static constexpr int32 SaveVersion = 2;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FRecord
+	{
+		uint32 Id = 0;
+		int32 Offset = 0;
+		int32 Size = 0;
+	};
+
+	struct FContents
+	{
+		int32 Version = 0;
+		FString MapName;
+		FRecord Player;
+		TArray<FRecord> Enemies;
+	};
+
+	bool ShouldLoadOnBeginPlay(const UWorld& World) const;
+	static bool IsSimulatedWorld(const UWorld& World);
+
+	static bool Parse(const TArray<uint8>& Bytes, FContents& OutContents);
+	void Apply(const TArray<uint8>& Bytes, const FContents& Contents);
+
+	static uint32 GetSaveId(const AActor* Actor);
+
+	UE::Tasks::TTask<bool> WriteTask;
+
+	// Skips the write when nothing changed since the last save. Cleared once that write turns out to have failed.
+	uint32 LastWrittenCrc = 0;
+};
@@ -6,9 +6,12 @@
 #include "UObject/NoExportTypes.h"
 #include "FUCK/PlayerCharacter.h"
 #include <Kismet/GameplayStatics.h>
+#include "Combat/CooldownSubsystem.h"
+#include "Combat/SkillTimelineSubsystem.h"
 #include "SkillBase.generated.h"
 
 class USkillsComponent;
+class USkillDefinition;
 
 
 UCLASS(Blueprintable)
@@ -20,7 +23,7 @@ public:
 	USkillBase();
 
 	//  
-	virtual void Initialize();
+	virtual bool Initialize();
 
 	UPROPERTY(EditAnywhere)
 	float cooldown;
@@ -29,7 +32,10 @@ public:
 	void Cast();
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	float GetCooldown();
+	float GetCooldown() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	bool IsReady() const;
 
 	//    C++ 
 	virtual void Cast_Implementation();
@@ -40,14 +46,37 @@ public:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly,meta = (EditConditionHides))
 	USkillsComponent* skillsComponent;
 
+	// Whoever owns the component, player or enemy
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, meta = (EditConditionHides))
+	ACombatant* caster;
+
+	// Set only when the caster is the player
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, meta = (EditConditionHides))
 	APlayerCharacter* player;
 
-	float cooldownTimestamp;
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, meta = (EditConditionHides))
+	USkillDefinition* definition;
+
+	// Expiry lives in UCooldownSubsystem
+	FCooldownHandle cooldownHandle;
+
+	void StartCooldown(float duration);
+	void ReleaseCooldown();
+
+	// Runs a step sequence for this skill, see FSkillTimeline
+	FSkillTimelineHandle RunTimeline(FSkillTimeline&& timeline);
+
+	// A timeline of this skill was dropped before its last step, once per timeline.
+	// Releases whatever the skipped steps would have.
+	virtual void OnTimelineCancelled();
+
+	// Soft assets (FX etc.) the skill needs resident before it is cast
+	virtual void GatherSoftAssets(TArray<FSoftObjectPath>& OutAssets) const;
 
 protected:
 
 private:
+	void OnCooldownReady();
 
 };
 
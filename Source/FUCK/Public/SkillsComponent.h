@@ -6,9 +6,14 @@
 #include "Components/ActorComponent.h"
 #include <FUCK/PlayerCharacter.h>
 #include "SkillBase.h"
+#include "Combat/CombatInputBuffer.h"
 #include <FUCK/Skills/TestSkill.h>
 #include "SkillsComponent.generated.h"
 
+class USkillDefinition;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSkillReadySignature, int32, slot);
+
 
 
 
@@ -22,26 +27,64 @@ public:
 	// Sets default values for this component's properties
 	USkillsComponent();
 
+	// One slot per entry, bound to the "Skill1".."SkillN" input actions in order
+	UPROPERTY(EditAnywhere)
+	TArray<USkillDefinition*> skillDefinitions;
+
+	// Legacy slots, appended after the definitions
 	UPROPERTY(EditAnywhere)
 	TArray<TSubclassOf<USkillBase>> skillsClass;
 
 	UPROPERTY()
 	TArray <USkillBase*> skillsObject;
 
+	// keeps the skills' soft FX resident while the component lives
+	TSharedPtr<struct FStreamableHandle> skillsAssetsHandle;
+
+	// Seconds after the start of play before any skill can be cast, as the old per-skill timestamps had it
+	UPROPERTY(EditAnywhere)
+	float initialCooldown = 1.f;
+
+	// A press that comes at most this long before the cooldown ends casts the moment it does
+	UPROPERTY(EditAnywhere)
+	float inputBufferWindow = 0.25f;
+
+	FCombatInputBuffer skillInputBuffer;
+
+	// Fires when the skill in a slot comes off cooldown, so UI doesn't have to poll
+	UPROPERTY(BlueprintAssignable)
+	FSkillReadySignature OnSkillReady;
+
 
 
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	void OnSkillsAssetsLoaded();
+
+	USkillBase* CreateSkill(TSubclassOf<USkillBase> skillClass, USkillDefinition* definition);
+
+	void BindSkillInput();
+	void SkillInput(int32 index);
+
 public:	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-	void SkillOne();
-	void SkillTwo();
-	void SkillThree();
-	void SkillFour();
-	void Skill(int index);
+	// Returns false when the slot is empty or still cooling down
+	UFUNCTION(BlueprintCallable)
+	bool Skill(int32 index);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	float GetCooldown(int32 index) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	int32 GetSkillCount() const { return skillsObject.Num(); }
+
+	void NotifySkillReady(USkillBase* skill);
+
+	// every skill ready again and nothing mid cast, for checkpoint retries
+	void ResetSkills();
 
 		
 };
@@ -8,7 +8,11 @@
 #include "GameHUD.generated.h"
 
 /**
- * 
+ * Game HUD. Also hosts the perf overlay (com.PerfOverlay), drawn straight on
+ * the canvas so it costs next to nothing: a frame time graph, game thread time
+ * per combat scope, enemy counts by state, attack turns, path following,
+ * widget count and the last GC pause. Everything but the graph refreshes a few
+ * times per second.
  */
 UCLASS()
 class FUCK_API AGameHUD : public AHUD
@@ -16,7 +20,67 @@ class FUCK_API AGameHUD : public AHUD
 	GENERATED_BODY()
 public:
 	AGameHUD();
+
+	virtual void DrawHUD() override;
+
+	void TogglePerfOverlay();
+	bool IsPerfOverlayVisible() const { return bShowPerfOverlay; }
+
+	// Seconds between overlay text refreshes
+	UPROPERTY(EditAnywhere, Category = "Perf Overlay")
+	float PerfOverlayRefreshInterval = 0.25f;
+
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	APlayerCharacter* PlayerCharacter;
-};
\ No newline at end of file
+
+private:
+	struct FPerfSnapshot
+	{
+		// Average ms per frame since the last refresh, by scope name
+		TArray<TPair<FString, float>> ScopeMs;
+
+		int32 Enemies = 0;
+		int32 EnemiesActive = 0;
+		int32 EnemiesIdle = 0;
+		int32 EnemiesDead = 0;
+		int32 EnemiesTicking = 0;
+		int32 AttackTurns = 0;
+		float AttackResource = 0.0f;
+
+		int32 PathsMoving = 0;
+		int32 PathsWaiting = 0;
+		int32 NavBuildTasks = 0;
+
+		int32 Widgets = 0;
+		int32 WidgetsInViewport = 0;
+	};
+
+	void RecordFrame();
+	void RefreshPerfSnapshot();
+	void DrawPerfOverlay();
+	void DrawFrameGraph(float X, float Y, float Width, float Height);
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	bool bShowPerfOverlay = false;
+
+	// Ring buffer of the latest frame and game thread times
+	static constexpr int32 GraphFrames = 150;
+	TArray<float> FrameMs;
+	TArray<float> GameThreadMs;
+	int32 GraphHead = 0;
+
+	FPerfSnapshot Snapshot;
+	double NextRefreshTime = 0.0;
+	int32 FramesSinceRefresh = 0;
+	TArray<TPair<const TCHAR*, uint64>> LastScopeCycles;
+
+	double GCStartTime = 0.0;
+	float LastGCMs = 0.0f;
+	int32 GCCount = 0;
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
@@ -21,6 +21,13 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void LoadMainMenu();
 
+	// Restores the last checkpoint in place and closes the screen
+	UFUNCTION(BlueprintCallable)
+	void Retry();
+
+	UFUNCTION(BlueprintPure)
+	bool CanRetry() const;
+
 	UPROPERTY(EditAnywhere)
 	TSoftObjectPtr<UWorld> MainMenuMap;
 };
@@ -19,6 +19,13 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void StartGame();
 
+	// Opens StartLevel and loads the save slot into it
+	UFUNCTION(BlueprintCallable)
+	void ContinueGame();
+
+	UFUNCTION(BlueprintPure)
+	bool CanContinue() const;
+
 	UFUNCTION(BlueprintCallable)
 	void ExitGame();
 
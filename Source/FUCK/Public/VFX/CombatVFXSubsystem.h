@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatVFXSubsystem.generated.h"
+
+class UNiagaraComponent;
+class UNiagaraSystem;
+class USceneComponent;
+
+UENUM(BlueprintType)
+enum class ECombatVFXType : uint8
+{
+	Skill, EnemyAttack, BossAttack, Impact, Count UMETA(Hidden)
+};
+
+USTRUCT()
+struct FCombatVFXBudget
+{
+	GENERATED_BODY()
+
+	UPROPERTY(config)
+	ECombatVFXType Type = ECombatVFXType::Skill;
+
+	// Effects of this type alive at once, the least significant one is stolen past this
+	UPROPERTY(config)
+	int32 MaxActive = 8;
+
+	// Spawns further than this from the viewer are skipped
+	UPROPERTY(config)
+	float CullDistance = 6000.0f;
+
+	// Effects still alive after this are deactivated so looping systems can't leak
+	UPROPERTY(config)
+	float MaxLifetime = 10.0f;
+};
+
+// Identifies one spawn; stays safe to release after the component went back to the pool
+USTRUCT(BlueprintType)
+struct FCombatVFXHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TWeakObjectPtr<UNiagaraComponent> Component;
+
+	UPROPERTY()
+	int32 Serial = 0;
+
+	bool IsValid() const { return Component.IsValid() && Serial != 0; }
+};
+
+/**
+ * Single entry point for combat VFX. Components come from the Niagara world
+ * pool and auto-release when finished, with a per-type cap, viewer distance
+ * culling and a lifetime limit keeping the cost bounded in big fights.
+ */
+UCLASS(config = Game)
+class FUCK_API UCombatVFXSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintCallable, Category = "VFX")
+	FCombatVFXHandle SpawnAtLocation(UNiagaraSystem* System, ECombatVFXType Type, FVector Location, FRotator Rotation);
+
+	UFUNCTION(BlueprintCallable, Category = "VFX")
+	FCombatVFXHandle SpawnAttached(UNiagaraSystem* System, ECombatVFXType Type, USceneComponent* AttachTo, FName SocketName);
+
+	// Lets a looping effect finish and return to the pool
+	UFUNCTION(BlueprintCallable, Category = "VFX")
+	void Release(const FCombatVFXHandle& Handle);
+
+	int32 GetActiveCount(ECombatVFXType Type) const;
+	int32 GetSpawnCount() const { return SpawnCount; }
+
+	UPROPERTY(config)
+	TArray<FCombatVFXBudget> Budgets;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FActiveEffect
+	{
+		TWeakObjectPtr<UNiagaraComponent> Component;
+		int32 Serial = 0;
+		float SpawnTime = 0.0f;
+	};
+
+	const FCombatVFXBudget& GetBudget(ECombatVFXType Type) const;
+	bool GetViewLocation(FVector& OutLocation) const;
+
+	// Returns false when the new effect is less significant than everything already playing
+	bool MakeRoom(ECombatVFXType Type, const FVector& Location);
+	FCombatVFXHandle Track(UNiagaraComponent* Component, ECombatVFXType Type);
+
+	UFUNCTION()
+	void OnEffectFinished(UNiagaraComponent* Component);
+
+	void ExpireEffects();
+
+	TArray<FActiveEffect> Active[(int32)ECombatVFXType::Count];
+	FCombatVFXBudget DefaultBudget;
+
+	FTimerHandle ExpireHandle;
+	int32 NextSerial = 1;
+	int32 SpawnCount = 0;
+};
@@ -6,6 +6,7 @@
 #include "Components/ActorComponent.h"
 #include "XPController.generated.h"
 
+class UCurveFloat;
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class FUCK_API UXPController : public UActorComponent
@@ -22,20 +23,49 @@ public:
 	FXPChangedSignature OnMaxXPChanged;
 	FLevelChangedSignature OnLevelChanged;
 
+	// Resolves the grant right away, however many levels it spans, with one event of each kind
 	void AddXP(float Value);
 
-protected:
-	// Called when the game starts
-	virtual void BeginPlay() override;
+	// Collects grants (mass kills) and resolves them together at the end of the frame
+	void QueueXP(float Value);
 
-public:
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
-	                           FActorComponentTickFunction* ThisTickFunction) override;
+	int GetLevel() const { return CurrentLevel; }
+
+	// XP into the current level and the XP the current level takes
+	float GetXP() const;
+	float GetMaxXP() const;
+
+	// save game: level and progress towards the next one
+	void SerializeSaveState(FArchive& Ar);
+
+	// XP a level takes, indexed by level. Unset, each level takes FirstLevelXP * LevelXPGrowth^Level.
+	UPROPERTY(EditAnywhere, Category = "XP")
+	UCurveFloat* LevelXPCurve;
+
+	UPROPERTY(EditAnywhere, Category = "XP")
+	float FirstLevelXP = 1.0f;
+
+	UPROPERTY(EditAnywhere, Category = "XP")
+	float LevelXPGrowth = 1.05f;
+
+	UPROPERTY(EditAnywhere, Category = "XP")
+	int32 MaxLevel = 200;
+
+protected:
+	// builds the table, early enough for the owner's BeginPlay and save loading
+	virtual void OnRegister() override;
 
 private:
 	int CurrentLevel = 0;
-	float CurrentXP = 0.0f;
-	float MaxXP = 1.0f;
+
+	// XP earned since level 0
+	float TotalXP = 0.0f;
+	float QueuedXP = 0.0f;
+
+	// Total XP needed to reach each level, Thresholds[0] is 0
+	TArray<float> Thresholds;
+
+	void BuildThresholds();
+	void FlushQueuedXP();
 	void TryLevelUp();
 };
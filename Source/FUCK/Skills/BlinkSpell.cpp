@@ -2,18 +2,132 @@
 
 
 #include "BlinkSpell.h"
+#include "NavigationSystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
 
 UBlinkSpell::UBlinkSpell()
 {
 	cooldown = 3.0f;
 	distance = 1000.f;
+	previewLifetime = 0.5f;
+}
+
+bool UBlinkSpell::Initialize()
+{
+	if (!IsReady() || !FindLanding(pendingDestination))
+	{
+		return false;
+	}
+
+	hasPendingDestination = true;
+	const bool cast = Super::Initialize();
+	hasPendingDestination = false;
+
+	return cast;
 }
 
 void UBlinkSpell::Cast_Implementation()
 {
-	effectVFX = UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), effectVFXClass, player->GetActorLocation() + FVector(0, 0, 0), FRotator(0.f));
-	FVector _movement = player->GetVelocity();
-	_movement = _movement.GetSafeNormal2D();
-	player->SetActorLocation(player->GetActorLocation() + _movement * distance, true);
-	effectVFX = UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), effectVFXClass, player->GetActorLocation() + FVector(0, 0, 0), FRotator(0.f));
+	FVector destination = pendingDestination;
+
+	// a Blueprint may call Cast directly, without Initialize resolving the spot first
+	if (!hasPendingDestination && !FindLanding(destination))
+	{
+		return;
+	}
+
+	// streamed in by USkillsComponent, a cast before it is resident just skips the effect
+	UNiagaraSystem* VFX = effectVFXClass.Get();
+	UCombatVFXSubsystem* CombatVFX = GetWorld()->GetSubsystem<UCombatVFXSubsystem>();
+
+	effectVFX = CombatVFX->SpawnAtLocation(VFX, ECombatVFXType::Skill, caster->GetActorLocation() + FVector(0, 0, 0), FRotator(0.f));
+
+	// the navmesh and the landing overlap already vouch for the spot, so no sweep
+	caster->SetActorLocation(destination, false, nullptr, ETeleportType::TeleportPhysics);
+
+	effectVFX = CombatVFX->SpawnAtLocation(VFX, ECombatVFXType::Skill, caster->GetActorLocation() + FVector(0, 0, 0), FRotator(0.f));
+}
+
+bool UBlinkSpell::PreviewDestination(FVector& destination)
+{
+	if (!ResolveDestination(destination))
+	{
+		return false;
+	}
+
+	previewLocation = destination;
+	previewTime = GetWorld()->GetTimeSeconds();
+	return true;
+}
+
+bool UBlinkSpell::FindLanding(FVector& destination) const
+{
+	// Synchronous on purpose: the caster has to land in the frame of the cast. FindPathAsync answers a frame or
+	// more later, from where the caster was, and with a path bending around walls rather than the straight line
+	// a blink travels. The query is one navmesh raycast and one projection, no collision sweep.
+	if (!ResolveDestination(destination))
+	{
+		// standing still or briefly off the navmesh, a recent preview still knows where to go
+		if (previewTime < 0.f || GetWorld()->GetTimeSeconds() - previewTime > previewLifetime)
+		{
+			return false;
+		}
+
+		destination = previewLocation;
+	}
+
+	return IsLandingClear(destination);
+}
+
+bool UBlinkSpell::ResolveDestination(FVector& destination) const
+{
+	const UNavigationSystemV1* navigation = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	const FVector direction = caster ? caster->GetVelocity().GetSafeNormal2D() : FVector::ZeroVector;
+
+	if (!navigation || direction.IsZero())
+	{
+		return false;
+	}
+
+	const UCapsuleComponent* capsule = caster->GetCapsuleComponent();
+	const FVector extent(capsule->GetScaledCapsuleRadius(), capsule->GetScaledCapsuleRadius(), capsule->GetScaledCapsuleHalfHeight() * 2.f);
+
+	// Walks navmesh polygons instead of sweeping collision, stops where the line leaves the mesh.
+	// The raycast finds the start polygon itself, from the caster's feet.
+	const FVector start = caster->GetActorLocation() - FVector(0.f, 0.f, capsule->GetScaledCapsuleHalfHeight());
+	FVector end = start + direction * distance;
+	FVector hit;
+	if (UNavigationSystemV1::NavigationRaycast(caster->GetWorld(), start, end, hit, nullptr, caster->GetController()))
+	{
+		// keep the capsule off the edge the ray ran into
+		end = hit - direction * FMath::Min(capsule->GetScaledCapsuleRadius(), FVector::Dist2D(start, hit));
+	}
+
+	FNavLocation landing;
+	if (!navigation->ProjectPointToNavigation(end, landing, extent))
+	{
+		return false;
+	}
+
+	destination = landing.Location + FVector(0.f, 0.f, capsule->GetScaledCapsuleHalfHeight());
+	return true;
+}
+
+bool UBlinkSpell::IsLandingClear(const FVector& destination) const
+{
+	// Pawns and props standing on the navmesh, tested at the landing spot only
+	const UCapsuleComponent* capsule = caster->GetCapsuleComponent();
+	const FCollisionQueryParams params(SCENE_QUERY_STAT(BlinkLanding), false, caster);
+
+	return !GetWorld()->OverlapBlockingTestByChannel(destination, FQuat::Identity, capsule->GetCollisionObjectType(),
+		capsule->GetCollisionShape(), params, FCollisionResponseParams(capsule->GetCollisionResponseToChannels()));
+}
+
+void UBlinkSpell::GatherSoftAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	if (!effectVFXClass.IsNull())
+	{
+		OutAssets.Add(effectVFXClass.ToSoftObjectPath());
+	}
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "SkillBase.h"
 #include <NiagaraFunctionLibrary.h>
 #include <NiagaraComponent.h>
+#include "VFX/CombatVFXSubsystem.h"
 #include "BlinkSpell.generated.h"
 
 /**
@@ -23,10 +24,38 @@ public:
 	float distance;
 
 	UPROPERTY(EditAnywhere)
-	UNiagaraSystem* effectVFXClass;
+	TSoftObjectPtr<UNiagaraSystem> effectVFXClass;
 
-	UNiagaraComponent* effectVFX;
+	FCombatVFXHandle effectVFX;
+
+	// A preview this recent is used when the cast-time query finds no navmesh
+	UPROPERTY(EditAnywhere)
+	float previewLifetime;
+
+	// Fails without a destination, so a blink that can't go anywhere doesn't start the cooldown
+	virtual bool Initialize() override;
 
 	void Cast_Implementation() override;
 
+	// Where a blink cast now would land, for a target marker. Also kept as the cast fallback.
+	UFUNCTION(BlueprintCallable)
+	bool PreviewDestination(FVector& destination);
+
+	virtual void GatherSoftAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+
+private:
+	// Furthest point along the blink that stays on the navmesh, at capsule height
+	bool ResolveDestination(FVector& destination) const;
+
+	// The resolved destination or a recent preview, if nothing blocks the capsule there
+	bool FindLanding(FVector& destination) const;
+
+	bool IsLandingClear(const FVector& destination) const;
+
+	// Resolved by Initialize for the Cast that follows it
+	FVector pendingDestination;
+	bool hasPendingDestination = false;
+
+	FVector previewLocation;
+	float previewTime = -1.f;
 };
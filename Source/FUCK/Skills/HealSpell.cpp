@@ -2,30 +2,48 @@
 
 
 #include "HealSpell.h"
+#include "Combat/StatusEffectSubsystem.h"
 
 UHealSpell::UHealSpell()
 {
 	cooldown = 15.0f;
 	healRate = 1000.f;
-	samplingStep = 0.2f;
 	duration = 5.f;
 }
 
 void UHealSpell::Cast_Implementation()
 {
-	GetWorld()->GetTimerManager().SetTimer(timerHandler, this, &UHealSpell::OnTimer, samplingStep, true);
-	GetWorld()->GetTimerManager().SetTimer(durationHandler, this, &UHealSpell::OnEnd, duration, false);
-	effectVFX = UNiagaraFunctionLibrary::SpawnSystemAttached(effectVFXClass, player->GetMesh(), NAME_None, FVector(0.f), FRotator(0.f), EAttachLocation::Type::KeepRelativeOffset, true);
+	RunTimeline(FSkillTimeline()
+		.Then([this]()
+		{
+			FStatusEffectSpec Heal;
+			Heal.Id = TEXT("Heal");
+			Heal.HealthPerSecond = healRate;
+			Heal.Duration = duration;
+			Heal.Stacking = EStatusEffectStacking::Refresh;
+			GetWorld()->GetSubsystem<UStatusEffectSubsystem>()->ApplyEffect(caster, Heal, caster);
+
+			effectVFX = GetWorld()->GetSubsystem<UCombatVFXSubsystem>()->SpawnAttached(effectVFXClass.Get(), ECombatVFXType::Skill, caster->GetMesh(), NAME_None);
+		})
+		.Delay(duration)
+		.Then([this]() { OnEnd(); }));
 }
 
-void UHealSpell::OnTimer()
+void UHealSpell::OnEnd()
 {
-	//GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString::SanitizeFloat(player->GetHealth()));
-	player->SetHealth(player->GetHealth()+healRate*samplingStep);
+	GetWorld()->GetSubsystem<UCombatVFXSubsystem>()->Release(effectVFX);
+	effectVFX = FCombatVFXHandle();
 }
 
-void UHealSpell::OnEnd()
+void UHealSpell::OnTimelineCancelled()
+{
+	OnEnd();
+}
+
+void UHealSpell::GatherSoftAssets(TArray<FSoftObjectPath>& OutAssets) const
 {
-	GetWorld()->GetTimerManager().ClearTimer(timerHandler);
-	effectVFX->Deactivate();
+	if (!effectVFXClass.IsNull())
+	{
+		OutAssets.Add(effectVFXClass.ToSoftObjectPath());
+	}
 }
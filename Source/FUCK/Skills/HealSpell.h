@@ -6,6 +6,7 @@
 #include "SkillBase.h"
 #include <NiagaraFunctionLibrary.h>
 #include <NiagaraComponent.h>
+#include "VFX/CombatVFXSubsystem.h"
 #include "HealSpell.generated.h"
 
 
@@ -20,27 +21,25 @@ class FUCK_API UHealSpell : public USkillBase
 public:
 	UHealSpell();
 
+	// health per second while the effect runs
 	UPROPERTY(EditAnywhere)
 	float healRate;
 
-	UPROPERTY(EditAnywhere)
-	float samplingStep;
-	
 	UPROPERTY(EditAnywhere)
 	float duration;
 
 	UPROPERTY(EditAnywhere)
-	UNiagaraSystem* effectVFXClass;
+	TSoftObjectPtr<UNiagaraSystem> effectVFXClass;
 
-	UNiagaraComponent* effectVFX;
+	FCombatVFXHandle effectVFX;
 
 	void Cast_Implementation() override;
 
-	FTimerHandle timerHandler;
-	FTimerHandle durationHandler;
-
-	void OnTimer();	
+	virtual void GatherSoftAssets(TArray<FSoftObjectPath>& OutAssets) const override;
 
 	void OnEnd();
+
+	// the aura would otherwise play on until the VFX budget's lifetime runs out
+	virtual void OnTimelineCancelled() override;
 	
 };
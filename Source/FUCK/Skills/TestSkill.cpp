@@ -2,6 +2,7 @@
 
 
 #include "TestSkill.h"
+#include "FUCK/FUCK.h"
 UTestSkill::UTestSkill()
 {
 	cooldown = 5.0f;
@@ -10,6 +11,6 @@ UTestSkill::UTestSkill()
 
 void UTestSkill::Cast_Implementation()
 {
-	GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::Printf(TEXT("ass")));
+	UE_LOG(LogCityOfMyths, Verbose, TEXT("%s cast by %s"), *GetName(), *GetNameSafe(caster));
 	CooldownCut();
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "PlayerCharacter.h"
+#include "Data/CombatantArchetype.h"
+#include "Profiling/CombatStats.h"
 
 ASteamPunkMech2837::ASteamPunkMech2837()
 {
@@ -30,6 +32,48 @@ void ASteamPunkMech2837::Tick(float DeltaTime)
 	TickStateMachine();
 }
 
+void ASteamPunkMech2837::ApplyArchetypeAssets()
+{
+	Super::ApplyArchetypeAssets();
+
+	if (Archetype)
+	{
+		UCombatantArchetype::Resolve(Archetype->MagicSpellAnimations, MagicSpell);
+		UCombatantArchetype::Resolve(Archetype->LongAttackAnimations, LongAttackAnimation);
+	}
+}
+
+void ASteamPunkMech2837::ReleaseArchetypeAssets()
+{
+	if (Archetype && Archetype->MagicSpellAnimations.Num() > 0)
+	{
+		MagicSpell.Empty();
+	}
+
+	if (Archetype && Archetype->LongAttackAnimations.Num() > 0)
+	{
+		LongAttackAnimation.Empty();
+	}
+
+	Super::ReleaseArchetypeAssets();
+}
+
+void ASteamPunkMech2837::GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const
+{
+	Super::GatherCombatMontages(OutMontages);
+	OutMontages.Append(MagicSpell);
+	OutMontages.Append(LongAttackAnimation);
+}
+
+#if WITH_EDITORONLY_DATA
+void ASteamPunkMech2837::VisitLegacyMontages(FLegacyMontageVisitor Visit)
+{
+	Super::VisitLegacyMontages(Visit);
+	Visit(MagicSpell_DEPRECATED, MagicSpell, GET_MEMBER_NAME_CHECKED(UCombatantArchetype, MagicSpellAnimations));
+	Visit(LongAttackAnimation_DEPRECATED, LongAttackAnimation, GET_MEMBER_NAME_CHECKED(UCombatantArchetype, LongAttackAnimations));
+}
+#endif
+
 void ASteamPunkMech2837::StateChaseClose()
 {
 
@@ -48,18 +92,22 @@ void ASteamPunkMech2837::StateChaseClose()
 			Attack(true);
 			return;
 		}
-		else if (UGameplayStatics::GetTimeSeconds(GetWorld()) >= MagicSpell_Timestamp + MagicSpell_Cooldown && AIController->LineOfSightTo(Target))
+		else if (UGameplayStatics::GetTimeSeconds(GetWorld()) >= MagicSpell_Timestamp + MagicSpell_Cooldown && CanSeeTarget())
 		{
 			MagicSpell_Timestamp = UGameplayStatics::GetTimeSeconds(GetWorld());
 			MagicAttack(true);
 			return;
 		}
-		else if (Distance > 300 && UGameplayStatics::GetTimeSeconds(GetWorld()) >= LongAttack_Timestamp + LongAttack_Cooldown && AIController->LineOfSightTo(Target))
+		else if (Distance > 300 && UGameplayStatics::GetTimeSeconds(GetWorld()) >= LongAttack_Timestamp + LongAttack_Cooldown && CanSeeTarget())
 		{
 			LongAttack_Timestamp = UGameplayStatics::GetTimeSeconds(GetWorld());
 			LongAttack(true);
 			return;
 		}
+		else if (TryCastSkill())
+		{
+			return;
+		}
 	}
 	if (!AIController->IsFollowingAPath())
 	{
@@ -75,10 +123,13 @@ void ASteamPunkMech2837::MoveForward()
 
 void ASteamPunkMech2837::StateAttack()
 {
+	COM_SCOPE(STAT_COM_AttackOverlaps);
+
 	if (AttackDamaging)
 	{
 
 		TSet<AActor*> OverlappingActors;
+		INC_DWORD_STAT(STAT_COM_OverlapQueries);
 		DamageCollision->GetOverlappingActors(OverlappingActors);
 
 		for (AActor* OtherActor : OverlappingActors)
@@ -87,7 +138,7 @@ void ASteamPunkMech2837::StateAttack()
 			{
 				continue;
 			}
-			if (!AttackHitActors.Contains(OtherActor))
+			if (!HasAttackHit(OtherActor))
 			{
 				float AppliedDamage = UGameplayStatics::ApplyDamage(OtherActor, ClassDamage, GetController(), this, UDamageType::StaticClass());
 
@@ -99,7 +150,7 @@ void ASteamPunkMech2837::StateAttack()
 
 				if (AppliedDamage > 0.0f)
 				{
-					AttackHitActors.Add(OtherActor);
+					RegisterAttackHit(OtherActor);
 				}
 			}
 		}
@@ -113,6 +164,11 @@ void ASteamPunkMech2837::StateAttack()
 
 void ASteamPunkMech2837::LongAttack(bool Rotate)
 {
+	if (!AreCombatAssetsReady() || LongAttackAnimation.Num() == 0)
+	{
+		return;
+	}
+
 	Super::Attack();
 
 	SetMovingBackwards(false);
@@ -137,6 +193,11 @@ void ASteamPunkMech2837::LongAttack(bool Rotate)
 
 void ASteamPunkMech2837::MagicAttack(bool Rotate)
 {
+	if (!AreCombatAssetsReady() || MagicSpell.Num() == 0)
+	{
+		return;
+	}
+
 	Super::Attack();
 
 	SetMovingBackwards(false);
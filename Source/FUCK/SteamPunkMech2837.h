@@ -24,11 +24,19 @@ public:
 	UCapsuleComponent* DamageCollision;
 
 
-	UPROPERTY(EditAnywhere, Category = "Animations")
+	UPROPERTY(Transient)
 	TArray<UAnimMontage*> MagicSpell;
 
-	UPROPERTY(EditAnywhere, Category = "Animations")
+	UPROPERTY(Transient)
 	TArray<UAnimMontage*> LongAttackAnimation;
+
+	virtual void ApplyArchetypeAssets() override;
+	virtual void ReleaseArchetypeAssets() override;
+	virtual void GatherCombatMontages(TArray<UAnimMontage*>& OutMontages) const override;
+
+#if WITH_EDITORONLY_DATA
+	virtual void VisitLegacyMontages(FLegacyMontageVisitor Visit) override;
+#endif
 	
 protected:
 	void StateChaseClose();
@@ -50,4 +58,12 @@ private:
 
 	UPROPERTY(EditAnywhere, Category = "Combat")
 	float ForwardSpeedAttack;
+
+#if WITH_EDITORONLY_DATA
+	UPROPERTY()
+	TArray<UAnimMontage*> MagicSpell_DEPRECATED;
+
+	UPROPERTY()
+	TArray<UAnimMontage*> LongAttackAnimation_DEPRECATED;
+#endif
 };
@@ -11,5 +11,6 @@ public class FUCKEditorTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V4;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_3;
 		ExtraModuleNames.Add("FUCK");
+		ExtraModuleNames.Add("FUCKEditor");
 	}
 }
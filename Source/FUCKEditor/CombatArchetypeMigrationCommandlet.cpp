@@ -0,0 +1,130 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatArchetypeMigrationCommandlet.h"
+
+#include "AssetRegistry/AssetRegistryModule.h"
+#include "Engine/Blueprint.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+#include "Data/CombatantArchetype.h"
+#include "FUCK/Combatant.h"
+#include "FUCKEditor.h"
+
+UCombatArchetypeMigrationCommandlet::UCombatArchetypeMigrationCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UCombatArchetypeMigrationCommandlet::Main(const FString& Params)
+{
+	FString Dir = TEXT("/Game/Blueprint/Archetypes");
+	FParse::Value(*Params, TEXT("-Dir="), Dir);
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	TArray<FAssetData> Blueprints;
+	AssetRegistry.GetAssetsByClass(UBlueprint::StaticClass()->GetClassPathName(), Blueprints, true);
+
+	int32 Migrated = 0;
+	int32 Failed = 0;
+
+	for (const FAssetData& Asset : Blueprints)
+	{
+		// The native parent tag leaves every other Blueprint unloaded
+		FString NativeParent;
+		if (!Asset.GetTagValue(FBlueprintTags::NativeParentClassPath, NativeParent))
+		{
+			continue;
+		}
+
+		const UClass* NativeClass = FindObject<UClass>(nullptr, *FPackageName::ExportTextPathToObjectPath(NativeParent));
+		if (!NativeClass || !NativeClass->IsChildOf<ACombatant>())
+		{
+			continue;
+		}
+
+		UBlueprint* Blueprint = Cast<UBlueprint>(Asset.GetAsset());
+		if (!Blueprint || !Blueprint->GeneratedClass || !Blueprint->GeneratedClass->GetDefaultObject<ACombatant>()->HasLegacyMontages())
+		{
+			continue;
+		}
+
+		if (Migrate(Blueprint, Dir))
+		{
+			Migrated++;
+		}
+		else
+		{
+			Failed++;
+		}
+	}
+
+	UE_LOG(LogCityOfMythsEditor, Display, TEXT("CombatArchetypeMigration: %d Blueprints migrated, %d failed"), Migrated, Failed);
+
+	return Failed > 0 ? 1 : 0;
+}
+
+bool UCombatArchetypeMigrationCommandlet::Migrate(UBlueprint* Blueprint, const FString& Dir) const
+{
+	ACombatant* Defaults = Blueprint->GeneratedClass->GetDefaultObject<ACombatant>();
+	UCombatantArchetype* Archetype = Defaults->Archetype;
+
+	if (!Archetype)
+	{
+		const FString Name = TEXT("DA_") + Blueprint->GetName();
+		UPackage* Package = CreatePackage(*(Dir / Name));
+
+		Archetype = NewObject<UCombatantArchetype>(Package, *Name, RF_Public | RF_Standalone | RF_Transactional);
+		FAssetRegistryModule::AssetCreated(Archetype);
+	}
+
+	Archetype->Modify();
+	Defaults->Modify();
+
+	Defaults->VisitLegacyMontages([Archetype](TArray<UAnimMontage*>& Legacy, TArray<UAnimMontage*>&, FName ArchetypeProperty)
+	{
+		const FArrayProperty* Property = FindFProperty<FArrayProperty>(UCombatantArchetype::StaticClass(), ArchetypeProperty);
+		TArray<TSoftObjectPtr<UAnimMontage>>& Montages = *Property->ContainerPtrToValuePtr<TArray<TSoftObjectPtr<UAnimMontage>>>(Archetype);
+
+		// What the archetype already lists wins over the Blueprint's copy
+		if (Montages.IsEmpty())
+		{
+			for (UAnimMontage* Montage : Legacy)
+			{
+				if (Montage)
+				{
+					Montages.Add(Montage);
+				}
+			}
+		}
+
+		Legacy.Empty();
+	});
+
+	Defaults->Archetype = Archetype;
+	Blueprint->MarkPackageDirty();
+
+	const bool bSaved = Save(Archetype->GetPackage()) && Save(Blueprint->GetPackage());
+
+	UE_LOG(LogCityOfMythsEditor, Display, TEXT("CombatArchetypeMigration: %s -> %s%s"), *Blueprint->GetPathName(), *Archetype->GetPathName(),
+		bSaved ? TEXT("") : TEXT(", failed to save"));
+
+	return bSaved;
+}
+
+bool UCombatArchetypeMigrationCommandlet::Save(UPackage* Package)
+{
+	FSavePackageArgs Args;
+	Args.TopLevelFlags = RF_Public | RF_Standalone;
+	Args.SaveFlags = SAVE_NoError;
+
+	const FString Filename = FPackageName::LongPackageNameToFilename(Package->GetName(), FPackageName::GetAssetPackageExtension());
+
+	return UPackage::SavePackage(Package, nullptr, *Filename, Args);
+}
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CombatArchetypeMigrationCommandlet.generated.h"
+
+class UBlueprint;
+
+/**
+ * Moves the montage lists combatant Blueprints still author on the actor into
+ * a UCombatantArchetype asset, so that only soft references are saved and
+ * the montages load with their encounter instead of with the map:
+ *
+ *   UnrealEditor-Cmd FUCK.uproject -run=CombatArchetypeMigration
+ *
+ * A Blueprint without an archetype gets DA_<Blueprint> in -Dir= (default
+ * /Game/Blueprint/Archetypes). One that has one only fills the archetype
+ * lists that are still empty. Both packages are saved.
+ */
+UCLASS()
+class UCombatArchetypeMigrationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCombatArchetypeMigrationCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	bool Migrate(UBlueprint* Blueprint, const FString& Dir) const;
+
+	static bool Save(UPackage* Package);
+};
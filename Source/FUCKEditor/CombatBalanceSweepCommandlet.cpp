@@ -0,0 +1,355 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatBalanceSweepCommandlet.h"
+
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Profiling/CombatBalanceGameMode.h"
+#include "FUCKEditor.h"
+
+UCombatBalanceSweepCommandlet::UCombatBalanceSweepCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UCombatBalanceSweepCommandlet::Main(const FString& Params)
+{
+	FString Map;
+
+	if (!FParse::Value(*Params, TEXT("-Map="), Map))
+	{
+		UE_LOG(LogCityOfMythsEditor, Error, TEXT("CombatBalanceSweep needs -Map=<arena map>"));
+		return 1;
+	}
+
+	int32 SeedsPerPoint = 10;
+	int32 Jobs = FPlatformMisc::NumberOfCores();
+	float TimeLimit = 300.0f;
+	float StepRate = 30.0f;
+	FString Name = FDateTime::Now().ToString();
+
+	FParse::Value(*Params, TEXT("-Runs="), SeedsPerPoint);
+	FParse::Value(*Params, TEXT("-Jobs="), Jobs);
+	FParse::Value(*Params, TEXT("-TimeLimit="), TimeLimit);
+	FParse::Value(*Params, TEXT("-StepRate="), StepRate);
+	FParse::Value(*Params, TEXT("-Name="), Name);
+
+	const bool bCheckDeterminism = FParse::Param(*Params, TEXT("CheckDeterminism"));
+
+	SeedsPerPoint = FMath::Max(SeedsPerPoint, 1);
+	Jobs = FMath::Max(Jobs, 1);
+
+	// -Sweep=<Option>:<Value>,<Value>,...
+	const TCHAR* Cursor = *Params;
+	FString Token;
+
+	while (FParse::Token(Cursor, Token, false))
+	{
+		FString Option, Values;
+
+		if (!Token.StartsWith(TEXT("-Sweep=")) || !Token.RightChop(7).Split(TEXT(":"), &Option, &Values))
+		{
+			continue;
+		}
+
+		FSweepAxis& Axis = Axes.AddDefaulted_GetRef();
+		Axis.Option = Option;
+		Values.ParseIntoArray(Axis.Values, TEXT(","));
+
+		if (Axis.Values.IsEmpty())
+		{
+			UE_LOG(LogCityOfMythsEditor, Error, TEXT("CombatBalanceSweep: %s has no values"), *Token);
+			return 1;
+		}
+	}
+
+	int32 PointCount = 1;
+	for (const FSweepAxis& Axis : Axes)
+	{
+		PointCount *= Axis.Values.Num();
+	}
+
+	const FString OutputDir = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProfilingDir(), TEXT("Balance"), Name));
+
+	for (int32 Point = 0; Point < PointCount; Point++)
+	{
+		const TArray<FString> Values = GetPointValues(Point);
+
+		FString Options = FString::Printf(TEXT("?TimeLimit=%g?StepRate=%g"), TimeLimit, StepRate);
+		for (int32 i = 0; i < Axes.Num(); i++)
+		{
+			Options += FString::Printf(TEXT("?%s=%s"), *Axes[i].Option, *Values[i]);
+		}
+
+		for (int32 Seed = 1; Seed <= SeedsPerPoint; Seed++)
+		{
+			const int32 First = Runs.Num();
+
+			for (int32 Repeat = 0; Repeat < (bCheckDeterminism ? 2 : 1); Repeat++)
+			{
+				FRun& Run = Runs.AddDefaulted_GetRef();
+				Run.Point = Point;
+				Run.Seed = Seed;
+				Run.Options = Options;
+				Run.RepeatOf = Repeat > 0 ? First : INDEX_NONE;
+				Run.OutputPath = FPaths::Combine(OutputDir, FString::Printf(TEXT("Run_%d.csv"), Runs.Num() - 1));
+				Run.LogPath = FPaths::Combine(OutputDir, FString::Printf(TEXT("Run_%d.log"), Runs.Num() - 1));
+			}
+		}
+	}
+
+	UE_LOG(LogCityOfMythsEditor, Display, TEXT("CombatBalanceSweep: %d combinations x %d seeds = %d fights%s, %d at a time, into %s"),
+		PointCount, SeedsPerPoint, Runs.Num(), bCheckDeterminism ? TEXT(" (each seed twice)") : TEXT(""), Jobs, *OutputDir);
+
+	const double StartTime = FPlatformTime::Seconds();
+	TArray<int32> Running;
+	int32 NextRun = 0;
+	int32 Finished = 0;
+
+	while (NextRun < Runs.Num() || !Running.IsEmpty())
+	{
+		while (Running.Num() < Jobs && NextRun < Runs.Num())
+		{
+			if (Launch(Runs[NextRun], Map))
+			{
+				Running.Add(NextRun);
+			}
+			else
+			{
+				Finished++;
+			}
+
+			NextRun++;
+		}
+
+		for (int32 i = Running.Num() - 1; i >= 0; i--)
+		{
+			FRun& Run = Runs[Running[i]];
+
+			if (FPlatformProcess::IsProcRunning(Run.Process))
+			{
+				continue;
+			}
+
+			Collect(Run);
+			Running.RemoveAtSwap(i);
+			Finished++;
+
+			UE_LOG(LogCityOfMythsEditor, Display, TEXT("CombatBalanceSweep: %d/%d done, %.0f s"), Finished, Runs.Num(), FPlatformTime::Seconds() - StartTime);
+		}
+
+		FPlatformProcess::Sleep(0.1f);
+	}
+
+	const int32 Failed = Runs.FilterByPredicate([](const FRun& Run) { return Run.Result.IsEmpty(); }).Num();
+	const int32 Mismatches = CountMismatches();
+
+	if (!WriteRuns(FPaths::Combine(OutputDir, TEXT("Runs.csv"))) || !WriteSummary(FPaths::Combine(OutputDir, TEXT("Summary.csv"))))
+	{
+		UE_LOG(LogCityOfMythsEditor, Error, TEXT("CombatBalanceSweep: failed to write the results to %s"), *OutputDir);
+		return 1;
+	}
+
+	UE_LOG(LogCityOfMythsEditor, Display, TEXT("CombatBalanceSweep: %d fights in %.0f s, %d failed, %d not deterministic, results in %s"),
+		Runs.Num(), FPlatformTime::Seconds() - StartTime, Failed, Mismatches, *OutputDir);
+
+	return Failed > 0 || Mismatches > 0 ? 1 : 0;
+}
+
+TArray<FString> UCombatBalanceSweepCommandlet::GetPointValues(int32 Point) const
+{
+	TArray<FString> Values;
+
+	// Mixed radix, the last axis changes fastest
+	for (int32 i = Axes.Num() - 1; i >= 0; i--)
+	{
+		Values.Insert(Axes[i].Values[Point % Axes[i].Values.Num()], 0);
+		Point /= Axes[i].Values.Num();
+	}
+
+	return Values;
+}
+
+bool UCombatBalanceSweepCommandlet::Launch(FRun& Run, const FString& Map) const
+{
+	const FString Url = FString::Printf(TEXT("%s?game=/Script/FUCK.CombatBalanceGameMode?Seed=%d%s?Output=%s"),
+		*Map, Run.Seed, *Run.Options, *Run.OutputPath);
+
+	const FString Args = FString::Printf(TEXT("\"%s\" \"%s\" -game -nullrhi -nosound -unattended -nosplash -abslog=\"%s\""),
+		*FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath()), *Url, *Run.LogPath);
+
+	Run.Process = FPlatformProcess::CreateProc(FPlatformProcess::ExecutablePath(), *Args, false, true, true, nullptr, 0, nullptr, nullptr);
+
+	if (!Run.Process.IsValid())
+	{
+		UE_LOG(LogCityOfMythsEditor, Error, TEXT("CombatBalanceSweep: can't start %s %s"), FPlatformProcess::ExecutablePath(), *Args);
+		return false;
+	}
+
+	return true;
+}
+
+void UCombatBalanceSweepCommandlet::Collect(FRun& Run) const
+{
+	FPlatformProcess::GetProcReturnCode(Run.Process, &Run.ReturnCode);
+	FPlatformProcess::CloseProc(Run.Process);
+
+	TArray<FString> Lines;
+
+	if (Run.ReturnCode == 0 && FFileHelper::LoadFileToStringArray(Lines, *Run.OutputPath) && Lines.Num() >= 2)
+	{
+		Run.Result = Lines[1];
+	}
+	else
+	{
+		UE_LOG(LogCityOfMythsEditor, Warning, TEXT("CombatBalanceSweep: seed %d of%s failed with %d, see %s"),
+			Run.Seed, *Run.Options, Run.ReturnCode, *Run.LogPath);
+	}
+}
+
+int32 UCombatBalanceSweepCommandlet::CountMismatches() const
+{
+	int32 Mismatches = 0;
+
+	for (const FRun& Run : Runs)
+	{
+		// Failed runs are already counted as such
+		if (Run.RepeatOf == INDEX_NONE || Run.Result.IsEmpty() || Runs[Run.RepeatOf].Result.IsEmpty())
+		{
+			continue;
+		}
+
+		const FRun& First = Runs[Run.RepeatOf];
+
+		if (Run.Result != First.Result)
+		{
+			Mismatches++;
+
+			UE_LOG(LogCityOfMythsEditor, Error, TEXT("CombatBalanceSweep: seed %d of%s is not deterministic, %s wrote %s, %s wrote %s"),
+				Run.Seed, *Run.Options, *First.OutputPath, *First.Result, *Run.OutputPath, *Run.Result);
+		}
+	}
+
+	return Mismatches;
+}
+
+bool UCombatBalanceSweepCommandlet::WriteRuns(const FString& Path) const
+{
+	FString Csv = TEXT("Run,Seed");
+
+	for (const FSweepAxis& Axis : Axes)
+	{
+		Csv += TEXT(",") + Axis.Option;
+	}
+
+	Csv += FString::Printf(TEXT(",ExitCode,%s\n"), ACombatBalanceGameMode::CsvHeader);
+
+	for (int32 i = 0; i < Runs.Num(); i++)
+	{
+		const FRun& Run = Runs[i];
+
+		if (Run.RepeatOf != INDEX_NONE)
+		{
+			continue;
+		}
+
+		Csv += FString::Printf(TEXT("%d,%d,"), i, Run.Seed);
+
+		for (const FString& Value : GetPointValues(Run.Point))
+		{
+			Csv += Value + TEXT(",");
+		}
+
+		Csv += FString::Printf(TEXT("%d,%s\n"), Run.ReturnCode, *Run.Result);
+	}
+
+	return FFileHelper::SaveStringToFile(Csv, *Path);
+}
+
+bool UCombatBalanceSweepCommandlet::WriteSummary(const FString& Path) const
+{
+	TArray<FString> Columns;
+	FString(ACombatBalanceGameMode::CsvHeader).ParseIntoArray(Columns, TEXT(","), false);
+
+	const int32 WinColumn = Columns.IndexOfByKey(TEXT("Win"));
+	const int32 TimeToKillColumn = Columns.IndexOfByKey(TEXT("TimeToKill"));
+	const int32 DamageColumn = Columns.IndexOfByKey(TEXT("DamageTaken"));
+
+	struct FPointStats
+	{
+		int32 Runs = 0;
+		int32 Completed = 0;
+		int32 Wins = 0;
+		double TimeToKill = 0.0;
+		double DamageTaken = 0.0;
+	};
+
+	TArray<FPointStats> Stats;
+
+	for (const FRun& Run : Runs)
+	{
+		if (Run.RepeatOf != INDEX_NONE)
+		{
+			continue;
+		}
+
+		if (Stats.Num() <= Run.Point)
+		{
+			Stats.SetNum(Run.Point + 1);
+		}
+
+		Stats[Run.Point].Runs++;
+
+		TArray<FString> Fields;
+		Run.Result.ParseIntoArray(Fields, TEXT(","), false);
+
+		if (Fields.Num() != Columns.Num())
+		{
+			continue;
+		}
+
+		FPointStats& Point = Stats[Run.Point];
+		Point.Completed++;
+		Point.DamageTaken += FCString::Atod(*Fields[DamageColumn]);
+
+		if (FCString::Atoi(*Fields[WinColumn]) != 0)
+		{
+			Point.Wins++;
+			Point.TimeToKill += FCString::Atod(*Fields[TimeToKillColumn]);
+		}
+	}
+
+	FString Csv;
+
+	for (const FSweepAxis& Axis : Axes)
+	{
+		Csv += Axis.Option + TEXT(",");
+	}
+
+	Csv += TEXT("Runs,Completed,WinRate,MeanTimeToKill,MeanDamageTaken\n");
+
+	for (int32 Point = 0; Point < Stats.Num(); Point++)
+	{
+		const FPointStats& PointStats = Stats[Point];
+
+		for (const FString& Value : GetPointValues(Point))
+		{
+			Csv += Value + TEXT(",");
+		}
+
+		// Time to kill only averages the fights that were won
+		Csv += FString::Printf(TEXT("%d,%d,%.3f,%s,%.1f\n"), PointStats.Runs, PointStats.Completed,
+			PointStats.Completed > 0 ? (double)PointStats.Wins / PointStats.Completed : 0.0,
+			PointStats.Wins > 0 ? *FString::Printf(TEXT("%.3f"), PointStats.TimeToKill / PointStats.Wins) : TEXT(""),
+			PointStats.Completed > 0 ? PointStats.DamageTaken / PointStats.Completed : 0.0);
+	}
+
+	return FFileHelper::SaveStringToFile(Csv, *Path);
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "CombatBalanceSweepCommandlet.generated.h"
+
+/**
+ * Runs a balance sweep overnight on a CPU-only machine: every combination of
+ * the swept values, Runs seeds each, as headless ACombatBalanceGameMode
+ * processes, Jobs of them side by side. Writes Runs.csv (one row per fight)
+ * and Summary.csv (win rate, mean time to kill and damage taken per
+ * combination) to Saved/Profiling/Balance/<Name>:
+ *
+ *   UnrealEditor-Cmd FUCK.uproject -run=CombatBalanceSweep -Map=/Game/Maps/Arena -Runs=20
+ *       -Sweep=Mechs:1,2 -Sweep=Mech.MaxHealth:2000,3000 -Sweep=CombatManager.attackCooldown:0.5,1
+ *
+ * -Sweep takes any option of the balance game mode and can repeat. Also
+ * -Jobs= (default: one per core), -Name=, -TimeLimit=, -StepRate=.
+ *
+ * -CheckDeterminism fights every seed twice and fails the sweep when the two
+ * runs wrote different rows. Only the first run goes into the results.
+ */
+UCLASS()
+class UCombatBalanceSweepCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UCombatBalanceSweepCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FSweepAxis
+	{
+		FString Option;
+		TArray<FString> Values;
+	};
+
+	struct FRun
+	{
+		int32 Point = 0;
+		int32 Seed = 0;
+		FString Options;
+		FString OutputPath;
+		FString LogPath;
+		// The run this one repeats with the same seed under -CheckDeterminism
+		int32 RepeatOf = INDEX_NONE;
+		FProcHandle Process;
+		int32 ReturnCode = -1;
+		// The result row the game mode wrote, empty if the run failed
+		FString Result;
+	};
+
+	bool Launch(FRun& Run, const FString& Map) const;
+	void Collect(FRun& Run) const;
+
+	// Repeated runs whose row differs from the first, logged
+	int32 CountMismatches() const;
+
+	bool WriteRuns(const FString& Path) const;
+	bool WriteSummary(const FString& Path) const;
+
+	// The axis values of one combination, in axis order
+	TArray<FString> GetPointValues(int32 Point) const;
+
+	TArray<FSweepAxis> Axes;
+	TArray<FRun> Runs;
+};
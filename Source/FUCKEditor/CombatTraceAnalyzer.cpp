@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CombatTraceAnalyzer.h"
+
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Trace/Analysis.h"
+#include "Trace/DataStream.h"
+#include "FUCK/EnemyBase.h"
+#include "FUCKEditor.h"
+
+static FAutoConsoleCommand ExportCombatTraceCommand(
+	TEXT("com.Trace.ExportCombat"),
+	TEXT("Writes the Combat channel of a .utrace to <trace>_Events.csv and <trace>_States.csv. Usage: com.Trace.ExportCombat <file.utrace>"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		if (Args.IsEmpty())
+		{
+			UE_LOG(LogCityOfMythsEditor, Warning, TEXT("com.Trace.ExportCombat needs a .utrace path"));
+			return;
+		}
+
+		const FString TracePath = Args[0];
+
+		UE::Trace::FFileDataStream DataStream;
+		if (!DataStream.Open(*TracePath))
+		{
+			UE_LOG(LogCityOfMythsEditor, Warning, TEXT("Can't open %s"), *TracePath);
+			return;
+		}
+
+		FCombatTraceAnalyzer Analyzer;
+
+		UE::Trace::FAnalysisContext Context;
+		Context.AddAnalyzer(Analyzer);
+		Context.Process(DataStream).Wait();
+
+		const FString BasePath = FPaths::Combine(FPaths::GetPath(TracePath), FPaths::GetBaseFilename(TracePath));
+		const FString EventsPath = BasePath + TEXT("_Events.csv");
+		const FString StatesPath = BasePath + TEXT("_States.csv");
+
+		if (Analyzer.WriteEvents(EventsPath) && Analyzer.WriteStates(StatesPath))
+		{
+			UE_LOG(LogCityOfMythsEditor, Display, TEXT("%d combat events and %d state spans written to %s and %s"),
+				Analyzer.GetEventCount(), Analyzer.GetSpanCount(), *EventsPath, *StatesPath);
+		}
+		else
+		{
+			UE_LOG(LogCityOfMythsEditor, Warning, TEXT("Failed to write %s"), *BasePath);
+		}
+	}));
+
+void FCombatTraceAnalyzer::OnAnalysisBegin(const FOnAnalysisContext& Context)
+{
+	FInterfaceBuilder& Builder = Context.InterfaceBuilder;
+
+	Builder.RouteEvent(RouteId_ActorInfo, "CityOfMyths", "ActorInfo");
+	Builder.RouteEvent(RouteId_StateChange, "CityOfMyths", "StateChange");
+	Builder.RouteEvent(RouteId_Damage, "CityOfMyths", "Damage");
+	Builder.RouteEvent(RouteId_Death, "CityOfMyths", "Death");
+	Builder.RouteEvent(RouteId_AttackTurn, "CityOfMyths", "AttackTurn");
+	Builder.RouteEvent(RouteId_SkillCast, "CityOfMyths", "SkillCast");
+}
+
+bool FCombatTraceAnalyzer::OnEvent(uint16 RouteId, EStyle Style, const FOnEventContext& Context)
+{
+	const FEventData& EventData = Context.EventData;
+
+	if (RouteId == RouteId_ActorInfo)
+	{
+		FString Name;
+		EventData.GetString("Name", Name);
+		ActorNames.Add(EventData.GetValue<uint32>("ActorId"), MoveTemp(Name));
+		return true;
+	}
+
+	FEvent& Event = Events.AddDefaulted_GetRef();
+	Event.Time = Context.EventTime.AsSeconds(EventData.GetValue<uint64>("Cycle"));
+	Event.Frame = EventData.GetValue<uint32>("Frame");
+
+	LastTime = FMath::Max(LastTime, Event.Time);
+	LastFrame = FMath::Max(LastFrame, Event.Frame);
+
+	switch (RouteId)
+	{
+	case RouteId_StateChange:
+	{
+		Event.Type = TEXT("StateChange");
+		Event.ActorId = EventData.GetValue<uint32>("ActorId");
+
+		const uint8 NewState = EventData.GetValue<uint8>("NewState");
+		Event.Detail = GetStateName(EventData.GetValue<uint8>("OldState")) + TEXT(" -> ") + GetStateName(NewState);
+
+		if (const int32* Open = OpenSpans.Find(Event.ActorId))
+		{
+			Spans[*Open].End = Event.Time;
+			Spans[*Open].EndFrame = Event.Frame;
+		}
+
+		FStateSpan& Span = Spans.AddDefaulted_GetRef();
+		Span.ActorId = Event.ActorId;
+		Span.State = NewState;
+		Span.Start = Event.Time;
+		Span.StartFrame = Event.Frame;
+
+		OpenSpans.Add(Event.ActorId, Spans.Num() - 1);
+		break;
+	}
+
+	case RouteId_Damage:
+		Event.Type = TEXT("Damage");
+		Event.ActorId = EventData.GetValue<uint32>("SourceId");
+		Event.OtherId = EventData.GetValue<uint32>("TargetId");
+		Event.Detail = FString::SanitizeFloat(EventData.GetValue<float>("Amount"));
+		break;
+
+	case RouteId_Death:
+		Event.Type = TEXT("Death");
+		Event.ActorId = EventData.GetValue<uint32>("ActorId");
+		break;
+
+	case RouteId_AttackTurn:
+		Event.Type = TEXT("AttackTurn");
+		Event.ActorId = EventData.GetValue<uint32>("ActorId");
+		break;
+
+	case RouteId_SkillCast:
+		Event.Type = TEXT("SkillCast");
+		Event.ActorId = EventData.GetValue<uint32>("ActorId");
+		EventData.GetString("Skill", Event.Detail);
+		break;
+	}
+
+	return true;
+}
+
+void FCombatTraceAnalyzer::OnAnalysisEnd()
+{
+	// States still running when the trace stopped end with it
+	for (const TPair<uint32, int32>& Open : OpenSpans)
+	{
+		Spans[Open.Value].End = LastTime;
+		Spans[Open.Value].EndFrame = LastFrame;
+	}
+
+	OpenSpans.Reset();
+}
+
+bool FCombatTraceAnalyzer::WriteEvents(const FString& Path) const
+{
+	TArray<FString> Lines;
+	Lines.Reserve(Events.Num() + 1);
+	Lines.Add(TEXT("Time,Frame,Event,Actor,Target,Detail"));
+
+	for (const FEvent& Event : Events)
+	{
+		Lines.Add(FString::Printf(TEXT("%.6f,%u,%s,%s,%s,%s"), Event.Time, Event.Frame, Event.Type,
+			*GetActorName(Event.ActorId), Event.OtherId ? *GetActorName(Event.OtherId) : TEXT(""), *Event.Detail));
+	}
+
+	return FFileHelper::SaveStringArrayToFile(Lines, *Path);
+}
+
+bool FCombatTraceAnalyzer::WriteStates(const FString& Path) const
+{
+	TArray<FString> Lines;
+	Lines.Reserve(Spans.Num() + 1);
+	Lines.Add(TEXT("Actor,State,Start,End,Duration,StartFrame,EndFrame"));
+
+	for (const FStateSpan& Span : Spans)
+	{
+		Lines.Add(FString::Printf(TEXT("%s,%s,%.6f,%.6f,%.6f,%u,%u"), *GetActorName(Span.ActorId), *GetStateName(Span.State),
+			Span.Start, Span.End, Span.End - Span.Start, Span.StartFrame, Span.EndFrame));
+	}
+
+	return FFileHelper::SaveStringArrayToFile(Lines, *Path);
+}
+
+FString FCombatTraceAnalyzer::GetActorName(uint32 ActorId) const
+{
+	if (ActorId == 0)
+	{
+		return TEXT("None");
+	}
+
+	const FString* Name = ActorNames.Find(ActorId);
+	return Name ? *Name : FString::Printf(TEXT("Actor%u"), ActorId);
+}
+
+FString FCombatTraceAnalyzer::GetStateName(uint8 State)
+{
+	return StaticEnum<::State>()->GetNameStringByValue(State);
+}
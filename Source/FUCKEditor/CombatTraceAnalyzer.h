@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Analyzer.h"
+
+/**
+ * Reads the Combat channel out of a .utrace and writes two CSVs: every
+ * combat event with its time and frame, and per-enemy state spans
+ * (enemy, state, start, end). Lined up against the frame track in Insights,
+ * or plotted next to a frame time CSV, they show which fight events sat
+ * inside a hitch.
+ */
+class FCombatTraceAnalyzer : public UE::Trace::IAnalyzer
+{
+public:
+	virtual void OnAnalysisBegin(const FOnAnalysisContext& Context) override;
+	virtual bool OnEvent(uint16 RouteId, EStyle Style, const FOnEventContext& Context) override;
+	virtual void OnAnalysisEnd() override;
+
+	bool WriteEvents(const FString& Path) const;
+	bool WriteStates(const FString& Path) const;
+
+	int32 GetEventCount() const { return Events.Num(); }
+	int32 GetSpanCount() const { return Spans.Num(); }
+
+private:
+	enum : uint16
+	{
+		RouteId_ActorInfo,
+		RouteId_StateChange,
+		RouteId_Damage,
+		RouteId_Death,
+		RouteId_AttackTurn,
+		RouteId_SkillCast,
+	};
+
+	struct FEvent
+	{
+		double Time = 0.0;
+		uint32 Frame = 0;
+		const TCHAR* Type = TEXT("");
+		uint32 ActorId = 0;
+		uint32 OtherId = 0;
+		FString Detail;
+	};
+
+	struct FStateSpan
+	{
+		uint32 ActorId = 0;
+		uint8 State = 0;
+		double Start = 0.0;
+		double End = 0.0;
+		uint32 StartFrame = 0;
+		uint32 EndFrame = 0;
+	};
+
+	FString GetActorName(uint32 ActorId) const;
+	static FString GetStateName(uint8 State);
+
+	TMap<uint32, FString> ActorNames;
+	TArray<FEvent> Events;
+	TArray<FStateSpan> Spans;
+
+	// Span each actor is in right now
+	TMap<uint32, int32> OpenSpans;
+
+	double LastTime = 0.0;
+	uint32 LastFrame = 0;
+};
@@ -0,0 +1,8 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "FUCKEditor.h"
+#include "Modules/ModuleManager.h"
+
+DEFINE_LOG_CATEGORY(LogCityOfMythsEditor);
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, FUCKEditor);